@@ -0,0 +1,249 @@
+#include "corpus.h"
+
+#include <array>
+#include <string_view>
+using namespace bench::corpus;
+
+namespace impl
+{
+    // splitmix64
+    struct Random
+    {
+        std::uint64_t state;
+
+        std::uint64_t next()
+        {
+            std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            return z ^ (z >> 31);
+        }
+
+        // uniform in `[0, n)`, up to a negligible bias
+        std::size_t below(std::size_t n)
+        {
+            return static_cast<std::size_t>(next() % n);
+        }
+
+        template<class T, std::size_t N>
+        const T& pick(const std::array<T, N>& items)
+        {
+            return items[below(N)];
+        }
+    };
+
+    // variables are letters only, since the parser reads `x1` as `x * 1`
+    constexpr std::array<std::string_view, 8> VARIABLES = { "a", "b", "c", "x", "y", "z", "u", "v" };
+    constexpr std::array<std::string_view, 8> LITERALS = { "0", "1", "2", "3", "0.5", "10", "1.25", "7" };
+
+    static std::string_view leaf(Random& random)
+    {
+        return random.below(3) ? random.pick(VARIABLES) : random.pick(LITERALS);
+    }
+
+    static void mixed(Random& random, std::size_t depth, std::string& out)
+    {
+        static constexpr std::array<std::string_view, 17> BINARY =
+        {
+            " + ", " - ", " * ", " / ", " % ", " ** ",
+            " == ", " != ", " < ", " <= ", " > ", " >= ",
+            " && ", " ^^ ", " || ", " + ", " * ",
+        };
+        static constexpr std::array<std::string_view, 5> FUNCTIONS = { "min", "max", "sqrt", "abs", "-" };
+
+        if (depth == 0 || random.below(4) == 0)
+        {
+            out += leaf(random);
+            return;
+        }
+
+        if (random.below(4) == 0)
+        {
+            const std::string_view fn = random.pick(FUNCTIONS);
+            const std::size_t arity = fn == "min" || fn == "max" ? 2 + random.below(3) : 1;
+            out += fn;
+            out += '(';
+
+            for (std::size_t i = 0; i < arity; i++)
+            {
+                if (i)
+                    out += ", ";
+                mixed(random, depth - 1, out);
+            }
+            out += ')';
+            return;
+        }
+
+        const std::string_view op = random.pick(BINARY);
+        const std::size_t operands = 2 + random.below(3);
+        out += '(';
+
+        for (std::size_t i = 0; i < operands; i++)
+        {
+            if (i)
+                out += op;
+            mixed(random, depth - 1, out);
+        }
+        out += ')';
+    }
+}
+
+std::size_t Corpus::bytes() const
+{
+    std::size_t out = 0;
+
+    for (const std::string& input : inputs)
+        out += input.size();
+    return out;
+}
+
+Corpus bench::corpus::chain(std::size_t count, std::size_t depth, std::uint64_t seed)
+{
+    impl::Random random{ seed };
+    Corpus out{ "chain", {} };
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        // built inside out, each level opening a parenthesis closed after its operand
+        std::string input(depth, '(');
+        input += impl::leaf(random);
+
+        for (std::size_t level = 0; level < depth; level++)
+        {
+            input += level % 2 ? " * " : " + ";
+            input += impl::leaf(random);
+            input += ')';
+        }
+        out.inputs.push_back(std::move(input));
+    }
+    return out;
+}
+
+Corpus bench::corpus::sum(std::size_t count, std::size_t width, std::uint64_t seed)
+{
+    impl::Random random{ seed };
+    Corpus out{ "sum", {} };
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string input;
+
+        for (std::size_t term = 0; term < width; term++)
+        {
+            if (term)
+                input += " + ";
+
+            switch (random.below(3))
+            {
+            case 0:
+                input += random.pick(impl::VARIABLES);
+                break;
+            case 1:
+                input += random.pick(impl::LITERALS);
+                break;
+            default:
+                input += random.pick(impl::LITERALS);
+                input += random.pick(impl::VARIABLES);
+                break;
+            }
+        }
+        out.inputs.push_back(std::move(input));
+    }
+    return out;
+}
+
+Corpus bench::corpus::mixed(std::size_t count, std::size_t depth, std::uint64_t seed)
+{
+    impl::Random random{ seed };
+    Corpus out{ "mixed", {} };
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string input;
+        impl::mixed(random, depth, input);
+        out.inputs.push_back(std::move(input));
+    }
+    return out;
+}
+
+Corpus bench::corpus::identifiers(std::size_t count, std::size_t terms, std::size_t length, std::uint64_t seed)
+{
+    impl::Random random{ seed };
+    Corpus out{ "identifiers", {} };
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string input;
+
+        for (std::size_t term = 0; term < terms; term++)
+        {
+            if (term)
+                input += random.below(2) ? " + " : " * ";
+
+            for (std::size_t c = 0; c < length; c++)
+                input += static_cast<char>('a' + random.below(26));
+        }
+        out.inputs.push_back(std::move(input));
+    }
+    return out;
+}
+
+Corpus bench::corpus::pairs(std::size_t count, std::size_t width, std::uint64_t seed)
+{
+    impl::Random random{ seed };
+    Corpus out{ "pairs", {} };
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string input;
+        std::string name;
+
+        for (std::size_t term = 0; term < width; term++)
+        {
+            if (term)
+                input += " + ";
+
+            // a new identifier for every pair, distinct from the others by its leading letters
+            if (term % 2 == 0)
+            {
+                name.clear();
+
+                for (std::size_t n = term / 2; ; n /= 26)
+                {
+                    name += static_cast<char>('a' + n % 26);
+
+                    if (n < 26)
+                        break;
+                }
+                name += static_cast<char>('a' + random.below(26));
+            }
+            input += name;
+        }
+        out.inputs.push_back(std::move(input));
+    }
+    return out;
+}
+
+Corpus bench::corpus::shared(std::size_t count, std::size_t terms, std::size_t pool, std::size_t depth, std::uint64_t seed)
+{
+    impl::Random random{ seed };
+    Corpus out{ "shared", {} };
+    std::vector<std::string> subexpressions(pool);
+
+    for (std::string& subexpression : subexpressions)
+        impl::mixed(random, depth, subexpression);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string input = std::to_string(i);
+
+        for (std::size_t term = 0; term < terms; term++)
+        {
+            input += " + sqrt(";
+            input += subexpressions[random.below(pool)];
+            input += ')';
+        }
+        out.inputs.push_back(std::move(input));
+    }
+    return out;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// synthetic inputs of controlled shape. generated from a seed with a generator of its own rather than one of
+// `<random>`, whose distributions differ between standard libraries, so a corpus is the same on every platform
+// and results can be compared between releases
+namespace bench::corpus
+{
+    struct Corpus
+    {
+        std::string name;
+        std::vector<std::string> inputs;
+
+        // total length of the inputs
+        std::size_t bytes() const;
+    };
+
+    // binary operators nested `depth` levels deep, alternating between `+` and `*` such that nothing flattens,
+    // e.g. `((a + b) * c + d) * e`
+    Corpus chain(std::size_t count, std::size_t depth, std::uint64_t seed);
+
+    // sums of `width` terms, each a variable, a literal, or a product of both, which flatten into one call
+    Corpus sum(std::size_t count, std::size_t width, std::uint64_t seed);
+
+    // random expressions up to `depth` levels deep, of every operator and function
+    Corpus mixed(std::size_t count, std::size_t depth, std::uint64_t seed);
+
+    // sums and products of `terms` variables with identifiers `length` characters long
+    Corpus identifiers(std::size_t count, std::size_t terms, std::size_t length, std::uint64_t seed);
+
+    // sums of `width` variables in which every variable appears twice in a row, e.g. `a + a + b + b`, such that
+    // a rule pairing equal terms matches `width / 2` disjoint times in one call
+    Corpus pairs(std::size_t count, std::size_t width, std::uint64_t seed);
+
+    // sums of `terms` subexpressions drawn from a pool of `pool` random ones up to `depth` levels deep, each
+    // under a `sqrt` such that it doesn't flatten into the sum, along with a literal unique to the input. the
+    // inputs differ, but their subexpressions repeat between them
+    Corpus shared(std::size_t count, std::size_t terms, std::size_t pool, std::size_t depth, std::uint64_t seed);
+}
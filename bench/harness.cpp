@@ -0,0 +1,92 @@
+#include "harness.h"
+
+#include <cinttypes>
+using namespace bench;
+
+Harness::Harness(Options options) : _options(std::move(options))
+{
+
+}
+
+bool Harness::selected(std::string_view name) const
+{
+    return name.find(_options.filter) != std::string_view::npos;
+}
+
+const std::vector<Result>& Harness::results() const
+{
+    return _results;
+}
+
+void Harness::record
+(
+    std::string name,
+    std::size_t passes,
+    std::size_t ops,
+    std::size_t bytes,
+    std::chrono::nanoseconds elapsed,
+    engine::alloc::Counters allocated,
+    engine::CacheStats cache
+)
+{
+    const double total_ops = static_cast<double>(passes * ops);
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+
+    Result& result = _results.emplace_back();
+    result.name = std::move(name);
+    result.passes = passes;
+    result.ops = ops;
+    result.bytes = bytes;
+    result.ns_per_op = static_cast<double>(elapsed.count()) / total_ops;
+    result.allocs_per_op = static_cast<double>(allocated.count) / total_ops;
+    result.alloc_bytes_per_op = static_cast<double>(allocated.bytes) / total_ops;
+    result.peak_bytes = allocated.peak;
+    result.ops_per_second = total_ops / seconds;
+    result.bytes_per_second = static_cast<double>(passes * bytes) / seconds;
+    result.cache = cache;
+
+    // progress goes to stderr, such that stdout only holds the json
+    std::fprintf
+    (
+        stderr, "%-24s %12.1f ns/op %10.1f allocs/op %12" PRIu64 " peak bytes",
+        result.name.c_str(), result.ns_per_op, result.allocs_per_op, result.peak_bytes
+    );
+
+    // the hit rates only where the benchmark uses the caches
+    if (const std::uint64_t lookups = cache.strings.hits + cache.strings.misses)
+        std::fprintf(stderr, " %5.1f%% cache hits", 100.0 * static_cast<double>(cache.strings.hits) / static_cast<double>(lookups));
+    if (const std::uint64_t lookups = cache.subtrees.hits + cache.subtrees.misses)
+        std::fprintf(stderr, " %5.1f%% subtree hits", 100.0 * static_cast<double>(cache.subtrees.hits) / static_cast<double>(lookups));
+    std::fputc('\n', stderr);
+}
+
+void Harness::write_json(std::FILE* out) const
+{
+    // names are made up of identifiers and slashes, so nothing has to be escaped
+    std::fprintf(out, "{\n");
+    std::fprintf(out, "  \"min_time_ns\": %" PRId64 ",\n", static_cast<std::int64_t>(_options.min_time.count()));
+    std::fprintf(out, "  \"min_passes\": %zu,\n", _options.min_passes);
+    std::fprintf(out, "  \"benchmarks\": [");
+
+    for (std::size_t i = 0; i < _results.size(); i++)
+    {
+        const Result& result = _results[i];
+        std::fprintf(out, "%s\n    {\n", i ? "," : "");
+        std::fprintf(out, "      \"name\": \"%s\",\n", result.name.c_str());
+        std::fprintf(out, "      \"passes\": %zu,\n", result.passes);
+        std::fprintf(out, "      \"ops_per_pass\": %zu,\n", result.ops);
+        std::fprintf(out, "      \"bytes_per_pass\": %zu,\n", result.bytes);
+        std::fprintf(out, "      \"ns_per_op\": %.3f,\n", result.ns_per_op);
+        std::fprintf(out, "      \"allocs_per_op\": %.3f,\n", result.allocs_per_op);
+        std::fprintf(out, "      \"alloc_bytes_per_op\": %.3f,\n", result.alloc_bytes_per_op);
+        std::fprintf(out, "      \"peak_bytes\": %" PRIu64 ",\n", result.peak_bytes);
+        std::fprintf(out, "      \"ops_per_second\": %.1f,\n", result.ops_per_second);
+        std::fprintf(out, "      \"bytes_per_second\": %.1f,\n", result.bytes_per_second);
+        std::fprintf(out, "      \"cache_hits\": %" PRIu64 ",\n", result.cache.strings.hits);
+        std::fprintf(out, "      \"cache_misses\": %" PRIu64 ",\n", result.cache.strings.misses);
+        std::fprintf(out, "      \"subtree_hits\": %" PRIu64 ",\n", result.cache.subtrees.hits);
+        std::fprintf(out, "      \"subtree_misses\": %" PRIu64 "\n", result.cache.subtrees.misses);
+        std::fprintf(out, "    }");
+    }
+    std::fprintf(out, "%s]\n}\n", _results.empty() ? "" : "\n  ");
+}
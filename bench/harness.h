@@ -0,0 +1,141 @@
+#pragma once
+#include "engine/alloc.h"
+#include "engine/engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// times operations over a corpus, see `corpus.h`. each benchmark runs passes over its corpus until a minimum
+// time has elapsed, and reports the time and allocations per operation along with the throughput
+namespace bench
+{
+    struct Options
+    {
+        // minimum time spent in the timed part of the passes of each benchmark
+        std::chrono::nanoseconds min_time = std::chrono::milliseconds(200);
+
+        // minimum number of passes of each benchmark
+        std::size_t min_passes = 3;
+
+        // only benchmarks whose name contains this are run
+        std::string filter;
+    };
+
+    struct Result
+    {
+        // `<benchmark>/<corpus>`, e.g. `parse/chain`
+        std::string name;
+        std::size_t passes = 0;
+        // operations per pass
+        std::size_t ops = 0;
+        // bytes of input per pass
+        std::size_t bytes = 0;
+        double ns_per_op = 0.0;
+        double allocs_per_op = 0.0;
+        double alloc_bytes_per_op = 0.0;
+        // most bytes live at once during any pass, see `engine::alloc::Counters::peak`
+        std::uint64_t peak_bytes = 0;
+        double ops_per_second = 0.0;
+        double bytes_per_second = 0.0;
+        // lookups of the cache of the engine during the timed part of the passes, see `engine::cache_stats`.
+        // zero unless the benchmark enables it
+        engine::CacheStats cache;
+    };
+
+#if !defined(__GNUC__)
+    // written by `keep` where there's no inline assembly to escape a value with
+    inline const void* volatile sink = nullptr;
+#endif
+
+    // keeps the compiler from optimizing away the computation of a value. the value escapes into an empty asm
+    // statement which may read any memory, such that the compiler has to assume it is used
+    template<class T>
+    void keep(const T& value)
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "r"(&value) : "memory");
+#else
+        sink = &value;
+#endif
+    }
+
+    struct Harness
+    {
+        explicit Harness(Options options);
+
+        // whether a benchmark is selected by the filter
+        bool selected(std::string_view name) const;
+
+        // runs a benchmark performing `ops` operations over `bytes` bytes of input per pass. `setup` prepares
+        // each pass, e.g. by copying inputs the pass consumes, and is neither timed nor counted
+        template<class Setup, class Pass>
+        void run(std::string name, std::size_t ops, std::size_t bytes, Setup&& setup, Pass&& pass)
+        {
+            if (!selected(name))
+                return;
+
+            using Clock = std::chrono::steady_clock;
+            Clock::duration elapsed{};
+            engine::alloc::Counters allocated;
+            engine::CacheStats cache;
+            std::size_t passes = 0;
+
+            while (passes < _options.min_passes || elapsed < _options.min_time)
+            {
+                setup();
+                const engine::CacheStats before = engine::cache_stats();
+
+                const engine::alloc::Scope scope;
+                const Clock::time_point start = Clock::now();
+                pass();
+                const Clock::time_point end = Clock::now();
+                const engine::alloc::Counters counters = scope.read();
+                const engine::CacheStats after = engine::cache_stats();
+
+                elapsed += end - start;
+                allocated.count += counters.count;
+                allocated.bytes += counters.bytes;
+                allocated.peak = std::max(allocated.peak, counters.peak);
+                cache.strings.hits += after.strings.hits - before.strings.hits;
+                cache.strings.misses += after.strings.misses - before.strings.misses;
+                cache.subtrees.hits += after.subtrees.hits - before.subtrees.hits;
+                cache.subtrees.misses += after.subtrees.misses - before.subtrees.misses;
+                passes++;
+            }
+            record(std::move(name), passes, ops, bytes, elapsed, allocated, cache);
+        }
+
+        // same as above, for passes which need no setup
+        template<class Pass>
+        void run(std::string name, std::size_t ops, std::size_t bytes, Pass&& pass)
+        {
+            run(std::move(name), ops, bytes, [] {}, pass);
+        }
+
+        const std::vector<Result>& results() const;
+
+        // writes the results as a json object, along with the options they were measured with
+        void write_json(std::FILE* out) const;
+
+    private:
+        void record
+        (
+            std::string name,
+            std::size_t passes,
+            std::size_t ops,
+            std::size_t bytes,
+            std::chrono::nanoseconds elapsed,
+            engine::alloc::Counters allocated,
+            engine::CacheStats cache
+        );
+
+        Options _options;
+        std::vector<Result> _results;
+    };
+}
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "corpus.h"
+#include "harness.h"
+#include "ast/binary.h"
+#include "engine/engine.h"
+#include "engine/match.h"
+#include "engine/rewrite.h"
+#include "engine/snapshot.h"
+#include "engine/source.h"
+#include "eval/batch.h"
+#include "eval/program.h"
+#include "parser/lexer.h"
+#include "parser/parser.h"
+using namespace ast::prelude;
+
+namespace impl
+{
+    constexpr const char* USAGE =
+        "usage: biss_bench [--filter <text>] [--min-time <ms>]\n"
+        "\n"
+        "       runs the benchmarks whose name contains the text (default: all), each for at least the given\n"
+        "       time (default: 200), and writes the results to stdout as json\n";
+
+    // common identities, which the corpora match now and then
+    constexpr std::string_view RULES =
+        "$0 * 1 -> $0\n"
+        "$0 + 0 -> $0\n"
+        "$0 * 0 -> 0\n"
+        "$0 - $0 -> 0\n"
+        "$0 / $0 -> 1\n"
+        "$0 ** 1 -> $0\n"
+        "$0 + $0 -> 2 * $0\n"
+        "#0 * $1 + #2 * $1 -> (#0 + #2) * $1\n"
+        "-(-($0)) -> $0\n"
+        "abs(-($0)) -> abs($0)\n"
+        "max($0, $0) -> $0\n"
+        "min($0, $0) -> $0\n";
+
+    // every node of an expression, in pre-order
+    static void nodes(const Ast& ast, std::vector<const Ast*>& out)
+    {
+        std::vector<const Ast*> stack{ &ast };
+
+        while (!stack.empty())
+        {
+            const Ast* node = stack.back();
+            stack.pop_back();
+            out.push_back(node);
+
+            if (node->has<Call>())
+            {
+                const std::vector<Ast>& args = node->get<Call>().args;
+
+                for (auto it = args.rbegin(); it != args.rend(); ++it)
+                    stack.push_back(&*it);
+            }
+        }
+    }
+
+    // placeholders for the outputs of a pass, such that they are destroyed outside of the timed part
+    static void reset(std::vector<Ast>& outputs, std::size_t count)
+    {
+        outputs.clear();
+
+        for (std::size_t i = 0; i < count; i++)
+            outputs.emplace_back(Literal{ 0.0 });
+    }
+
+    static void copy(const std::vector<Ast>& from, std::vector<Ast>& to)
+    {
+        to.clear();
+
+        for (const Ast& ast : from)
+            to.push_back(ast.copy());
+    }
+
+    static void run(bench::Harness& harness, const bench::corpus::Corpus& corpus, std::span<const engine::rule::Rule> rules, const engine::table::View& table)
+    {
+        const std::vector<std::string>& inputs = corpus.inputs;
+        const std::size_t count = inputs.size();
+        const std::size_t bytes = corpus.bytes();
+        const auto name = [&](std::string_view benchmark) { return std::string(benchmark) + "/" + corpus.name; };
+
+        std::vector<Ast> parsed;
+        std::vector<Ast> normalized;
+
+        for (const std::string& input : inputs)
+        {
+            parsed.push_back(parser::parse(input));
+            normalized.push_back(engine::evaluate_expr(parsed.back().copy()));
+        }
+
+        std::vector<Ast> consumed;
+        std::vector<Ast> outputs;
+
+        harness.run(name("lex"), count, bytes, [&]
+        {
+            for (const std::string& input : inputs)
+            {
+                parser::Lexer lexer(input);
+
+                while (!lexer.peek().has<parser::EOL>())
+                    lexer.discard();
+                bench::keep(lexer);
+            }
+        });
+
+        harness.run(name("parse"), count, bytes, [&] { reset(outputs, count); }, [&]
+        {
+            for (std::size_t i = 0; i < count; i++)
+                outputs[i] = parser::parse(inputs[i]);
+        });
+
+        // the same expressions decoded from the binary format rather than parsed from text, and again once
+        // normalized, as a cache of results would store them, in which sums and products are single wide calls
+        ast::binary::Encoder encoder;
+        ast::binary::Encoder normalized_encoder;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            encoder.add(parsed[i]);
+            normalized_encoder.add(normalized[i]);
+        }
+
+        const std::vector<std::byte> encoded = encoder.finish();
+        const std::vector<std::byte> normalized_encoded = normalized_encoder.finish();
+        std::vector<Ast> stack;
+
+        harness.run(name("load"), count, bytes, [&] { reset(outputs, count); }, [&]
+        {
+            ast::binary::Reader reader(encoded);
+
+            for (std::size_t i = 0; i < count; i++)
+                outputs[i] = reader.read()->load(stack);
+        });
+
+        harness.run(name("load_normalized"), count, bytes, [&] { reset(outputs, count); }, [&]
+        {
+            ast::binary::Reader reader(normalized_encoded);
+
+            for (std::size_t i = 0; i < count; i++)
+                outputs[i] = reader.read()->load(stack);
+        });
+
+        // flattening, folding and sorting, without rules or memoization
+        harness.run(name("normalize"), count, bytes, [&] { copy(parsed, consumed); reset(outputs, count); }, [&]
+        {
+            for (std::size_t i = 0; i < count; i++)
+                outputs[i] = engine::evaluate_expr(std::move(consumed[i]));
+        });
+
+        // the whole pipeline from source, as the cli evaluates each line
+        harness.run(name("evaluate"), count, bytes, [&] { reset(outputs, count); }, [&]
+        {
+            for (std::size_t i = 0; i < count; i++)
+                outputs[i] = engine::evaluate_str(inputs[i]);
+        });
+
+        // compiled once, then run with bindings which change on every pass, without allocating
+        std::vector<eval::Program> programs;
+        std::size_t variable_count = 0;
+
+        for (const Ast& ast : normalized)
+        {
+            programs.push_back(eval::compile(ast));
+            variable_count = std::max(variable_count, programs.back().variables().size());
+        }
+
+        std::vector<double> bindings(variable_count);
+        double shift = 0.0;
+
+        harness.run(name("program"), count, bytes, [&] { shift += 1.0; }, [&]
+        {
+            for (const eval::Program& program : programs)
+            {
+                const std::size_t n = program.variables().size();
+
+                for (std::size_t i = 0; i < n; i++)
+                    bindings[i] = shift + static_cast<double>(i);
+                bench::keep(program.run(std::span(bindings).first(n)));
+            }
+        });
+
+        // the same programs run over columns of rows by each instruction set available
+        constexpr std::size_t ROWS = 1024;
+        std::vector<std::vector<double>> data(variable_count, std::vector<double>(ROWS));
+        std::vector<std::span<const double>> columns;
+        std::vector<double> results(ROWS);
+
+        for (std::size_t j = 0; j < variable_count; j++)
+        {
+            for (std::size_t i = 0; i < ROWS; i++)
+                data[j][i] = static_cast<double>((i * 7 + j * 3) % 23) * 0.25 - 2.0;
+            columns.emplace_back(data[j]);
+        }
+
+        for (const eval::batch::Isa isa : { eval::batch::Isa::SCALAR, eval::batch::Isa::SSE2, eval::batch::Isa::AVX2 })
+        {
+            if (!eval::batch::supported(isa))
+                continue;
+
+            harness.run(name("batch_" + std::string(eval::batch::to_string(isa))), count * ROWS, bytes, [&]
+            {
+                for (const eval::Program& program : programs)
+                {
+                    eval::batch::run(program, std::span(columns).first(program.variables().size()), results, isa);
+                    bench::keep(results);
+                }
+            });
+        }
+
+        std::vector<std::string> strings(count);
+
+        harness.run(name("to_string"), count, bytes, [&] { strings.assign(count, {}); }, [&]
+        {
+            for (std::size_t i = 0; i < count; i++)
+                strings[i] = parsed[i].to_string();
+        });
+
+        // equal trees, which have to be compared in full
+        copy(parsed, consumed);
+
+        harness.run(name("equal"), count, bytes, [&]
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const bool equal = parsed[i] == consumed[i];
+                bench::keep(equal);
+            }
+        });
+
+        harness.run(name("copy"), count, bytes, [&] { reset(outputs, count); }, [&]
+        {
+            for (std::size_t i = 0; i < count; i++)
+                outputs[i] = parsed[i].copy();
+        });
+
+        // every rule that could apply, according to the index, matched against every node
+        std::vector<const Ast*> targets;
+
+        for (const Ast& ast : normalized)
+            nodes(ast, targets);
+
+        harness.run(name("match"), targets.size(), bytes, [&]
+        {
+            std::vector<std::uint32_t> candidates;
+
+            for (const Ast* target : targets)
+            {
+                candidates.clear();
+                table.candidates(*target, candidates);
+
+                for (const std::uint32_t i : candidates)
+                {
+                    const auto match = engine::match::match(table.program(i), *target, table.pivot_order(i));
+                    bench::keep(match);
+                }
+            }
+        });
+
+        harness.run(name("rewrite"), count, bytes, [&] { copy(normalized, consumed); }, [&]
+        {
+            for (Ast& ast : consumed)
+                engine::rewrite::innermost(ast, table);
+        });
+
+        // the whole pipeline with the rules, as the cli evaluates each line given a rule file, and again with
+        // caches large enough for every input and subexpression, emptied before every pass such that only the
+        // inputs and subexpressions repeated within the corpus hit
+        engine::configure_rules(&table);
+
+        harness.run(name("simplify"), count, bytes, [&] { reset(outputs, count); }, [&]
+        {
+            for (std::size_t i = 0; i < count; i++)
+                outputs[i] = engine::evaluate_str(inputs[i]);
+        });
+
+        harness.run(name("simplify_cached"), count, bytes, [&]
+        {
+            engine::configure_cache({ .strings = count, .subtrees = count * 16 });
+            reset(outputs, count);
+        },
+        [&]
+        {
+            for (std::size_t i = 0; i < count; i++)
+                outputs[i] = engine::evaluate_str(inputs[i]);
+        });
+
+        engine::configure_cache({});
+        engine::configure_rules(nullptr);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (arg == "--filter" && has_value)
+        {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--min-time" && has_value)
+        {
+            const std::string_view value = argv[++i];
+            std::size_t ms = 0;
+            const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), ms);
+
+            if (ec != std::errc() || ptr != value.data() + value.size())
+            {
+                std::fputs(impl::USAGE, stderr);
+                return 1;
+            }
+            options.min_time = std::chrono::milliseconds(ms);
+        }
+        else
+        {
+            std::fputs(impl::USAGE, stderr);
+            return 1;
+        }
+    }
+
+    // the rules compiled into a table the way the cli loads a rule file
+    const std::vector<engine::rule::Rule> rules = engine::rule::parse_file(impl::RULES);
+    const std::vector<std::byte> compiled = engine::snapshot::write(rules, 0);
+    const engine::snapshot::Snapshot table(compiled);
+    bench::Harness harness(options);
+
+    // fixed seeds, such that every run measures the same inputs
+    const bench::corpus::Corpus corpora[] =
+    {
+        bench::corpus::chain(16, 2000, 1),
+        bench::corpus::sum(64, 1000, 2),
+        bench::corpus::mixed(2000, 6, 3),
+        bench::corpus::identifiers(256, 64, 48, 4),
+        bench::corpus::pairs(4, 2000, 5),
+        bench::corpus::shared(2000, 8, 64, 4, 6),
+    };
+
+    for (const bench::corpus::Corpus& corpus : corpora)
+        impl::run(harness, corpus, rules, table.view());
+
+    harness.write_json(stdout);
+    return 0;
+}
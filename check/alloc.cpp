@@ -0,0 +1,56 @@
+#include <format>
+#include <vector>
+
+#include "check.h"
+#include "engine/alloc.h"
+
+namespace impl
+{
+    // keeps the blocks below observable, such that the compiler cannot elide their allocation
+    static void* volatile sink = nullptr;
+
+    static void allocate(std::size_t ints)
+    {
+        std::vector<int> block(ints);
+        sink = block.data();
+    }
+}
+
+// every allocation of the calling thread is counted, and nested scopes measure their own peak without lowering
+// that of the scope around them
+void check::alloc()
+{
+    // the messages of the expectations allocate, so every count is read before any is checked
+    engine::alloc::Counters single;
+    {
+        const engine::alloc::Scope scope;
+        impl::allocate(4);
+        single = scope.read();
+    }
+
+    engine::alloc::Counters outer;
+    engine::alloc::Counters inner;
+    {
+        const engine::alloc::Scope outer_scope;
+        impl::allocate(1000);
+        {
+            const engine::alloc::Scope inner_scope;
+            impl::allocate(4);
+            inner = inner_scope.read();
+        }
+        outer = outer_scope.read();
+    }
+
+    check::expect(engine::alloc::counting(), "the allocation hooks to be linked in");
+
+    check::expect(single.count == 1, std::format("a `std::vector<int>(4)` to allocate once, got {}", single.count));
+    check::expect(single.bytes == 4 * sizeof(int), std::format("a `std::vector<int>(4)` to allocate {} bytes, got {}", 4 * sizeof(int), single.bytes));
+    check::expect(single.peak == 4 * sizeof(int), std::format("a `std::vector<int>(4)` to peak at {} bytes, got {}", 4 * sizeof(int), single.peak));
+
+    check::expect(inner.count == 1, std::format("a nested scope to count only its own allocations, got {}", inner.count));
+    check::expect(inner.peak == 4 * sizeof(int), std::format("a nested scope to peak at {} bytes, got {}", 4 * sizeof(int), inner.peak));
+
+    check::expect(outer.count == 2, std::format("a scope to count the allocations of the scopes nested in it, got {}", outer.count));
+    check::expect(outer.bytes == 1004 * sizeof(int), std::format("a scope to count {} bytes, got {}", 1004 * sizeof(int), outer.bytes));
+    check::expect(outer.peak == 1000 * sizeof(int), std::format("a scope to keep its peak of {} bytes past a nested scope, got {}", 1000 * sizeof(int), outer.peak));
+}
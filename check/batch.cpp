@@ -0,0 +1,81 @@
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "check.h"
+#include "eval/batch.h"
+#include "eval/program.h"
+#include "parser/parser.h"
+
+namespace impl
+{
+    // every operation, along with division by zero, roots of negative values and comparisons of equal values
+    constexpr std::string_view EXPRESSIONS[] =
+    {
+        "x + y * 2 - z / 3",
+        "x / y % z - y % 1.5",
+        "x ** 2 - y ** z + -z",
+        "sqrt(x) + abs(y) * min(x, y, z) - max(y, 0.5)",
+        "(x < y) + (y <= z) * 2 + (x > z) * 4 + (y >= 1) * 8 + (x == y) * 16 + (x != z) * 32",
+        "!x && y || z ^^ (x - y)",
+    };
+
+    // one block of rows and a tail shorter than any vector
+    constexpr std::size_t ROWS = 512 + 13;
+
+    // results are expected to be bitwise identical, but a NaN may differ in its payload
+    static bool same(double a, double b)
+    {
+        return std::bit_cast<std::uint64_t>(a) == std::bit_cast<std::uint64_t>(b) || (std::isnan(a) && std::isnan(b));
+    }
+}
+
+// every instruction set computes the same column as `Program::run` does row by row
+void check::batch()
+{
+    for (const std::string_view source : impl::EXPRESSIONS)
+    {
+        const eval::Program program = eval::compile(parser::parse(source));
+        const std::size_t variable_count = program.variables().size();
+
+        std::vector<std::vector<double>> data(variable_count, std::vector<double>(impl::ROWS));
+        std::vector<std::span<const double>> columns;
+
+        for (std::size_t j = 0; j < variable_count; j++)
+        {
+            for (std::size_t i = 0; i < impl::ROWS; i++)
+                data[j][i] = static_cast<double>((i * 7 + j * 3) % 11) * 0.5 - 2.0;
+            columns.emplace_back(data[j]);
+        }
+
+        std::vector<double> expected(impl::ROWS);
+        std::vector<double> values(variable_count);
+
+        for (std::size_t i = 0; i < impl::ROWS; i++)
+        {
+            for (std::size_t j = 0; j < variable_count; j++)
+                values[j] = data[j][i];
+            expected[i] = program.run(values);
+        }
+
+        for (const eval::batch::Isa isa : { eval::batch::Isa::SCALAR, eval::batch::Isa::SSE2, eval::batch::Isa::AVX2 })
+        {
+            if (!eval::batch::supported(isa))
+                continue;
+
+            std::vector<double> out(impl::ROWS);
+            eval::batch::run(program, columns, out, isa);
+
+            std::size_t mismatches = 0;
+
+            for (std::size_t i = 0; i < impl::ROWS; i++)
+                mismatches += !impl::same(out[i], expected[i]);
+
+            check::expect(mismatches == 0, std::format("{} to evaluate `{}` like Program::run, but {} rows differ", eval::batch::to_string(isa), source, mismatches));
+        }
+    }
+}
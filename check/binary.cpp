@@ -0,0 +1,85 @@
+#include <cstddef>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.h"
+#include "ast/binary.h"
+#include "parser/parser.h"
+
+namespace impl
+{
+    // every kind of node; small integers and other literals, shared and distinct variables, routines, prefix
+    // operators and flattened calls
+    constexpr std::string_view EXPRESSIONS[] =
+    {
+        "0",
+        "-1.5 + 3",
+        "x * y - x / 1e300",
+        "sqrt(x) + max(a, b, c, 4) ** -z",
+        "1 < x < 3 && !(y == 2)",
+    };
+
+    // the encoded file of a single expression, whose last byte is the number of arguments of its root call
+    static std::vector<std::byte> with_arity(std::string_view source, std::size_t arity)
+    {
+        ast::binary::Encoder encoder;
+        encoder.add(parser::parse(source));
+        std::vector<std::byte> out = encoder.finish();
+        out.back() = static_cast<std::byte>(arity);
+        return out;
+    }
+
+    static bool rejected(const std::vector<std::byte>& data)
+    {
+        try
+        {
+            ast::binary::Reader reader(data);
+            reader.read()->load();
+            return false;
+        }
+        catch (const ast::binary::Error&)
+        {
+            return true;
+        }
+    }
+}
+
+// expressions decode to what was encoded, and calls with a number of arguments their function doesn't accept
+// are rejected
+void check::binary()
+{
+    ast::binary::Encoder encoder;
+    std::vector<std::string> expected;
+
+    for (const std::string_view source : impl::EXPRESSIONS)
+    {
+        const ast::Ast ast = parser::parse(source);
+        encoder.add(ast);
+        expected.push_back(ast.to_string());
+    }
+
+    const std::vector<std::byte> data = encoder.finish();
+    ast::binary::Reader reader(data);
+    check::expect(reader.size() == expected.size(), std::format("{} expressions to be read back", expected.size()));
+
+    for (const std::string& source : expected)
+    {
+        std::optional<ast::binary::Expression> expression = reader.read();
+        check::expect(expression.has_value(), std::format("`{}` to be read back", source));
+
+        if (expression)
+        {
+            const std::string decoded = expression->load().to_string();
+            check::expect(decoded == source, std::format("`{}` to decode as itself, got `{}`", source, decoded));
+        }
+    }
+    check::expect(!reader.read(), "nothing after the last expression");
+
+    check::expect(!impl::rejected(impl::with_arity("sqrt(x)", 1)), "`sqrt` with 1 argument to be accepted");
+    check::expect(impl::rejected(impl::with_arity("sqrt(x)", 0)), "`sqrt` with 0 arguments to be rejected");
+    check::expect(impl::rejected(impl::with_arity("sqrt(x)", 3)), "`sqrt` with 3 arguments to be rejected");
+    check::expect(impl::rejected(impl::with_arity("x + y", 1)), "`+` with 1 argument to be rejected");
+    check::expect(!impl::rejected(impl::with_arity("max(x, y, z)", 3)), "`max` with 3 arguments to be accepted");
+}
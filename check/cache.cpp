@@ -0,0 +1,101 @@
+#include <format>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "engine/cache.h"
+#include "engine/engine.h"
+#include "engine/rewrite.h"
+#include "engine/rule.h"
+#include "engine/snapshot.h"
+#include "engine/source.h"
+#include "parser/parser.h"
+using namespace ast::prelude;
+
+// the shards of a cache hold the capacity asked for, count hits, misses and evictions, and evict by CLOCK; the
+// memo of subexpressions of the engine gives the same results as evaluating without it
+void check::cache()
+{
+    {
+        engine::cache::Cache<int, int> cache(100);
+        check::expect(cache.capacity() == 100, std::format("a cache of 100 entries to hold 100, not {}", cache.capacity()));
+        check::expect(engine::cache::Cache<int, int>(3).capacity() == 3, "a cache with fewer entries than shards to hold them all");
+
+        check::expect(!cache.find(1), "an empty cache to miss");
+        cache.insert(1, 10);
+        const auto hit = cache.find(1);
+        check::expect(hit && *hit == 10, "an inserted entry to be found");
+
+        const engine::cache::Stats stats = cache.stats();
+        check::expect(stats.hits == 1 && stats.misses == 1 && stats.evictions == 0 && stats.size == 1,
+            std::format("1 hit, 1 miss and 1 entry, not {}, {} and {}", stats.hits, stats.misses, stats.size));
+    }
+
+    // the hand passes over the entry found since it was inserted, clearing its reference, and evicts the next
+    {
+        engine::cache::Cache<int, int> cache(2, 1);
+        cache.insert(1, 10);
+        cache.insert(2, 20);
+        cache.find(1);
+        cache.insert(3, 30);
+
+        check::expect(cache.find(1) && cache.find(3), "the referenced and the newest entry to be kept");
+        check::expect(!cache.find(2), "the unreferenced entry to be evicted");
+
+        const engine::cache::Stats stats = cache.stats();
+        check::expect(stats.evictions == 1 && stats.size == 2, std::format("1 eviction and 2 entries, not {} and {}", stats.evictions, stats.size));
+    }
+
+    // literals merely close to each other are different keys, since their normal forms may differ
+    {
+        const Ast a = parser::parse("x + 1");
+        const Ast b = parser::parse("x + 1.0000000000001");
+        check::expect(a == b, "literals within epsilon to compare equal");
+        check::expect(!engine::rewrite::SubtreeEqual::identical(a, b), "literals within epsilon to be different keys");
+        check::expect(engine::rewrite::SubtreeEqual::identical(a, a.copy()), "a copy to be the same key");
+    }
+
+    // the subexpressions repeated between inputs which differ are found in the memo, including ones which the
+    // rules rewrite and ones which are in normal form as they are. only the outermost subexpressions of an input
+    // are memoized, but every one is looked up: the first pass finds the first two inputs within each of the
+    // others, and the second pass finds every input whole
+    {
+        const std::vector<std::byte> compiled = engine::snapshot::write(engine::rule::parse_file("$0 * 1 -> $0\n$0 + 0 -> $0\n$0 - $0 -> 0\n"), 0);
+        const engine::snapshot::Snapshot rules{ compiled };
+        engine::configure_rules(&rules.view());
+
+        const std::vector<std::string> inputs =
+        {
+            "sqrt(x * 1 + (y - y) + z)",
+            "abs(a * b * c)",
+            "1 + sqrt(x * 1 + (y - y) + z) * abs(a * b * c)",
+            "2 + sqrt(x * 1 + (y - y) + z) * abs(a * b * c)",
+            "3 + abs(a * b * c) - sqrt(x * 1 + (y - y) + z)",
+        };
+        std::vector<std::string> expected;
+
+        for (const std::string& input : inputs)
+            expected.push_back(engine::evaluate_str(input).to_string());
+
+        engine::configure_cache({ .subtrees = 64 });
+
+        for (std::size_t pass = 0; pass < 2; pass++)
+        {
+            for (std::size_t i = 0; i < inputs.size(); i++)
+            {
+                const std::string out = engine::evaluate_str(inputs[i]).to_string();
+                check::expect(out == expected[i], std::format("`{}` to simplify to `{}` with the memo, not `{}`", inputs[i], expected[i], out));
+            }
+        }
+
+        const engine::cache::Stats stats = engine::cache_stats().subtrees;
+        check::expect(stats.hits == 11, std::format("the repeated subexpressions to hit the memo 11 times, not {}", stats.hits));
+        check::expect(stats.size > 0 && stats.evictions == 0, std::format("the memo to hold entries without evicting any, not {} and {}", stats.size, stats.evictions));
+
+        engine::configure_rules(&rules.view());
+        check::expect(engine::cache_stats().subtrees.size == 0, "replacing the rules to empty the memo");
+
+        engine::configure_cache({});
+        engine::configure_rules(nullptr);
+    }
+}
@@ -0,0 +1,109 @@
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.h"
+#include "ast/canonical.h"
+#include "parser/parser.h"
+using namespace ast::prelude;
+
+namespace impl
+{
+    // the function of a binary operator
+    static const function::Function* function_of(std::string_view op)
+    {
+        return parser::parse(std::format("a {} b", op)).get<Call>().fn;
+    }
+
+    static Ast var(std::string_view identifier)
+    {
+        return Variable{ std::string(identifier) };
+    }
+}
+
+// the hash is invariant under the permutations `sort_arguments` applies and no others, agrees with
+// `ast::operator==` on expressions whose literals are exact, and is shared by an expression and its canonical form
+void check::canonical()
+{
+    using ast::canonical::hash;
+    const function::Function* add = impl::function_of("+");
+    const function::Function* sub = impl::function_of("-");
+
+    // flattened as `engine::evaluate_expr` does, but not sorted
+    {
+        const Ast abc(Call(add, impl::var("a"), impl::var("b"), impl::var("c")));
+        const Ast cab(Call(add, impl::var("c"), impl::var("a"), impl::var("b")));
+        check::expect(hash(abc) == hash(cab), "`a + b + c` and `c + a + b` to hash the same");
+
+        // subtraction only commutes in its tail
+        const Ast xab(Call(sub, impl::var("x"), impl::var("a"), impl::var("b")));
+        const Ast xba(Call(sub, impl::var("x"), impl::var("b"), impl::var("a")));
+        const Ast axb(Call(sub, impl::var("a"), impl::var("x"), impl::var("b")));
+        check::expect(hash(xab) == hash(xba), "`x - a - b` and `x - b - a` to hash the same");
+        check::expect(hash(xab) != hash(axb), "`x - a - b` and `a - x - b` to hash apart");
+        check::expect(hash(parser::parse("a - b")) != hash(parser::parse("b - a")), "`a - b` and `b - a` to hash apart");
+    }
+
+    // zeroes of either sign are equal, and so hash the same, as do NaNs, which are equal to nothing but are
+    // interchangeable once sorted
+    {
+        check::expect(Ast(Literal{ -0.0 }) == Ast(Literal{ 0.0 }), "zeroes of either sign to compare equal");
+        check::expect(hash(Ast(Literal{ -0.0 })) == hash(Ast(Literal{ 0.0 })), "zeroes of either sign to hash the same");
+
+        const function::Function* mul = impl::function_of("*");
+        const Ast negative(Call(mul, impl::var("x"), Literal{ -0.0 }));
+        const Ast positive(Call(mul, impl::var("x"), Literal{ 0.0 }));
+        check::expect(hash(negative) == hash(positive), "`x * -0` and `x * 0` to hash the same");
+
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        check::expect(ast::canonical::hash_literal(nan) == ast::canonical::hash_literal(-nan), "NaNs of either sign to hash the same");
+    }
+
+    // pairwise over expressions which are each other's permutations, or differ slightly: canonical forms which
+    // compare equal hash the same, and the others hash apart. literals merely within epsilon of each other
+    // compare equal but hash apart, which is why the literals here are exact
+    {
+        constexpr std::string_view EXPRESSIONS[] =
+        {
+            "a + b * c",
+            "c * b + a",
+            "b * c + a",
+            "a + b * d",
+            "a * b + c",
+            "max(x, y, 2)",
+            "max(2, y, x)",
+            "min(x, y, 2)",
+            "sqrt(x - y) / 2",
+            "sqrt(y - x) / 2",
+            "2 / sqrt(x - y)",
+            "x == y && y < 3",
+            "y < 3 && y == x",
+            "0.5 + x",
+            "x + 0.25",
+        };
+        std::vector<Ast> canonical;
+        std::vector<std::uint64_t> hashes;
+
+        for (const std::string_view expression : EXPRESSIONS)
+        {
+            Ast parsed = parser::parse(expression);
+            hashes.push_back(hash(parsed));
+            canonical.push_back(ast::canonical::canonicalize(std::move(parsed)));
+
+            check::expect(hash(canonical.back()) == hashes.back(), std::format("`{}` to hash the same as its canonical form", expression));
+        }
+
+        for (std::size_t i = 0; i < canonical.size(); i++)
+        {
+            for (std::size_t j = i + 1; j < canonical.size(); j++)
+            {
+                const bool equal = canonical[i] == canonical[j];
+                check::expect(equal == (hashes[i] == hashes[j]), std::format("`{}` and `{}` to {}", EXPRESSIONS[i], EXPRESSIONS[j],
+                    equal ? "hash the same, since they compare equal" : "hash apart, since they compare unequal"));
+            }
+        }
+    }
+}
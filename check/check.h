@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <source_location>
+#include <string_view>
+
+// checks of behaviour which depends on the machine running it, or which is too involved to verify with
+// `static_assert`. every failed expectation is reported to stderr, and `biss_check` fails if there was any
+namespace check
+{
+    // records a failure unless the condition holds
+    void expect(bool condition, std::string_view what, std::source_location location = std::source_location::current());
+
+    // number of failures recorded so far
+    std::size_t failures();
+
+    // the checks of each module, see the file of the same name
+    void alloc();
+    void batch();
+    void binary();
+    void cache();
+    void canonical();
+    void decimal();
+    void match();
+    void program();
+    void snapshot();
+    void store();
+}
@@ -0,0 +1,67 @@
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "parser/decimal.h"
+
+namespace impl
+{
+    static std::vector<std::string> literals()
+    {
+        std::vector<std::string> out =
+        {
+            "0", "0.0", ".5", "5.", "0.1", "123456789012345678901234", "0.1000000000000000000001",
+            // ties between two doubles, broken to even, and values just past a tie
+            "9007199254740993", "9007199254740995", "9007199254740993.0000000000000000000001",
+            "0.500000000000000166533453693773481063544750213623046875",
+            // largest double, and values which overflow or are subnormal
+            "179769313486231570814527423731704356798070567525844996598917476803157260780028538760589558632766878171540458953514382464234321326889464182768467546703537516986049910576551282076245490090389328944075868508455133942304583236903222948165808559332123348274797826204144723168738177180919299881250404026184124858368",
+            std::string(400, '9'),
+            "0." + std::string(307, '0') + "22250738585072014",
+            "0." + std::string(322, '0') + "49406564584124654",
+            "0." + std::string(323, '0') + "2470328229206232720882",
+            "0." + std::string(400, '0') + "1",
+        };
+
+        // random literals of up to 40 digits
+        std::mt19937_64 random(1);
+
+        for (std::size_t i = 0; i < 2000; i++)
+        {
+            const std::size_t length = 1 + random() % 40;
+            std::string literal;
+
+            for (std::size_t j = 0; j < length; j++)
+                literal += static_cast<char>('0' + random() % 10);
+            if (random() % 4)
+                literal.insert(random() % (length + 1), ".");
+            out.push_back(std::move(literal));
+        }
+        return out;
+    }
+}
+
+// literals parsed during constant evaluation round like `std::from_chars` does at runtime
+void check::decimal()
+{
+    for (const std::string& literal : impl::literals())
+    {
+        double expected = 0.0;
+        const auto [ptr, ec] = std::from_chars(literal.data(), literal.data() + literal.size(), expected, std::chars_format::fixed);
+        const std::optional<double> parsed = parser::decimal::parse(literal);
+
+        if (ec == std::errc::result_out_of_range)
+        {
+            check::expect(!parsed, std::format("`{}` to be out of range", literal));
+            continue;
+        }
+
+        const bool same = parsed && std::bit_cast<std::uint64_t>(*parsed) == std::bit_cast<std::uint64_t>(expected);
+        check::expect(same, std::format("`{}` to parse as {}, got {}", literal, expected, parsed.value_or(-1.0)));
+    }
+}
@@ -0,0 +1,63 @@
+#include <cstdio>
+#include <exception>
+
+#include "check.h"
+
+namespace impl
+{
+    static std::size_t failures = 0;
+
+    // the checks of each module, run one after another such that a throwing check does not skip the others
+    constexpr struct
+    {
+        const char* name;
+        void (*run)();
+    }
+    CHECKS[] =
+    {
+        { "alloc", check::alloc },
+        { "batch", check::batch },
+        { "binary", check::binary },
+        { "cache", check::cache },
+        { "canonical", check::canonical },
+        { "decimal", check::decimal },
+        { "match", check::match },
+        { "program", check::program },
+        { "snapshot", check::snapshot },
+        { "store", check::store },
+    };
+}
+
+void check::expect(bool condition, std::string_view what, std::source_location location)
+{
+    if (condition)
+        return;
+
+    impl::failures++;
+    std::fprintf(stderr, "%s:%u: expected %.*s\n", location.file_name(), static_cast<unsigned>(location.line()), static_cast<int>(what.size()), what.data());
+}
+
+std::size_t check::failures()
+{
+    return impl::failures;
+}
+
+int main()
+{
+    for (const auto& [name, run] : impl::CHECKS)
+    {
+        const std::size_t before = check::failures();
+
+        try
+        {
+            run();
+        }
+        catch (const std::exception& e)
+        {
+            impl::failures++;
+            std::fprintf(stderr, "%s: %s\n", name, e.what());
+        }
+        std::printf("%-9s %s\n", name, check::failures() == before ? "ok" : "failed");
+    }
+    return check::failures() ? 1 : 0;
+}
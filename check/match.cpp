@@ -0,0 +1,127 @@
+#include <format>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.h"
+#include "engine/egraph.h"
+#include "engine/engine.h"
+#include "engine/match.h"
+#include "engine/rewrite.h"
+#include "engine/rule.h"
+#include "engine/snapshot.h"
+#include "engine/source.h"
+#include "parser/parser.h"
+using namespace ast::prelude;
+
+namespace impl
+{
+    struct Case
+    {
+        std::string_view rule;
+        std::string_view expr;
+        // the expression once the rule is applied, or empty if the rule must not match
+        std::string_view expected;
+    };
+
+    constexpr Case CASES[] =
+    {
+        // a repeated tag binds two equal arguments of a flattened sum, and the one left over is carried over
+        { "$0 + $0 -> 2 * $0", "x + y + x", "2 * x + y" },
+        // binding tag 0 greedily to the first factor fails the divisor, see the readme
+        { "($0 * $1) / $0 -> $1", "(a * b) / b", "a" },
+        // the divisors commute but the dividend does not, so the dividend may pair with the last divisor...
+        { "$0 / $0 -> 1", "a / b / a", "1 / b" },
+        // ...but two divisors may not stand in for the dividend
+        { "$0 / $0 -> 1", "b / a / a", "" },
+        // repeated tags compare literals the way `ast::operator==` does, within epsilon
+        { "$0 + $0 -> 2 * $0", "2 * x + 2.000000000001 * x", "2 * (2 * x)" },
+        { "$0 + $0 -> 2 * $0", "2 * x + 2.001 * x", "" },
+        // the heads, numbers of arguments and leaves checked before matching, in order and among commuting
+        // arguments, turn down what doesn't fit and nothing that does
+        { "$0 * 1 -> $0", "x * 1 * y", "x * y" },
+        { "$0 * 1 -> $0", "x * 2 * y", "" },
+        { "-(-($0)) -> $0", "-(-(x + y))", "x + y" },
+        { "-(-($0)) -> $0", "-(x + y)", "" },
+        { "abs(-($0)) -> abs($0)", "abs(-(x))", "abs(x)" },
+        { "abs(-($0)) -> abs($0)", "abs(x)", "" },
+        { "#0 * $1 + #2 * $1 -> (#0 + #2) * $1", "2 * x + 3 * x + y", "y + (2 + 3) * x" },
+        { "#0 * $1 + #2 * $1 -> (#0 + #2) * $1", "2 * x + 3 * y", "" },
+        { "sqrt($0) * sqrt($0) -> $0", "sqrt(x) * sqrt(y)", "" },
+        { "sqrt($0) * sqrt($0) -> $0", "sqrt(x) * y", "" },
+        { "$0 - sqrt(@1) -> 7", "x - y - sqrt(z)", "7 - y" },
+        { "$0 - sqrt(@1) -> 7", "sqrt(z) - y", "" },
+    };
+
+    // an expression normalized the way rules see it
+    static Ast normalized(std::string_view source)
+    {
+        return engine::evaluate_expr(parser::parse(source));
+    }
+}
+
+// a rule matches the expressions it should, and applying it gives the expected form
+void check::match()
+{
+    for (const auto& [source, expr, expected] : impl::CASES)
+    {
+        const engine::rule::Rule rule = engine::rule::parse(source);
+        const Ast target = impl::normalized(expr);
+
+        const auto match = engine::match::match(rule.program.view(), target, rule.pivot_order);
+        check::expect(match.has_value() == !expected.empty(), std::format("`{}` {} `{}`", source, expected.empty() ? "not to match" : "to match", expr));
+
+        Ast rewritten = target.copy();
+        const bool applied = rule.apply(rewritten);
+        check::expect(applied == match.has_value(), std::format("`{}` to rewrite `{}` whenever it matches", source, expr));
+
+        if (applied)
+            check::expect(rewritten.to_string() == expected, std::format("`{}` to rewrite `{}` to `{}`, got `{}`", source, expr, expected, rewritten.to_string()));
+    }
+
+    // a partial match is spliced in at its first consumed argument, and a whole match replaces the expression
+    const auto splice = [](std::string_view expr, std::initializer_list<std::size_t> consumed, std::string_view expected)
+    {
+        Ast target = impl::normalized(expr);
+        engine::Bitset bits(consumed.size() ? target.get<Call>().args.size() : 0);
+
+        for (const std::size_t i : consumed)
+            bits.set(i);
+
+        engine::rule::replace(target, Variable{ "w" }, bits);
+        check::expect(target.to_string() == expected, std::format("splicing `w` into `{}` to give `{}`, got `{}`", expr, expected, target.to_string()));
+    };
+
+    splice("x * y * z", { 0, 2 }, "w * y");
+    splice("x * y * z", { 1, 2 }, "x * w");
+    splice("x * y * z", {}, "w");
+
+    // every disjoint match of a wide call is applied in the visit which finds the first, with the arguments left
+    // over carried over
+    {
+        const std::vector<std::byte> compiled = engine::snapshot::write(engine::rule::parse_file("$0 + $0 -> 2 * $0"), 0);
+        const engine::snapshot::Snapshot snapshot{ compiled };
+
+        Ast target = impl::normalized("a + b + c + a + b + d + c");
+        const std::size_t applied = snapshot.view().apply(target);
+        check::expect(applied == 3, std::format("`$0 + $0 -> 2 * $0` to apply 3 times to `a + b + c + a + b + d + c` at once, got {}", applied));
+        check::expect(target.to_string() == "2 * a + 2 * b + 2 * c + d", std::format("`$0 + $0 -> 2 * $0` to rewrite `a + b + c + a + b + d + c` to `2 * a + 2 * b + 2 * c + d`, got `{}`", target.to_string()));
+    }
+
+    // the first argument of a tail call is fixed, so it is not skipped as a repeat of the second when a later
+    // argument of the predicate is assigned first, whichever strategy applies the rules
+    {
+        const std::vector<std::byte> compiled = engine::snapshot::write(engine::rule::parse_file("$0 - sqrt(@1) -> 7"), 0);
+        const engine::snapshot::Snapshot snapshot{ compiled };
+
+        Ast innermost = impl::normalized("sqrt(x) - sqrt(x)");
+        engine::rewrite::innermost(innermost, snapshot.view());
+        check::expect(innermost.to_string() == "7", std::format("`$0 - sqrt(@1) -> 7` to rewrite `sqrt(x) - sqrt(x)` to `7`, got `{}`", innermost.to_string()));
+
+        Ast saturated = impl::normalized("sqrt(x) - sqrt(x)");
+        engine::egraph::simplify(saturated, snapshot.view());
+        check::expect(saturated.to_string() == "7", std::format("`$0 - sqrt(@1) -> 7` to saturate `sqrt(x) - sqrt(x)` to `7`, got `{}`", saturated.to_string()));
+    }
+}
@@ -0,0 +1,35 @@
+#include <array>
+#include <format>
+#include <string>
+
+#include "check.h"
+#include "eval/program.h"
+#include "parser/parser.h"
+
+// compiled programs compute the value of their expression, and nested calls reuse the temporaries of their
+// arguments
+void check::program()
+{
+    // the result of a call may share a register with any of its arguments, including one read after the first
+    // step of a left fold
+    {
+        const eval::Program program = eval::compile(parser::parse("min(0.5, y, max(x, z) - 1) * (2 - (x - (3 - (y - z))))"));
+        const std::array<double, 3> values = { 1.0, 2.0, 4.0 };
+        const double result = program.run(values);
+
+        check::expect(result == 3.0, std::format("`min(0.5, y, max(x, z) - 1) * (2 - (x - (3 - (y - z))))` to be 3, got {}", result));
+    }
+
+    // a right-nested chain whose first arguments are not temporaries needs one temporary however deep it is
+    {
+        std::string source = "x";
+
+        for (int i = 0; i < 200; i++)
+            source = std::format("{} - ({})", i % 2 ? "x" : "1", source);
+
+        const eval::Program program = eval::compile(parser::parse(source));
+        const std::size_t temporaries = program.register_count() - program.constants().size() - program.variables().size();
+
+        check::expect(temporaries == 1, std::format("a chain of 200 nested calls to use 1 temporary, got {}", temporaries));
+    }
+}
@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.h"
+#include "cli/rules.h"
+#include "engine/snapshot.h"
+#include "engine/source.h"
+#include "parser/parser.h"
+using namespace ast::prelude;
+
+namespace impl
+{
+    constexpr std::string_view SOURCE = "$0 + $0 -> 2 * $0\n1 * $0 -> $0\nmax(#0, #0) -> #0\n";
+
+    // a copy of the first `size` bytes of a snapshot, aligned to 8 bytes like a mapped file
+    static std::vector<std::uint64_t> aligned(std::span<const std::byte> data, std::size_t size)
+    {
+        std::vector<std::uint64_t> out((size + 7) / 8);
+        std::memcpy(out.data(), data.data(), size);
+        return out;
+    }
+
+    static bool rejected(std::span<const std::byte> data, std::size_t size)
+    {
+        const std::vector<std::uint64_t> copy = aligned(data, size);
+
+        try
+        {
+            engine::snapshot::Snapshot{ std::as_bytes(std::span(copy)).first(size) };
+        }
+        catch (const engine::snapshot::Error&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    static void write(const std::filesystem::path& path, std::string_view text)
+    {
+        std::ofstream(path, std::ios::binary) << text;
+    }
+
+    static Ast apply(const engine::table::View& view, std::string_view source)
+    {
+        Ast out = parser::parse(source);
+        view.apply(out);
+        return out;
+    }
+}
+
+// a snapshot reloads to the rules it was written from, and a truncated or stale one is not used
+void check::snapshot()
+{
+    const std::vector<engine::rule::Rule> rules = engine::rule::parse_file(impl::SOURCE);
+    const std::uint64_t hash = engine::snapshot::hash(impl::SOURCE);
+    const std::vector<std::byte> data = engine::snapshot::write(rules, hash);
+
+    // a complete snapshot loads, and every shorter prefix of it is rejected
+    {
+        const std::vector<std::uint64_t> copy = impl::aligned(data, data.size());
+        const engine::snapshot::Snapshot snapshot{ std::as_bytes(std::span(copy)).first(data.size()) };
+
+        check::expect(snapshot.source_hash() == hash, "a snapshot to keep the hash of its source");
+        check::expect(snapshot.view().size() == rules.size(), std::format("a snapshot to hold {} rules, got {}", rules.size(), snapshot.view().size()));
+
+        for (std::size_t size = 0; size < data.size(); size++)
+            check::expect(impl::rejected(data, size), std::format("a snapshot truncated to {} of {} bytes to be rejected", size, data.size()));
+    }
+
+    // through the cli, a snapshot is written on the first load, mapped on the second, and ignored once it is
+    // truncated or the rule file changes
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / std::format("biss_check_{}", hash);
+    std::filesystem::create_directories(directory);
+    const std::string rule_path = (directory / "rules.txt").string();
+    const std::string cache_path = (directory / "rules.bisr").string();
+    std::filesystem::remove(cache_path);
+
+    impl::write(rule_path, impl::SOURCE);
+    {
+        const cli::RuleFile first = cli::RuleFile::load(rule_path, cache_path);
+        check::expect(!first.cached(), "the first load of a rule file to compile its rules");
+        check::expect(std::filesystem::exists(cache_path), "the first load of a rule file to write its snapshot");
+    }
+    {
+        const cli::RuleFile second = cli::RuleFile::load(rule_path, cache_path);
+        check::expect(second.cached(), "the second load of a rule file to map its snapshot");
+        check::expect(impl::apply(second.view(), "x + x") == impl::apply(cli::RuleFile::load(rule_path).view(), "x + x"), "a mapped snapshot to apply like the rules it was written from");
+    }
+
+    std::filesystem::resize_file(cache_path, data.size() / 2);
+    {
+        const cli::RuleFile truncated = cli::RuleFile::load(rule_path, cache_path);
+        check::expect(!truncated.cached(), "a truncated snapshot to be recompiled");
+        check::expect(std::filesystem::file_size(cache_path) == data.size(), "a truncated snapshot to be rewritten");
+    }
+
+    impl::write(rule_path, "1 * $0 -> $0\n");
+    {
+        const cli::RuleFile stale = cli::RuleFile::load(rule_path, cache_path);
+        check::expect(!stale.cached(), "a snapshot of another source to be recompiled");
+        check::expect(stale.view().size() == 1, std::format("a recompiled rule file to hold 1 rule, got {}", stale.view().size()));
+    }
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,74 @@
+#include <cmath>
+#include <format>
+#include <limits>
+
+#include "check.h"
+#include "ast/store.h"
+#include "engine/engine.h"
+#include "engine/rewrite.h"
+#include "engine/rule.h"
+#include "engine/snapshot.h"
+#include "engine/source.h"
+#include "parser/parser.h"
+using namespace ast::prelude;
+
+// interned expressions are equal exactly when `ast::operator==` says so, and the ids recorded on the calls a
+// rewrite run marks spare walking them again
+void check::store()
+{
+    // literals share an id when they are within epsilon of each other, zero is kept unsigned whichever sign is
+    // interned first, and NaN equals nothing
+    {
+        ast::store::Store store;
+        const ast::store::Id one = store.literal(1.0);
+
+        check::expect(store.literal(1.0 + 1e-12) == one, "literals within epsilon to share an id");
+        check::expect(store.literal(1.001) != one, "literals further apart to have ids of their own");
+
+        const ast::store::Id zero = store.literal(-0.0);
+        check::expect(store.literal(0.0) == zero, "zeroes of either sign to share an id");
+        check::expect(!std::signbit(store.node(zero).value), "a zero interned with its sign first to be stored unsigned");
+
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        check::expect(store.literal(nan) != store.literal(nan), "NaN to never share an id");
+
+        const Ast expr = parser::parse("sqrt(x + 2) * y");
+        const ast::store::Id id = store.intern(expr);
+        check::expect(store.intern(expr.copy()) == id, "a copy of an expression to intern to the same id");
+        check::expect(store.extract(id) == expr, "an interned expression to extract to an equal one");
+    }
+
+    // the id of a call marked in normal form is recorded when it is interned, kept by copies, and used from then
+    // on without visiting its arguments, by interning as well as by `ast::operator==`
+    {
+        constexpr std::uint64_t MARK = 7;
+        ast::store::Store store;
+
+        Ast a = parser::parse("sqrt(x + 2)");
+        Ast b = a.copy();
+        a.get<Call>().normal = MARK;
+        b.get<Call>().normal = MARK;
+
+        const ast::store::Id id = store.intern(a, MARK);
+        check::expect(a.get<Call>().interned == id, "interning a marked call to record its id");
+        check::expect(store.intern(b, MARK) == id && b.get<Call>().interned == id, "an equal marked call to record the same id");
+        check::expect(a.copy().get<Call>().interned == id, "a copy of a marked call to keep its id");
+
+        // altered behind the back of the mark, which a rewrite run never does, such that only an id compare
+        // tells the two apart from a walk
+        b.get<Call>().args[0] = Variable{ "z" };
+        check::expect(a == b, "marked calls with equal ids to compare equal without visiting their arguments");
+        check::expect(store.intern(b, MARK) == id, "a marked call to intern to its recorded id without visiting its arguments");
+        check::expect(store.intern(b) != id, "an unmarked intern to visit the arguments");
+    }
+
+    // a rewrite run keeps the matcher's store across matches, and gives the same result as matching afresh
+    {
+        const std::vector<std::byte> compiled = engine::snapshot::write(engine::rule::parse_file("$0 - $0 -> 0\n$0 * $0 -> sqrt($0)"), 0);
+        const engine::snapshot::Snapshot snapshot{ compiled };
+
+        Ast expr = engine::evaluate_expr(parser::parse("(x * y - y * x) + (z - 1) * (z - 1) + (z - 1) * (1 - z)"));
+        engine::rewrite::innermost(expr, snapshot.view());
+        check::expect(expr.to_string() == "0 + (1 - z) * (z - 1) + sqrt(z - 1)", std::format("repeated tags to be compared across a rewrite run, got `{}`", expr.to_string()));
+    }
+}
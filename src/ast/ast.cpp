@@ -1,77 +1,69 @@
 #include "ast.h"
-#include <format>
+#include "print.h"
+#include <utility>
+#include <vector>
 using namespace ast::prelude;
 using namespace function::prelude;
 
-namespace impl
+Call::Call(const Call& other) : fn(other.fn), normal(other.normal), interned(other.interned)
 {
-    // formats function call with the function name between each operand; `1 + 2 + 3`
-    static std::string format_infix(const Function* fn, const std::vector<Ast>& args)
-    {
-        const auto& format_operand = [&](const Ast& arg)
-        {
-            const std::string arg_out = arg.to_string();
-
-            if (arg.precedence() <= fn->precedence && arg.has<Call>())
-                return std::format("({})", arg_out);
-            else
-                return arg_out;
-        };
-        if (args.size() == 1)
-        {
-            return std::format("{}{}", fn->identifier, format_operand(args[0]));
-        }
-        else
-        {
-            const std::string delimiter = std::format(" {} ", fn->identifier);
-            std::string out;
+    // built level by level. the arguments of each call are reserved up front, such that pointers to them stay
+    // valid while they are pending on the stack
+    std::vector<std::pair<const Call*, Call*>> stack{ { &other, this } };
 
-            for (std::size_t i = 0; i < args.size(); i++)
-            {
-                if (i)
-                    out += delimiter;
-                out += format_operand(args[i]);
-            }
-            return out;
-        }
-    }
-
-    // formats function call with the function name before all operands; `min(1, 2, 3)`   
-    static std::string format_routine(const Function* fn, const std::vector<Ast>& args)
+    while (!stack.empty())
     {
-        std::string args_string = "";
+        const auto [from, to] = stack.back();
+        stack.pop_back();
+        to->args.reserve(from->args.size());
 
-        for (std::size_t i = 0; i < args.size(); i++)
+        for (const Ast& arg : from->args)
         {
-            if (i)
-                args_string += ", ";
-            args_string += args[i].to_string();
+            arg.visit
+            (
+                [&](const Call& call)
+                {
+                    to->args.emplace_back(Call{ call.fn, std::vector<Ast>() });
+                    to->args.back().get<Call>().normal = call.normal;
+                    to->args.back().get<Call>().interned = call.interned;
+                    stack.emplace_back(&call, &to->args.back().get<Call>());
+                },
+                [&](const auto& leaf)
+                {
+                    to->args.emplace_back(leaf);
+                }
+            );
         }
-        return std::format("{}({})", fn->identifier, args_string);
-    }
-
-    // utility to clone args using the `Ast::copy` interface
-    static std::vector<Ast> copy_args(const std::vector<Ast>& args)
-    {
-        std::vector<Ast> cloned_args;
-        cloned_args.reserve(args.size());
-
-        for (const auto& arg : args)
-            cloned_args.push_back(arg.copy());
-        return cloned_args;
     }
 }
 
-Call::Call(const Call& other) : Call(other.fn, impl::copy_args(other.args))
+Call& Call::operator=(const Call& other)
 {
-    
+    return *this = Call(other);
 }
 
-Call& Call::operator=(const Call& other)
+Call::~Call()
 {
-    args = impl::copy_args(other.args);
-    fn = other.fn;
-    return *this;
+    // nested calls are moved onto a stack and destroyed one at a time, each after its own nested calls have been
+    // moved out, such that no destructor recurses. calls without nested calls never allocate the stack
+    std::vector<Ast> stack;
+
+    const auto unlink = [&](std::vector<Ast>& args)
+    {
+        for (Ast& arg : args)
+        {
+            if (arg.has<Call>() && !arg.get<Call>().args.empty())
+                stack.push_back(std::move(arg));
+        }
+    };
+    unlink(args);
+
+    while (!stack.empty())
+    {
+        Ast ast = std::move(stack.back());
+        stack.pop_back();
+        unlink(ast.get<Call>().args);
+    }
 }
 
 Precedence Ast::precedence() const
@@ -85,24 +77,10 @@ Precedence Ast::precedence() const
 
 std::string Ast::to_string() const
 {
-    return visit
-    (
-        [](const Call& e) -> std::string
-        {
-            if (e.fn->syntax == Syntax::INFIX)
-                return impl::format_infix(e.fn, e.args);
-            else
-                return impl::format_routine(e.fn, e.args);
-        },
-        [](const Literal& e) -> std::string
-        {
-            return std::format("{}", e.value);
-        },
-        [](const Variable& e) -> std::string
-        {
-            return e.identifier;
-        }
-    );
+    std::string out;
+    print::StringSink sink{ out };
+    print::print(*this, sink);
+    return out;
 }
 
 Ast Ast::copy() const
@@ -112,23 +90,42 @@ Ast Ast::copy() const
 
 bool ast::operator==(const Ast& a, const Ast& b)
 {
-    return std::visit(Overload
+    std::vector<std::pair<const Ast*, const Ast*>> stack{ { &a, &b } };
+
+    while (!stack.empty())
     {
-        [](const Call& a, const Call& b) -> bool
-        {
-            return a.fn == b.fn && a.args == b.args;
-        },
-        [](const Literal& a, const Literal& b) -> bool
-        {
-            return double_equality(a.value, b.value);
-        },
-        [](const Variable& a, const Variable& b) -> bool
-        {
-            return a.identifier == b.identifier;
-        },
-        [](const auto&, const auto&) -> bool
+        const auto [next_a, next_b] = stack.back();
+        stack.pop_back();
+
+        const bool equal = std::visit(Overload
         {
+            [&](const Call& a, const Call& b) -> bool
+            {
+                if (a.fn != b.fn || a.args.size() != b.args.size())
+                    return false;
+                if (a.normal && a.normal == b.normal && a.interned != UINT32_MAX && b.interned != UINT32_MAX)
+                    return a.interned == b.interned;
+
+                for (std::size_t i = a.args.size(); i-- > 0;)
+                    stack.emplace_back(&a.args[i], &b.args[i]);
+                return true;
+            },
+            [](const Literal& a, const Literal& b) -> bool
+            {
+                return double_equality(a.value, b.value);
+            },
+            [](const Variable& a, const Variable& b) -> bool
+            {
+                return a.identifier == b.identifier;
+            },
+            [](const auto&, const auto&) -> bool
+            {
+                return false;
+            },
+        }, *next_a, *next_b);
+
+        if (!equal)
             return false;
-        },
-    }, a, b);
+    }
+    return true;
 }
@@ -3,6 +3,7 @@
 #include "ast/function.h"
 #include "utility.h"
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <format>
@@ -34,14 +35,30 @@ namespace ast
     {
         const function::Function* fn;
         std::vector<Ast> args;
+        // run of `engine::rewrite` which found this call to be in normal form, along with all of its arguments,
+        // or zero. kept by copies, such that subexpressions copied into the result of a rule need not be visited
+        // again by the same run. not part of the value of the call, and ignored by comparisons
+        std::uint64_t normal = 0;
+        // id of the call in the store of the run which marked it, recorded the first time the matcher interns
+        // it, or `UINT32_MAX`. only meaningful while `normal` is set, since the run doesn't alter marked calls,
+        // and lets equality of two calls marked by the same run compare ids rather than walk both trees (see
+        // `engine::match::Session`). kept by copies and ignored by comparisons like `normal`
+        mutable std::uint32_t interned = UINT32_MAX;
 
         Call(const function::Function* fn, std::vector<Ast> args);
         template<class... Args>
         Call(const function::Function* fn, Args&&... args);
         
-        // these have to overloaded to utilize the explicit `Ast::copy` ctor wrapper
+        // these have to overloaded to utilize the explicit `Ast::copy` ctor wrapper. copies and destroys the
+        // tree iteratively, since recursing per level overflows the native stack for deep trees
         Call(const Call&);
         Call& operator=(const Call&);
+        ~Call();
+
+        // declaring the copy operations above suppresses the implicit move operations, which would silently
+        // turn every move of a call into a deep copy
+        Call(Call&&) = default;
+        Call& operator=(Call&&) = default;
     };
 
     // sum type between all different kinds of AST-nodes. represents an entire expression tree
@@ -53,6 +70,7 @@ namespace ast
         Ast& operator=(Ast&&) = default;
         
         precedence::Precedence precedence() const;
+        // see `print.h` for printing into a buffer or file rather than a new string
         std::string to_string() const;
 
         // force all copies of AST to be explicit, and in user code. you'd be surprised how many sneaky
@@ -63,6 +81,8 @@ namespace ast
         Ast(const Ast&) = default;
     };
     
+    // structural equality, walks both trees iteratively. calls interned by the same rewrite run are compared by
+    // their ids instead, see `Call::interned`
     bool operator==(const Ast& a, const Ast& b);
 
     inline Call::Call(const function::Function* fn, std::vector<Ast> args) : fn(fn), args(std::move(args))
@@ -0,0 +1,323 @@
+#include "binary.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iterator>
+#include <utility>
+using namespace ast::prelude;
+using namespace ast::binary;
+
+namespace impl
+{
+    // literals which are integers smaller than this in magnitude are stored as varints, which take at most 7
+    // bytes rather than 8
+    constexpr double MAX_INTEGER = 281474976710656.0; // 2^48
+
+    static_assert(static_cast<std::size_t>(Tag::CALL) + function::ARRAY.size() <= 256, "function ids must fit in a tag");
+
+    static void put_byte(std::vector<std::byte>& out, std::uint8_t byte)
+    {
+        out.push_back(static_cast<std::byte>(byte));
+    }
+
+    static void put_fixed(std::vector<std::byte>& out, std::uint64_t value, std::size_t bytes)
+    {
+        for (std::size_t i = 0; i < bytes; i++)
+            put_byte(out, static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+
+    static void put_varint(std::vector<std::byte>& out, std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            put_byte(out, static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        put_byte(out, static_cast<std::uint8_t>(value));
+    }
+
+    static void put_literal(std::vector<std::byte>& out, double value)
+    {
+        // negative zero is not an integer in this sense, since it would be decoded as positive zero
+        const bool integer = std::abs(value) < MAX_INTEGER && std::trunc(value) == value
+            && !(value == 0.0 && std::signbit(value));
+
+        if (integer)
+        {
+            // zigzag, such that small negative integers are small varints as well
+            const auto n = static_cast<std::int64_t>(value);
+            put_byte(out, static_cast<std::uint8_t>(Tag::INTEGER));
+            put_varint(out, (static_cast<std::uint64_t>(n) << 1) ^ static_cast<std::uint64_t>(n >> 63));
+        }
+        else
+        {
+            put_byte(out, static_cast<std::uint8_t>(Tag::DOUBLE));
+            put_fixed(out, std::bit_cast<std::uint64_t>(value), 8);
+        }
+    }
+
+    // bounds-checked decoding of a span of bytes
+    struct Cursor
+    {
+        std::span<const std::byte> data;
+        std::size_t& offset;
+
+        std::uint8_t byte()
+        {
+            if (offset >= data.size())
+                throw Error("unexpected end of input");
+            return static_cast<std::uint8_t>(data[offset++]);
+        }
+
+        std::uint64_t fixed(std::size_t bytes)
+        {
+            std::uint64_t out = 0;
+
+            for (std::size_t i = 0; i < bytes; i++)
+                out |= static_cast<std::uint64_t>(byte()) << (8 * i);
+            return out;
+        }
+
+        std::uint64_t varint()
+        {
+            std::uint64_t out = 0;
+
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                const std::uint8_t b = byte();
+                out |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+
+                if (!(b & 0x80))
+                    return out;
+            }
+            throw Error("varint too long");
+        }
+
+        std::span<const std::byte> bytes(std::uint64_t size)
+        {
+            if (size > data.size() - offset)
+                throw Error("unexpected end of input");
+            const std::span<const std::byte> out = data.subspan(offset, static_cast<std::size_t>(size));
+            offset += out.size();
+            return out;
+        }
+    };
+
+    // decodes the node at `offset`, which has to be within `nodes`, and advances past it
+    static Node decode(std::span<const std::byte> nodes, std::size_t& offset, std::span<const std::string_view> variables)
+    {
+        Cursor cursor{ nodes, offset };
+        const std::uint8_t tag = cursor.byte();
+
+        switch (static_cast<Tag>(std::min<std::uint8_t>(tag, static_cast<std::uint8_t>(Tag::CALL))))
+        {
+        case Tag::DOUBLE:
+            return Node{ .kind = Kind::LITERAL, .value = std::bit_cast<double>(cursor.fixed(8)) };
+        case Tag::INTEGER:
+        {
+            const std::uint64_t zigzag = cursor.varint();
+            const auto n = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+            return Node{ .kind = Kind::LITERAL, .value = static_cast<double>(n) };
+        }
+        case Tag::VARIABLE:
+        {
+            const std::uint64_t index = cursor.varint();
+
+            if (index >= variables.size())
+                throw Error("variable index out of range");
+            return Node{ .kind = Kind::VARIABLE, .variable = variables[index] };
+        }
+        case Tag::CALL:
+            break;
+        }
+
+        const std::size_t id = tag - static_cast<std::size_t>(Tag::CALL);
+
+        if (id >= function::ARRAY.size())
+            throw Error("function id out of range");
+
+        const std::uint64_t arity = cursor.varint();
+
+        if (arity > UINT32_MAX)
+            throw Error("too many arguments");
+
+        // everything downstream relies on calls having a number of arguments their function accepts
+        const function::Function* fn = &function::ARRAY[id];
+
+        if (!fn->accepts(arity))
+            throw Error("invalid number of arguments");
+        return Node{ .kind = Kind::CALL, .fn = fn, .arity = static_cast<std::uint32_t>(arity) };
+    }
+}
+
+void Encoder::add(const Ast& ast)
+{
+    // postfix order; a call is visited once to push its arguments and once more after they have been encoded
+    std::vector<std::pair<const Ast*, bool>> stack{ { &ast, false } };
+
+    while (!stack.empty())
+    {
+        const auto [node, expanded] = stack.back();
+        stack.pop_back();
+
+        node->visit
+        (
+            [&](const Call& call)
+            {
+                if (!expanded)
+                {
+                    stack.emplace_back(node, true);
+
+                    for (auto it = call.args.rbegin(); it != call.args.rend(); ++it)
+                        stack.emplace_back(&*it, false);
+                    return;
+                }
+
+                const auto id = static_cast<std::size_t>(call.fn - function::ARRAY.data());
+                impl::put_byte(_nodes, static_cast<std::uint8_t>(static_cast<std::size_t>(Tag::CALL) + id));
+                impl::put_varint(_nodes, call.args.size());
+            },
+            [&](const Literal& literal)
+            {
+                impl::put_literal(_nodes, literal.value);
+            },
+            [&](const Variable& variable)
+            {
+                auto it = _indices.find(std::string_view(variable.identifier));
+
+                if (it == _indices.end())
+                {
+                    it = _indices.emplace(variable.identifier, static_cast<std::uint32_t>(_variables.size())).first;
+                    _variables.push_back(variable.identifier);
+                }
+                impl::put_byte(_nodes, static_cast<std::uint8_t>(Tag::VARIABLE));
+                impl::put_varint(_nodes, it->second);
+            }
+        );
+    }
+
+    impl::put_varint(_expressions, _nodes.size());
+    _expressions.insert(_expressions.end(), _nodes.begin(), _nodes.end());
+    _nodes.clear();
+    _count++;
+}
+
+std::uint64_t Encoder::size() const
+{
+    return _count;
+}
+
+std::vector<std::byte> Encoder::finish() const
+{
+    std::vector<std::byte> out;
+
+    for (const char c : MAGIC)
+        impl::put_byte(out, static_cast<std::uint8_t>(c));
+    impl::put_fixed(out, VERSION, 2);
+    impl::put_fixed(out, 0, 2);
+    impl::put_fixed(out, _variables.size(), 4);
+    impl::put_fixed(out, _count, 8);
+
+    for (const std::string& variable : _variables)
+    {
+        impl::put_varint(out, variable.size());
+
+        for (const char c : variable)
+            impl::put_byte(out, static_cast<std::uint8_t>(c));
+    }
+    out.insert(out.end(), _expressions.begin(), _expressions.end());
+    return out;
+}
+
+Expression::Expression(std::span<const std::byte> nodes, std::span<const std::string_view> variables)
+    : _nodes(nodes), _variables(variables) {}
+
+std::optional<Node> Expression::read()
+{
+    if (_offset == _nodes.size())
+        return std::nullopt;
+    return impl::decode(_nodes, _offset, _variables);
+}
+
+Ast Expression::load(std::vector<Ast>& stack)
+{
+    stack.clear();
+
+    // decoded directly rather than through `read`, and each node constructed in place on the stack, since wide
+    // calls make this a loop over many leaves in which every copy of a node shows
+    while (_offset < _nodes.size())
+    {
+        const Node node = impl::decode(_nodes, _offset, _variables);
+
+        switch (node.kind)
+        {
+        case Kind::LITERAL:
+            stack.emplace_back(std::in_place_type<Literal>, node.value);
+            break;
+        case Kind::VARIABLE:
+            stack.emplace_back(std::in_place_type<Variable>, std::string(node.variable));
+            break;
+        case Kind::CALL:
+        {
+            if (node.arity > stack.size())
+                throw Error("call with more arguments than preceding nodes");
+
+            const auto first = stack.end() - static_cast<std::ptrdiff_t>(node.arity);
+            std::vector<Ast> args(std::make_move_iterator(first), std::make_move_iterator(stack.end()));
+            stack.erase(first, stack.end());
+            stack.emplace_back(std::in_place_type<Call>, node.fn, std::move(args));
+            break;
+        }
+        }
+    }
+
+    if (stack.size() != 1)
+        throw Error("expression does not consist of exactly one tree");
+    return std::move(stack.back());
+}
+
+Ast Expression::load()
+{
+    std::vector<Ast> stack;
+    return load(stack);
+}
+
+Reader::Reader(std::span<const std::byte> data) : _data(data)
+{
+    impl::Cursor cursor{ _data, _offset };
+
+    for (const char c : MAGIC)
+    {
+        if (cursor.byte() != static_cast<std::uint8_t>(c))
+            throw Error("not a binary expression file");
+    }
+    if (cursor.fixed(2) != VERSION)
+        throw Error("unsupported version");
+    cursor.fixed(2); // reserved
+
+    const std::uint64_t variable_count = cursor.fixed(4);
+    _count = _remaining = cursor.fixed(8);
+
+    for (std::uint64_t i = 0; i < variable_count; i++)
+    {
+        const std::span<const std::byte> name = cursor.bytes(cursor.varint());
+        _variables.emplace_back(reinterpret_cast<const char*>(name.data()), name.size());
+    }
+}
+
+std::uint64_t Reader::size() const
+{
+    return _count;
+}
+
+std::optional<Expression> Reader::read()
+{
+    if (!_remaining)
+        return std::nullopt;
+
+    impl::Cursor cursor{ _data, _offset };
+    const std::span<const std::byte> nodes = cursor.bytes(cursor.varint());
+    _remaining--;
+    return Expression(nodes, _variables);
+}
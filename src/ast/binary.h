@@ -0,0 +1,136 @@
+#pragma once
+#include "ast/ast.h"
+#include "ast/function.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// compact binary format for storing expressions between runs, so that they need not be printed and parsed
+// again. a file holds a sequence of expressions sharing one table of variable names:
+//
+//   header      "BISS", version (u16), reserved (u16), number of variables (u32), number of expressions (u64)
+//   variables   length (varint) and chars of each name
+//   expressions length in bytes (varint) and nodes of each expression
+//
+// the nodes of an expression are stored in postfix order, each starting with a tag byte:
+//
+//   DOUBLE      followed by the value as 8 raw bytes
+//   INTEGER     followed by the value as a zigzag-encoded varint, for literals which are small integers
+//   VARIABLE    followed by the index of its name (varint)
+//   CALL + i    followed by the number of arguments (varint), for a call of `ast::function::ARRAY[i]`, which
+//               has to be a number the function accepts
+//
+// integers are little-endian, and varints are LEB128. a reader views the encoded file in place, e.g. when
+// memory-mapped, and decodes nodes one at a time as they are read
+namespace ast::binary
+{
+    constexpr std::string_view MAGIC = "BISS";
+    constexpr std::uint16_t VERSION = 1;
+
+    // malformed or truncated input
+    struct Error : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    enum struct Tag : std::uint8_t
+    {
+        DOUBLE,
+        INTEGER,
+        VARIABLE,
+        CALL,
+    };
+
+    // encodes expressions into a file
+    struct Encoder
+    {
+        void add(const Ast& ast);
+
+        // number of expressions added
+        std::uint64_t size() const;
+
+        // the encoded file containing all expressions added so far
+        std::vector<std::byte> finish() const;
+
+    private:
+        struct Hash
+        {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view str) const
+            {
+                return std::hash<std::string_view>{}(str);
+            }
+        };
+
+        std::vector<std::string> _variables;
+        std::unordered_map<std::string, std::uint32_t, Hash, std::equal_to<>> _indices;
+        std::vector<std::byte> _expressions;
+        std::vector<std::byte> _nodes;
+        std::uint64_t _count = 0;
+    };
+
+    enum struct Kind : std::uint8_t
+    {
+        LITERAL,
+        VARIABLE,
+        CALL,
+    };
+
+    // a decoded node
+    struct Node
+    {
+        Kind kind = Kind::LITERAL;
+        double value = 0.0;
+        std::string_view variable = {};
+        const function::Function* fn = nullptr;
+        std::uint32_t arity = 0;
+    };
+
+    // cursor over the nodes of an encoded expression, in postfix order
+    struct Expression
+    {
+        Expression(std::span<const std::byte> nodes, std::span<const std::string_view> variables);
+
+        // decodes the next node, or returns nothing at the end of the expression
+        std::optional<Node> read();
+
+        // materializes the remaining nodes into an expression tree. the operands pending a call are kept on
+        // `stack`, which may be reused between expressions to spare its allocations
+        Ast load(std::vector<Ast>& stack);
+        Ast load();
+
+    private:
+        std::span<const std::byte> _nodes;
+        std::span<const std::string_view> _variables;
+        std::size_t _offset = 0;
+    };
+
+    // cursor over the expressions of an encoded file. the file is viewed in place, so it has to outlive the
+    // reader and the expressions read from it
+    struct Reader
+    {
+        // validates the header and reads the table of variables
+        explicit Reader(std::span<const std::byte> data);
+
+        // number of expressions in the file
+        std::uint64_t size() const;
+
+        // returns the next expression, or nothing at the end of the file
+        std::optional<Expression> read();
+
+    private:
+        std::span<const std::byte> _data;
+        std::vector<std::string_view> _variables;
+        std::uint64_t _count = 0;
+        std::uint64_t _remaining = 0;
+        std::size_t _offset = 0;
+    };
+}
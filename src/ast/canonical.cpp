@@ -0,0 +1,253 @@
+#include "canonical.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+using namespace ast::prelude;
+using namespace function::prelude;
+
+namespace impl
+{
+    constexpr std::ptrdiff_t INSERTION_SORT_LIMIT = 16;
+
+    enum struct Seed : std::uint64_t
+    {
+        LITERAL = 1,
+        VARIABLE,
+        CALL,
+    };
+
+    // rank of each kind of node in the total order
+    static int rank(const Ast& ast)
+    {
+        return ast.visit
+        (
+            [](const Literal&)  { return 0; },
+            [](const Variable&) { return 1; },
+            [](const Call&)     { return 2; }
+        );
+    }
+
+    // `operator<` on doubles is not a total order in the presence of NaN, which would break the sort. NaNs are
+    // equivalent to each other and greater than all numbers. zeroes are equivalent regardless of sign
+    static std::weak_ordering compare_values(double a, double b)
+    {
+        const bool a_nan = std::isnan(a);
+        const bool b_nan = std::isnan(b);
+
+        if (a_nan || b_nan)
+            return a_nan <=> b_nan;
+        if (a < b)
+            return std::weak_ordering::less;
+        if (b < a)
+            return std::weak_ordering::greater;
+        return std::weak_ordering::equivalent;
+    }
+
+    // the first argument of a call with `Commutativity::TAIL` is fixed, and no argument of a call with
+    // `Commutativity::NONE` is
+    static std::size_t first_unordered(const Function* fn)
+    {
+        switch (fn->commutativity)
+        {
+        case Commutativity::ALL:
+            return 0;
+        case Commutativity::TAIL:
+            return 1;
+        case Commutativity::NONE:
+            break;
+        }
+        return SIZE_MAX;
+    }
+}
+
+std::weak_ordering ast::canonical::compare(const Ast& a, const Ast& b)
+{
+    // walks both trees in pre-order until the first difference, which is the lexicographic order. sorting
+    // compares a lot, mostly leaves or calls differing at the top, so the stack is kept across calls rather
+    // than allocated by each of them
+    static thread_local std::vector<std::pair<const Ast*, const Ast*>> stack;
+    stack.clear();
+    stack.emplace_back(&a, &b);
+
+    while (!stack.empty())
+    {
+        const auto [next_a, next_b] = stack.back();
+        stack.pop_back();
+
+        if (const auto order = impl::rank(*next_a) <=> impl::rank(*next_b); order != 0)
+            return order;
+
+        const std::weak_ordering order = std::visit(Overload
+        {
+            [](const Literal& a, const Literal& b) -> std::weak_ordering
+            {
+                return impl::compare_values(a.value, b.value);
+            },
+            [](const Variable& a, const Variable& b) -> std::weak_ordering
+            {
+                return a.identifier <=> b.identifier;
+            },
+            [&](const Call& a, const Call& b) -> std::weak_ordering
+            {
+                if (const auto order = a.fn->identifier <=> b.fn->identifier; order != 0)
+                    return order;
+                if (const auto order = a.args.size() <=> b.args.size(); order != 0)
+                    return order;
+
+                for (std::size_t i = a.args.size(); i-- > 0;)
+                    stack.emplace_back(&a.args[i], &b.args[i]);
+                return std::weak_ordering::equivalent;
+            },
+            [](const auto&, const auto&) -> std::weak_ordering
+            {
+                return std::weak_ordering::equivalent; // unreachable, the ranks differ
+            },
+        }, *next_a, *next_b);
+
+        if (order != 0)
+            return order;
+    }
+    return std::weak_ordering::equivalent;
+}
+
+void ast::canonical::sort_arguments(Call& call)
+{
+    const std::size_t first = impl::first_unordered(call.fn);
+
+    if (first >= call.args.size() || call.args.size() - first < 2)
+        return;
+
+    const auto begin = call.args.begin() + static_cast<std::ptrdiff_t>(first);
+    const auto less = [](const Ast& a, const Ast& b) { return compare(a, b) < 0; };
+
+    // sorts are stable, such that sorting a canonical call leaves it exactly as it is. most calls have only a
+    // few arguments, which are sorted in place since `std::stable_sort` allocates a buffer
+    if (call.args.end() - begin > impl::INSERTION_SORT_LIMIT)
+    {
+        std::stable_sort(begin, call.args.end(), less);
+        return;
+    }
+
+    for (auto it = begin + 1; it != call.args.end(); ++it)
+    {
+        auto hole = it;
+
+        for (; hole != begin && less(*it, *(hole - 1)); --hole) {}
+
+        if (hole != it)
+            std::rotate(hole, it, it + 1);
+    }
+}
+
+Ast ast::canonical::canonicalize(Ast ast)
+{
+    // post-order, such that the arguments of each call are canonical by the time it is sorted
+    std::vector<std::pair<Call*, std::size_t>> stack;
+
+    if (ast.has<Call>())
+        stack.emplace_back(&ast.get<Call>(), 0);
+
+    while (!stack.empty())
+    {
+        auto& [call, next] = stack.back();
+
+        if (next < call->args.size())
+        {
+            Ast& arg = call->args[next++];
+
+            if (arg.has<Call>())
+                stack.emplace_back(&arg.get<Call>(), 0);
+            continue;
+        }
+        sort_arguments(*call);
+        stack.pop_back();
+    }
+    return ast;
+}
+
+std::uint64_t ast::canonical::hash_literal(double value)
+{
+    if (value == 0.0)
+        value = 0.0;
+    if (value != value)
+        value = std::numeric_limits<double>::quiet_NaN();
+    return hash_combine(static_cast<std::uint64_t>(impl::Seed::LITERAL), std::bit_cast<std::uint64_t>(value));
+}
+
+std::uint64_t ast::canonical::hash_variable(std::string_view identifier)
+{
+    std::uint64_t hash = static_cast<std::uint64_t>(impl::Seed::VARIABLE);
+
+    for (const char c : identifier)
+        hash = hash_combine(hash, static_cast<unsigned char>(c));
+    return hash;
+}
+
+ast::canonical::CallHasher::CallHasher(const Function* fn)
+    : _fn(fn), _ordered(hash_combine(static_cast<std::uint64_t>(impl::Seed::CALL), fn->identifier_hash)) {}
+
+void ast::canonical::CallHasher::add(std::uint64_t arg)
+{
+    // the unordered arguments are summed, which is commutative, rather than combined
+    if (_count >= impl::first_unordered(_fn))
+        _unordered += hash_mix(arg);
+    else
+        _ordered = hash_combine(_ordered, arg);
+    _count++;
+}
+
+std::uint64_t ast::canonical::CallHasher::finish() const
+{
+    return hash_combine(hash_combine(_ordered, _unordered), _count);
+}
+
+std::uint64_t ast::canonical::hash(const Ast& ast)
+{
+    const auto hash_leaf = [](const Ast& leaf)
+    {
+        return leaf.visit
+        (
+            [](const Literal& literal)   { return hash_literal(literal.value);        },
+            [](const Variable& variable) { return hash_variable(variable.identifier); },
+            [](const Call&)              { return std::uint64_t(0);                   }
+        );
+    };
+
+    if (!ast.has<Call>())
+        return hash_leaf(ast);
+
+    struct Frame
+    {
+        const Call* call;
+        std::size_t next;
+        CallHasher hasher;
+    };
+    std::vector<Frame> stack{ { &ast.get<Call>(), 0, CallHasher(ast.get<Call>().fn) } };
+
+    while (true)
+    {
+        Frame& frame = stack.back();
+
+        if (frame.next < frame.call->args.size())
+        {
+            const Ast& arg = frame.call->args[frame.next++];
+
+            if (arg.has<Call>())
+                stack.push_back({ &arg.get<Call>(), 0, CallHasher(arg.get<Call>().fn) });
+            else
+                frame.hasher.add(hash_leaf(arg));
+            continue;
+        }
+
+        const std::uint64_t out = frame.hasher.finish();
+        stack.pop_back();
+
+        if (stack.empty())
+            return out;
+        stack.back().hasher.add(out);
+    }
+}
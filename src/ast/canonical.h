@@ -0,0 +1,52 @@
+#pragma once
+#include "ast/ast.h"
+#include "ast/function.h"
+
+#include <compare>
+#include <cstdint>
+#include <string_view>
+
+// canonical forms of expressions. the arguments of commutative calls are put in a total structural order,
+// such that expressions differing only in the order of commutative arguments, like `a + b` and `b + a`, are
+// represented by the same tree. combined with `engine::evaluate_expr` flattening associative calls, this lets
+// equality checks and caches identify far more equivalent expressions
+namespace ast::canonical
+{
+    // total structural order. literals come before variables, which come before calls. literals are ordered by
+    // value (with NaN last), variables by identifier, and calls by identifier, then by number of arguments,
+    // then by their arguments lexicographically
+    std::weak_ordering compare(const Ast& a, const Ast& b);
+
+    // sorts the arguments of a call according to its commutativity; all of them for `Commutativity::ALL`, all
+    // but the first for `Commutativity::TAIL`. the arguments themselves are left as they are, so this puts a
+    // call in canonical form if its arguments already are
+    void sort_arguments(Call& call);
+
+    // puts an entire expression in canonical form, bottom-up
+    Ast canonicalize(Ast ast);
+
+    // structural hashes invariant under the permutations `sort_arguments` may apply, such that an expression
+    // hashes the same as its canonical form. literals are hashed by their exact bit pattern, with zeroes and
+    // NaNs normalized, and identifiers by their name, so hashes are stable across runs. expressions equal by
+    // `ast::operator==` only because their literals are within epsilon of each other may hash apart
+    std::uint64_t hash_literal(double value);
+    std::uint64_t hash_variable(std::string_view identifier);
+
+    // hash of a call, fed the hashes of its arguments in order. the arguments which may be reordered are
+    // combined with a commutative operation
+    struct CallHasher
+    {
+        explicit CallHasher(const function::Function* fn);
+
+        void add(std::uint64_t arg);
+        std::uint64_t finish() const;
+
+    private:
+        const function::Function* _fn;
+        std::uint64_t _ordered;
+        std::uint64_t _unordered = 0;
+        std::uint32_t _count = 0;
+    };
+
+    std::uint64_t hash(const Ast& ast);
+}
@@ -1,9 +1,10 @@
 #pragma once
 #include "precedence.h"
 
-#include <string_view>
-#include <unordered_set>
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <string_view>
 
 namespace ast::function
 {
@@ -83,6 +84,12 @@ namespace ast::function
         const precedence::Precedence precedence;
         const std::uint32_t identifier_hash;
 
+        // whether a call of the function may have the number of arguments
+        constexpr bool accepts(std::size_t n) const
+        {
+            return arity_type == ArityType::STATIC ? n == arity : n >= arity;
+        }
+
         // creates a new unary operator function
         constexpr static Function unary(std::string_view identifier)
         {
@@ -173,30 +180,130 @@ namespace ast::function
         };
     }();
 
-    inline const std::unordered_set<std::string_view> IDENTIFIERS = []()
+    // maximum number of functions sharing an identifier, e.g. unary and binary `-`
+    inline constexpr std::size_t MAX_OVERLOADS = []()
     {
-        std::unordered_set<std::string_view> out;
+        std::size_t out = 0;
+
+        for (const auto& a : ARRAY)
+        {
+            std::size_t count = 0;
 
-        for (const auto& fn : ARRAY)
-            out.emplace(fn.identifier);
+            for (const auto& b : ARRAY)
+                count += a.identifier == b.identifier;
+            out = std::max(out, count);
+        }
         return out;
     }();
 
-    constexpr inline const Function* get(std::string_view identifier, std::uint8_t arity)
+    // all functions sharing an identifier, in the order they appear in `ARRAY`
+    struct Overloads
     {
-        const std::uint32_t hash = impl::hash(identifier);
+        std::string_view identifier;
+        std::array<const Function*, MAX_OVERLOADS> fns{};
+        std::uint8_t count = 0;
 
-        for (const auto& fn : ARRAY)
+        // the first overload accepting the number of arguments, if any
+        constexpr const Function* get(std::size_t arity) const
         {
-            const bool arity_match = fn.arity_type == ArityType::STATIC
-                ? arity == fn.arity
-                : arity >= fn.arity;
-            if (arity_match && fn.identifier_hash == hash)
-                return &fn;
+            for (std::uint8_t i = 0; i < count; i++)
+            {
+                if (fns[i]->accepts(arity))
+                    return fns[i];
+            }
+            return nullptr;
         }
+    };
+
+    namespace impl
+    {
+        // perfect hash table from identifiers to their overloads, generated during compilation. the slot of an
+        // identifier is given by the top bits of its hash times a multiplier, which is searched for such that no
+        // two identifiers share a slot. a lookup thus hashes once and compares one identifier
+        struct IdentifierTable
+        {
+            static constexpr std::size_t BITS = 6;
+            static constexpr std::size_t SIZE = std::size_t(1) << BITS;
+            static_assert(SIZE >= 2 * ARRAY.size(), "table too dense to find a perfect hash quickly");
+
+            std::uint32_t multiplier = 1;
+            std::array<Overloads, SIZE> slots{};
+
+            constexpr std::size_t slot(std::uint32_t hash) const
+            {
+                return (hash * multiplier) >> (32 - BITS);
+            }
+        };
+
+        inline constexpr IdentifierTable IDENTIFIER_TABLE = []()
+        {
+            IdentifierTable table;
+
+            const auto collides = [&]()
+            {
+                std::array<std::uint32_t, IdentifierTable::SIZE> occupant{};
+
+                for (const Function& fn : ARRAY)
+                {
+                    // occupants are stored as hashes offset by one, so that zero marks an empty slot
+                    std::uint32_t& slot = occupant[table.slot(fn.identifier_hash)];
+
+                    if (slot && slot != fn.identifier_hash + 1)
+                        return true;
+                    slot = fn.identifier_hash + 1;
+                }
+                return false;
+            };
+
+            while (collides())
+                table.multiplier += 2;
+
+            for (const Function& fn : ARRAY)
+            {
+                Overloads& overloads = table.slots[table.slot(fn.identifier_hash)];
+                overloads.identifier = fn.identifier;
+                overloads.fns[overloads.count++] = &fn;
+            }
+            return table;
+        }();
+    }
+
+    // the overloads of an identifier, or null if no function has it
+    constexpr inline const Overloads* find(std::string_view identifier)
+    {
+        const impl::IdentifierTable& table = impl::IDENTIFIER_TABLE;
+        const Overloads& overloads = table.slots[table.slot(impl::hash(identifier))];
+
+        if (overloads.count && overloads.identifier == identifier)
+            return &overloads;
         return nullptr;
     }
 
+    constexpr inline const Function* get(std::string_view identifier, std::size_t arity)
+    {
+        const Overloads* overloads = find(identifier);
+        return overloads ? overloads->get(arity) : nullptr;
+    }
+
+    // position of a function in `ARRAY`, which identifies it independently of where the program is loaded
+    constexpr inline std::uint32_t index(const Function* fn)
+    {
+        return static_cast<std::uint32_t>(fn - ARRAY.data());
+    }
+
+    // length of the longest identifier made of symbols, bounding the longest match of an operator
+    inline constexpr std::size_t MAX_OPERATOR_LENGTH = []()
+    {
+        std::size_t out = 0;
+
+        for (const Function& fn : ARRAY)
+        {
+            if (fn.syntax == Syntax::INFIX)
+                out = std::max(out, fn.identifier.size());
+        }
+        return out;
+    }();
+
     namespace prelude
     {
         using function::Commutativity;
@@ -204,5 +311,6 @@ namespace ast::function
         using function::Syntax;
         using function::ArityType;
         using function::Function;
+        using function::Overloads;
     }
 }
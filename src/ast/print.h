@@ -0,0 +1,200 @@
+#pragma once
+#include "ast/ast.h"
+#include "ast/function.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// prints expressions into a sink in a single pass, without building intermediate strings. see
+// `Ast::to_string` for the format
+namespace ast::print
+{
+    // destination of the printed text, e.g. `io::Output` or one of the sinks below
+    template<class S>
+    concept Sink = requires(S& sink, std::string_view text)
+    {
+        sink.write(text);
+    };
+
+    // appends to a string
+    struct StringSink
+    {
+        std::string& out;
+
+        void write(std::string_view text)
+        {
+            out += text;
+        }
+    };
+
+    // writes into a fixed buffer. text which doesn't fit is dropped, and marks the output as truncated
+    struct BufferSink
+    {
+        std::span<char> buffer;
+        std::size_t size = 0;
+        bool truncated = false;
+
+        void write(std::string_view text)
+        {
+            const std::size_t n = std::min(text.size(), buffer.size() - size);
+            std::copy_n(text.data(), n, buffer.data() + size);
+            size += n;
+            truncated |= n < text.size();
+        }
+
+        std::string_view view() const
+        {
+            return { buffer.data(), size };
+        }
+    };
+
+    // writes to a file directly, relying on the buffering of the file
+    struct FileSink
+    {
+        std::FILE* file;
+
+        void write(std::string_view text)
+        {
+            std::fwrite(text.data(), 1, text.size(), file);
+        }
+    };
+
+    // longest text of a literal; a sign, 17 significant digits, a point, and an exponent like `e-308`
+    constexpr std::size_t MAX_LITERAL_LENGTH = 32;
+
+    // formats a literal as the shortest text that parses back to the same value, which is also what
+    // `std::format("{}", value)` produces
+    inline std::string_view format_literal(double value, std::array<char, MAX_LITERAL_LENGTH>& buffer)
+    {
+        const auto [end, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+        return { buffer.data(), static_cast<std::size_t>(end - buffer.data()) };
+    }
+
+    // prints expressions into a sink. the subexpressions and text still to be printed are kept on an explicit
+    // stack, which is reused between expressions, so printing deep trees neither recurses nor allocates per node
+    template<Sink S>
+    struct Printer
+    {
+        explicit Printer(S& sink) : _sink(sink) {}
+
+        void print(const Ast& ast)
+        {
+            _stack.push_back({ &ast, {} });
+
+            while (!_stack.empty())
+            {
+                const Piece piece = _stack.back();
+                _stack.pop_back();
+
+                if (!piece.ast)
+                {
+                    _sink.write(piece.text);
+                    continue;
+                }
+
+                piece.ast->visit
+                (
+                    [&](const Call& call)
+                    {
+                        push_call(call);
+                    },
+                    [&](const Literal& literal)
+                    {
+                        std::array<char, MAX_LITERAL_LENGTH> buffer;
+                        _sink.write(format_literal(literal.value, buffer));
+                    },
+                    [&](const Variable& variable)
+                    {
+                        _sink.write(variable.identifier);
+                    }
+                );
+            }
+        }
+
+    private:
+        // either a subexpression, or text if `ast` is null
+        struct Piece
+        {
+            const Ast* ast;
+            std::string_view text;
+        };
+
+        S& _sink;
+        std::vector<Piece> _stack;
+
+        void push_text(std::string_view text)
+        {
+            _stack.push_back({ nullptr, text });
+        }
+
+        // pushes an operand of an infix function call, parenthesized if it binds less tightly than the function
+        void push_operand(const function::Function* fn, const Ast& arg)
+        {
+            const bool parenthesize = arg.precedence() <= fn->precedence && arg.has<Call>();
+
+            if (parenthesize)
+                push_text(")");
+            _stack.push_back({ &arg, {} });
+
+            if (parenthesize)
+                push_text("(");
+        }
+
+        // pushes the pieces of a call in reverse, since the stack is popped from the back. infix calls are
+        // printed with the function name between each operand; `1 + 2 + 3`, and routine calls with the function
+        // name before all operands; `min(1, 2, 3)`
+        void push_call(const Call& call)
+        {
+            const function::Function* fn = call.fn;
+            const std::size_t n = call.args.size();
+
+            if (fn->syntax == function::Syntax::INFIX && n == 1)
+            {
+                push_operand(fn, call.args[0]);
+                push_text(fn->identifier);
+            }
+            else if (fn->syntax == function::Syntax::INFIX)
+            {
+                for (std::size_t i = n; i-- > 0;)
+                {
+                    push_operand(fn, call.args[i]);
+
+                    if (i)
+                    {
+                        push_text(" ");
+                        push_text(fn->identifier);
+                        push_text(" ");
+                    }
+                }
+            }
+            else
+            {
+                push_text(")");
+
+                for (std::size_t i = n; i-- > 0;)
+                {
+                    _stack.push_back({ &call.args[i], {} });
+
+                    if (i)
+                        push_text(", ");
+                }
+                push_text("(");
+                push_text(fn->identifier);
+            }
+        }
+    };
+
+    template<Sink S>
+    void print(const Ast& ast, S& sink)
+    {
+        Printer<S>(sink).print(ast);
+    }
+}
@@ -0,0 +1,319 @@
+#include "store.h"
+
+#include <bit>
+#include <cassert>
+#include <iterator>
+using namespace ast::prelude;
+using namespace ast::store;
+
+namespace impl
+{
+    constexpr std::size_t INITIAL_CAPACITY = 64;
+
+    // literals are hashed by their bit pattern with the 20 lowest mantissa bits dropped, a granularity coarser
+    // than the epsilon of `double_equality`. two values it considers equal are therefore keyed identically or
+    // adjacently, and a literal is looked up under its key and both neighbours (see `engine::index::quantize`)
+    static std::int64_t literal_key(double value)
+    {
+        if (value == 0.0)
+            value = 0.0;
+        return std::bit_cast<std::int64_t>(value) >> 20;
+    }
+
+    static std::uint64_t hash_literal(std::int64_t key)
+    {
+        return hash_combine(hash_mix(static_cast<std::uint64_t>(Kind::LITERAL)), static_cast<std::uint64_t>(key));
+    }
+
+    static std::uint64_t hash_node(const Node& node, std::span<const Id> args)
+    {
+        std::uint64_t hash = hash_mix(static_cast<std::uint64_t>(node.kind));
+
+        switch (node.kind)
+        {
+        case Kind::LITERAL:
+            return hash_literal(literal_key(node.value));
+        case Kind::VARIABLE:
+            return hash_combine(hash, node.offset);
+        case Kind::CALL:
+            hash = hash_combine(hash, std::bit_cast<std::uintptr_t>(node.fn));
+
+            for (const Id arg : args)
+                hash = hash_combine(hash, arg);
+            return hash;
+        }
+        return hash;
+    }
+}
+
+Store::Store() : _table(impl::INITIAL_CAPACITY, NONE)
+{
+
+}
+
+Id Store::literal(double value)
+{
+    // zeroes are stored unsigned, such that extracting one doesn't depend on which sign was interned first
+    if (value == 0.0)
+        value = 0.0;
+
+    const Node node{ Kind::LITERAL, 0, 0, nullptr, value, 0 };
+    const std::int64_t key = impl::literal_key(value);
+
+    for (std::int64_t neighbour = key - 1; neighbour <= key + 1; neighbour++)
+    {
+        if (const Id existing = find(impl::hash_literal(neighbour), node, {}); existing != NONE)
+            return existing;
+    }
+    return add(impl::hash_literal(key), node, {});
+}
+
+Id Store::variable(std::string_view identifier)
+{
+    auto it = _symbols.find(identifier);
+
+    if (it == _symbols.end())
+    {
+        const std::string_view stored = _identifiers.emplace_back(identifier);
+        it = _symbols.emplace(stored, static_cast<std::uint32_t>(_identifiers.size() - 1)).first;
+    }
+    Node node{ Kind::VARIABLE, 0, it->second, nullptr, 0.0, 0 };
+    return insert(node, {});
+}
+
+Id Store::call(const function::Function* fn, std::span<const Id> args)
+{
+    assert(fn);
+    Node node{ Kind::CALL, static_cast<std::uint32_t>(args.size()), 0, fn, 0.0, 0 };
+    return insert(node, args);
+}
+
+Id Store::intern(const Ast& ast, std::uint64_t mark)
+{
+    // post-order over an explicit stack, such that arbitrarily deep expressions cannot exhaust the native stack.
+    // the ids of interned arguments are collected until their call is interned
+    struct Frame
+    {
+        const Ast* ast;
+        std::size_t next = 0;
+    };
+
+    std::vector<Frame> stack{ { &ast } };
+    std::vector<Id> ids;
+
+    while (!stack.empty())
+    {
+        Frame& frame = stack.back();
+
+        if (frame.ast->has<Call>())
+        {
+            const Call& e = frame.ast->get<Call>();
+            const bool marked = mark && e.normal == mark;
+
+            if (marked && e.interned != NONE)
+            {
+                ids.push_back(e.interned);
+                stack.pop_back();
+                continue;
+            }
+            if (frame.next < e.args.size())
+            {
+                stack.push_back({ &e.args[frame.next++] });
+                continue;
+            }
+
+            const Id id = call(e.fn, std::span(ids).last(e.args.size()));
+            ids.resize(ids.size() - e.args.size());
+            ids.push_back(id);
+
+            if (marked)
+                e.interned = id;
+        }
+        else if (frame.ast->has<Literal>())
+        {
+            ids.push_back(literal(frame.ast->get<Literal>().value));
+        }
+        else
+        {
+            ids.push_back(variable(frame.ast->get<Variable>().identifier));
+        }
+        stack.pop_back();
+    }
+    return ids.back();
+}
+
+Ast Store::extract(Id id) const
+{
+    // post-order like `intern`, collecting the extracted arguments until their call is built
+    struct Frame
+    {
+        Id id;
+        std::size_t next = 0;
+    };
+
+    std::vector<Frame> stack{ { id } };
+    std::vector<Ast> out;
+
+    while (!stack.empty())
+    {
+        Frame& frame = stack.back();
+        const Node& n = node(frame.id);
+
+        switch (n.kind)
+        {
+        case Kind::LITERAL:
+            out.emplace_back(Literal{ n.value });
+            break;
+        case Kind::VARIABLE:
+            out.emplace_back(Variable{ std::string(_identifiers[n.offset]) });
+            break;
+        case Kind::CALL:
+        {
+            if (frame.next < n.arity)
+            {
+                stack.push_back({ args(frame.id)[frame.next++] });
+                continue;
+            }
+
+            const auto first = out.end() - static_cast<std::ptrdiff_t>(n.arity);
+            std::vector<Ast> args(std::make_move_iterator(first), std::make_move_iterator(out.end()));
+            out.erase(first, out.end());
+            out.emplace_back(Call{ n.fn, std::move(args) });
+            break;
+        }
+        }
+        stack.pop_back();
+    }
+    return std::move(out.back());
+}
+
+const Node& Store::node(Id id) const
+{
+    assert(id < _nodes.size());
+    return _nodes[id];
+}
+
+std::span<const Id> Store::args(Id id) const
+{
+    const Node& n = node(id);
+
+    if (n.kind != Kind::CALL)
+        return {};
+    return std::span{ _args }.subspan(n.offset, n.arity);
+}
+
+std::string_view Store::identifier(Id id) const
+{
+    const Node& n = node(id);
+    assert(n.kind == Kind::VARIABLE);
+    return _identifiers[n.offset];
+}
+
+std::size_t Store::size() const
+{
+    return _nodes.size();
+}
+
+void Store::clear()
+{
+    _nodes.clear();
+    _args.clear();
+    _identifiers.clear();
+    _symbols.clear();
+    _table.assign(impl::INITIAL_CAPACITY, NONE);
+}
+
+Id Store::insert(const Node& node, std::span<const Id> args)
+{
+    const std::uint64_t hash = impl::hash_node(node, args);
+
+    if (const Id existing = find(hash, node, args); existing != NONE)
+        return existing;
+    return add(hash, node, args);
+}
+
+Id Store::find(std::uint64_t hash, const Node& node, std::span<const Id> args) const
+{
+    const std::size_t mask = _table.size() - 1;
+
+    // linear probing; the table is kept at most half full so that probe sequences stay short
+    for (std::size_t i = hash & mask; _table[i] != NONE; i = (i + 1) & mask)
+    {
+        const Id existing = _table[i];
+
+        if (_nodes[existing].hash == hash && same(existing, node, args))
+            return existing;
+    }
+    return NONE;
+}
+
+Id Store::add(std::uint64_t hash, const Node& node, std::span<const Id> args)
+{
+    const std::size_t mask = _table.size() - 1;
+    std::size_t i = hash & mask;
+
+    while (_table[i] != NONE)
+        i = (i + 1) & mask;
+
+    const Id id = static_cast<Id>(_nodes.size());
+    Node& inserted = _nodes.emplace_back(node);
+    inserted.hash = hash;
+
+    if (inserted.kind == Kind::CALL)
+    {
+        inserted.offset = static_cast<std::uint32_t>(_args.size());
+
+        // `args` may itself be a view into the pool, which is invalidated as soon as it grows
+        const bool aliased = !_args.empty() && args.data() >= _args.data() &&
+            args.data() < _args.data() + _args.size();
+
+        if (aliased)
+        {
+            const std::vector<Id> copy(args.begin(), args.end());
+            _args.insert(_args.end(), copy.begin(), copy.end());
+        }
+        else
+        {
+            _args.insert(_args.end(), args.begin(), args.end());
+        }
+    }
+    _table[i] = id;
+
+    if (_nodes.size() * 2 > _table.size())
+        grow();
+    return id;
+}
+
+bool Store::same(Id id, const Node& node, std::span<const Id> args) const
+{
+    const Node& existing = _nodes[id];
+
+    if (existing.kind != node.kind)
+        return false;
+
+    switch (node.kind)
+    {
+    case Kind::LITERAL:
+        return double_equality(existing.value, node.value);
+    case Kind::VARIABLE:
+        return existing.offset == node.offset;
+    case Kind::CALL:
+        return existing.fn == node.fn && std::ranges::equal(this->args(id), args);
+    }
+    return false;
+}
+
+void Store::grow()
+{
+    _table.assign(_table.size() * 2, NONE);
+    const std::size_t mask = _table.size() - 1;
+
+    for (Id id = 0; id < _nodes.size(); id++)
+    {
+        std::size_t i = _nodes[id].hash & mask;
+
+        while (_table[i] != NONE)
+            i = (i + 1) & mask;
+        _table[i] = id;
+    }
+}
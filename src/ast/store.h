@@ -0,0 +1,98 @@
+#pragma once
+#include "ast/ast.h"
+#include "ast/function.h"
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ast::store
+{
+    // handle to an interned expression. two handles obtained from the same store are equal if and only if
+    // the expressions they refer to are equal by `ast::operator==`, which makes equality an integer compare and
+    // copies free. literals are compared by `double_equality`, which isn't transitive: a literal is interned
+    // as the first one it is equal to, so of three literals which are each within epsilon of the next but not
+    // of each other, which two share a handle depends on the order they are interned in. NaN is never equal
+    // to anything, and every NaN interned gets a handle of its own
+    using Id = std::uint32_t;
+
+    // sentinel for "no expression"
+    constexpr Id NONE = UINT32_MAX;
+
+    enum struct Kind : std::uint8_t
+    {
+        LITERAL,
+        VARIABLE,
+        CALL,
+    };
+
+    // an interned AST-node. children of calls are stored as ids in a pool shared by all nodes, such that
+    // identical sub-expressions are only ever stored once
+    struct Node
+    {
+        Kind kind;
+        // number of arguments of a call
+        std::uint32_t arity;
+        // offset into the argument pool for calls, or index into the identifier table for variables
+        std::uint32_t offset;
+        const function::Function* fn;
+        double value;
+        std::uint64_t hash;
+    };
+
+    // unique table of hash-consed expressions. nodes are immutable once interned and are never freed until
+    // the store is cleared.
+    //
+    // the store is a side table, not the representation of `Ast`: expressions are interned on demand, and
+    // only the matcher does so, to compare the values of repeated tags. the ids of calls marked by a rewrite
+    // run are recorded on them, which spares interning them again and lets `ast::operator==` compare them in
+    // constant time. copies of an `Ast` still copy the whole tree, since every `Ast` owns its arguments
+    struct Store
+    {
+        Store();
+
+        Id literal(double value);
+        Id variable(std::string_view identifier);
+        Id call(const function::Function* fn, std::span<const Id> args);
+
+        // interns an entire expression tree, bottom-up. if `mark` is given, the calls marked with it in normal
+        // form (see `Call::normal`) are taken to be unchanged since they were interned into this store: their
+        // recorded ids are used without visiting their arguments, and the ids of those not yet interned are
+        // recorded
+        Id intern(const Ast& ast, std::uint64_t mark = 0);
+
+        // rebuilds the expression tree referred to by an id
+        Ast extract(Id id) const;
+
+        const Node& node(Id id) const;
+        std::span<const Id> args(Id id) const;
+        std::string_view identifier(Id id) const;
+
+        // number of unique expressions in the store
+        std::size_t size() const;
+
+        // drops all interned expressions, invalidating all ids
+        void clear();
+
+    private:
+        Id insert(const Node& node, std::span<const Id> args);
+        // the id of a node with the hash which is the same as the one given, or `NONE`
+        Id find(std::uint64_t hash, const Node& node, std::span<const Id> args) const;
+        // adds a node without looking for an existing one
+        Id add(std::uint64_t hash, const Node& node, std::span<const Id> args);
+        bool same(Id id, const Node& node, std::span<const Id> args) const;
+        void grow();
+
+        std::vector<Node> _nodes;
+        std::vector<Id> _args;
+        // open-addressed hash table of ids into `_nodes`
+        std::vector<Id> _table;
+        // deque to keep references to the identifiers stable as the table grows
+        std::deque<std::string> _identifiers;
+        std::unordered_map<std::string_view, std::uint32_t> _symbols;
+    };
+}
@@ -0,0 +1,221 @@
+#include "batch.h"
+#include "pool.h"
+#include "ast/print.h"
+#include "engine/engine.h"
+#include "parser/parser.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace cli;
+
+namespace impl
+{
+    // evaluates each line of a chunk and appends the results, returns the number of lines which failed
+    static std::size_t evaluate_lines(std::string_view lines, std::string& out)
+    {
+        std::size_t failed = 0;
+        ast::print::StringSink sink{ out };
+        ast::print::Printer printer(sink);
+
+        while (!lines.empty())
+        {
+            const std::size_t end = lines.find('\n');
+            std::string_view line = lines.substr(0, end);
+            lines.remove_prefix(end == std::string_view::npos ? lines.size() : end + 1);
+
+            if (line.ends_with('\r'))
+                line.remove_suffix(1);
+
+            try
+            {
+                printer.print(*engine::evaluate_shared(line));
+                out += '\n';
+            }
+            catch (const parser::Error& e)
+            {
+                out += std::format("error at column {}: {}\n", e.column + 1, e.msg);
+                failed++;
+            }
+        }
+        return failed;
+    }
+
+    // a unit of work of the parallel pipeline. slots are reused once their results have been written
+    struct Chunk
+    {
+        std::string storage;
+        std::string_view lines;
+        std::string results;
+        std::size_t failed = 0;
+        std::exception_ptr error;
+        std::atomic<bool> done = false;
+    };
+
+    static std::size_t serial(io::Input& input, io::Output& out, const Options& options)
+    {
+        std::string storage;
+        std::string results;
+        std::size_t failed = 0;
+
+        while (const auto lines = input.read(storage, options.chunk_size))
+        {
+            results.clear();
+            failed += evaluate_lines(*lines, results);
+            out.write(results);
+
+            if (!input.mapped())
+                out.flush();
+        }
+        return failed;
+    }
+
+    // a pipeline of three stages. the calling thread splits the input into chunks and submits them to the pool,
+    // which evaluates them in any order, while a writer thread writes the results of each chunk in order as
+    // soon as all preceding chunks are done. the splitter waits while the window of chunks in flight is full
+    static std::size_t parallel(io::Input& input, io::Output& out, const Options& options)
+    {
+        const std::size_t window = options.threads * std::max<std::size_t>(options.chunks_per_thread, 1);
+        const bool streamed = !input.mapped();
+        std::vector<Chunk> chunks(window);
+
+        // progress of the pipeline, guarded by `mutex`
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::size_t submitted = 0;
+        std::size_t written = 0;
+        bool finished = false;
+        bool aborted = false;
+
+        std::size_t failed = 0;
+        std::exception_ptr error;
+
+        // declared after the chunks so that it finishes every task before they are destroyed
+        Pool pool(options.threads);
+
+        std::thread writer([&]()
+        {
+            try
+            {
+                for (std::size_t i = 0;; i++)
+                {
+                    {
+                        std::unique_lock lock(mutex);
+                        changed.wait(lock, [&]() { return submitted > i || finished; });
+
+                        if (submitted <= i)
+                            return;
+                    }
+
+                    Chunk& chunk = chunks[i % window];
+                    chunk.done.wait(false, std::memory_order_acquire);
+
+                    if (chunk.error)
+                        std::rethrow_exception(chunk.error);
+
+                    out.write(chunk.results);
+                    failed += chunk.failed;
+                    bool caught_up = false;
+
+                    {
+                        std::lock_guard lock(mutex);
+                        written = i + 1;
+                        caught_up = written == submitted;
+                    }
+                    changed.notify_all();
+
+                    // a streamed input may be slow or endless, so results are written as soon as they are ready
+                    if (streamed && caught_up)
+                        out.flush();
+                }
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+                std::lock_guard lock(mutex);
+                aborted = true;
+                changed.notify_all();
+            }
+        });
+
+        const auto finish = [&]()
+        {
+            {
+                std::lock_guard lock(mutex);
+                finished = true;
+            }
+            changed.notify_all();
+            writer.join();
+        };
+
+        try
+        {
+            while (true)
+            {
+                {
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [&]() { return submitted - written < window || aborted; });
+
+                    if (aborted)
+                        break;
+                }
+
+                // only the splitter modifies `submitted`, and the slot is free once it has been written
+                Chunk& chunk = chunks[submitted % window];
+                const auto lines = input.read(chunk.storage, options.chunk_size);
+
+                if (!lines)
+                    break;
+
+                chunk.lines = *lines;
+                chunk.results.clear();
+                chunk.failed = 0;
+                chunk.error = nullptr;
+                chunk.done.store(false, std::memory_order_relaxed);
+
+                pool.submit([&chunk]()
+                {
+                    try
+                    {
+                        chunk.failed = evaluate_lines(chunk.lines, chunk.results);
+                    }
+                    catch (...)
+                    {
+                        chunk.error = std::current_exception();
+                    }
+                    chunk.done.store(true, std::memory_order_release);
+                    chunk.done.notify_one();
+                });
+
+                {
+                    std::lock_guard lock(mutex);
+                    submitted++;
+                }
+                changed.notify_all();
+            }
+        }
+        catch (...)
+        {
+            finish();
+            throw;
+        }
+
+        finish();
+
+        if (error)
+            std::rethrow_exception(error);
+        return failed;
+    }
+}
+
+std::size_t cli::batch(io::Input& input, io::Output& out, const Options& options)
+{
+    return options.threads > 1
+        ? impl::parallel(input, out, options)
+        : impl::serial(input, out, options);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "io/input.h"
+#include "io/output.h"
+
+#include <cstddef>
+
+namespace cli
+{
+    struct Options
+    {
+        // number of threads evaluating expressions. with a single thread, everything happens on the calling
+        // thread
+        std::size_t threads = 1;
+
+        // approximate number of bytes of input evaluated as a unit by one thread
+        std::size_t chunk_size = std::size_t(1) << 16;
+
+        // maximum number of chunks in flight per thread, bounding the memory used regardless of the length of
+        // the input
+        std::size_t chunks_per_thread = 4;
+    };
+
+    // evaluates each newline-delimited expression of the input, and writes one line per expression to the
+    // output: either the result, or the error as `error at column N: message` where `N` counts from 1. lines
+    // are viewed in place rather than copied if the input is mapped. with several threads, the input is split
+    // into chunks which are evaluated concurrently, and the results are written in the order of the input as
+    // soon as all preceding chunks are done. returns the number of expressions which failed
+    std::size_t batch(io::Input& input, io::Output& out, const Options& options = {});
+}
@@ -0,0 +1,63 @@
+#include "convert.h"
+#include "ast/binary.h"
+#include "ast/print.h"
+#include "parser/parser.h"
+
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+using namespace cli;
+
+std::size_t cli::encode(io::Input& input, io::Output& out)
+{
+    ast::binary::Encoder encoder;
+    std::string storage;
+    std::size_t line_number = 0;
+    std::size_t failed = 0;
+
+    while (const auto chunk = input.read(storage, std::size_t(1) << 16))
+    {
+        std::string_view lines = *chunk;
+
+        while (!lines.empty())
+        {
+            const std::size_t end = lines.find('\n');
+            std::string_view line = lines.substr(0, end);
+            lines.remove_prefix(end == std::string_view::npos ? lines.size() : end + 1);
+            line_number++;
+
+            if (line.ends_with('\r'))
+                line.remove_suffix(1);
+
+            try
+            {
+                encoder.add(parser::parse(line));
+            }
+            catch (const parser::Error& e)
+            {
+                std::fprintf(stderr, "error at line %zu, column %zu: %s\n", line_number, e.column + 1, e.msg.c_str());
+                failed++;
+            }
+        }
+    }
+
+    const std::vector<std::byte> encoded = encoder.finish();
+    out.write({ reinterpret_cast<const char*>(encoded.data()), encoded.size() });
+    return failed;
+}
+
+void cli::decode(io::Input& input, io::Output& out)
+{
+    std::string storage;
+    const std::string_view data = input.read_all(storage);
+    ast::binary::Reader reader(std::as_bytes(std::span(data)));
+    ast::print::Printer printer(out);
+    std::vector<ast::Ast> stack;
+
+    while (auto expression = reader.read())
+    {
+        printer.print(expression->load(stack));
+        out.put('\n');
+    }
+}
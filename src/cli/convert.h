@@ -0,0 +1,17 @@
+#pragma once
+#include "io/input.h"
+#include "io/output.h"
+
+#include <cstddef>
+
+namespace cli
+{
+    // parses each newline-delimited expression of the input, without evaluating it, and writes all of them to
+    // the output in the binary format of `ast::binary`. lines which fail to parse are reported on stderr as
+    // `error at line L, column N: message` and left out. returns the number of lines which failed
+    std::size_t encode(io::Input& input, io::Output& out);
+
+    // reads a file in the binary format of `ast::binary`, and writes each expression in it to the output as a
+    // line of text. throws `ast::binary::Error` if the file is malformed
+    void decode(io::Input& input, io::Output& out);
+}
@@ -0,0 +1,105 @@
+#include "pool.h"
+
+#include <algorithm>
+using namespace cli;
+
+Pool::Pool(std::size_t threads)
+{
+    threads = std::max<std::size_t>(threads, 1);
+
+    for (std::size_t i = 0; i < threads; i++)
+        _queues.push_back(std::make_unique<Queue>());
+
+    for (std::size_t i = 0; i < threads; i++)
+        _threads.emplace_back([this, i]() { work(i); });
+}
+
+Pool::~Pool()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+
+    for (std::thread& thread : _threads)
+        thread.join();
+}
+
+void Pool::submit(Task task)
+{
+    Queue& queue = *_queues[_next];
+    _next = (_next + 1) % _queues.size();
+
+    // counted before the task is visible, such that a worker popping it cannot take the count below zero, and
+    // under the lock such that a worker about to sleep cannot miss it
+    {
+        std::lock_guard lock(_mutex);
+        _pending++;
+    }
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    _wake.notify_one();
+}
+
+std::size_t Pool::size() const
+{
+    return _threads.size();
+}
+
+bool Pool::pop(std::size_t worker, Task& out)
+{
+    // the newest task of the worker's own queue, whose input is most likely still in its cache
+    {
+        Queue& queue = *_queues[worker];
+        std::lock_guard lock(queue.mutex);
+
+        if (!queue.tasks.empty())
+        {
+            out = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            _pending--;
+            return true;
+        }
+    }
+
+    // otherwise the oldest task of another queue, the end its owner doesn't take from. since results are consumed
+    // in the order the tasks were submitted, that is also the task the consumer is most likely waiting for
+    for (std::size_t i = 1; i < _queues.size(); i++)
+    {
+        Queue& queue = *_queues[(worker + i) % _queues.size()];
+        std::lock_guard lock(queue.mutex);
+
+        if (queue.tasks.empty())
+            continue;
+
+        out = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        _pending--;
+        return true;
+    }
+    return false;
+}
+
+void Pool::work(std::size_t worker)
+{
+    Task task;
+
+    while (true)
+    {
+        if (pop(worker, task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock lock(_mutex);
+        _wake.wait(lock, [&]() { return _stopping || _pending > 0; });
+
+        if (_stopping && _pending == 0)
+            return;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cli
+{
+    // fixed-size pool of worker threads with a task deque per worker. tasks are distributed round-robin. a
+    // worker takes the newest task from the back of its own deque, and once it runs dry steals the oldest from
+    // the front of the others', so an uneven mix of cheap and expensive tasks still keeps every worker busy
+    struct Pool
+    {
+        using Task = std::function<void()>;
+
+        explicit Pool(std::size_t threads);
+
+        // waits for all submitted tasks to finish
+        ~Pool();
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        void submit(Task task);
+
+        std::size_t size() const;
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> _queues;
+        std::vector<std::thread> _threads;
+        std::size_t _next = 0;
+
+        // number of tasks in all queues. workers sleep on `_wake` while it is zero
+        std::atomic<std::size_t> _pending = 0;
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        bool _stopping = false;
+
+        bool pop(std::size_t worker, Task& out);
+        void work(std::size_t worker);
+    };
+}
@@ -0,0 +1,81 @@
+#include "rules.h"
+#include "engine/source.h"
+
+#include <cstdio>
+#include <span>
+using namespace cli;
+
+namespace impl
+{
+    // writes the file next to its destination and renames it, such that a concurrent load never maps a
+    // partially written snapshot
+    static void write_file(const std::string& path, std::span<const std::byte> data)
+    {
+        const std::string temporary = path + ".tmp";
+        std::FILE* file = std::fopen(temporary.c_str(), "wb");
+
+        if (!file)
+            return;
+
+        const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+        if (std::fclose(file) == 0 && written)
+            std::rename(temporary.c_str(), path.c_str());
+        else
+            std::remove(temporary.c_str());
+    }
+}
+
+RuleFile RuleFile::load(const std::string& path, const std::optional<std::string>& cache)
+{
+    std::string source_storage;
+    io::Input source_input = io::Input::open(path);
+    const std::string_view source = source_input.read_all(source_storage);
+    const std::uint64_t source_hash = engine::snapshot::hash(source);
+
+    RuleFile out;
+
+    for (const engine::rule::Line& line : engine::rule::lines(source))
+        out._sources.emplace_back(line.text);
+
+    try
+    {
+        if (cache)
+        {
+            out._input = io::Input::open(*cache);
+            const std::string_view data = out._input->read_all(out._storage);
+            out._snapshot.emplace(std::as_bytes(std::span(data)));
+
+            if (out._snapshot->source_hash() == source_hash)
+                return out;
+        }
+    }
+    catch (const io::Error&) {}
+    catch (const engine::snapshot::Error&) {}
+
+    const std::vector<engine::rule::Rule> rules = engine::rule::parse_file(source);
+    out._snapshot.reset();
+    out._input.reset();
+    out._storage.clear();
+    out._compiled = engine::snapshot::write(rules, source_hash);
+    out._snapshot.emplace(out._compiled);
+
+    if (cache)
+        impl::write_file(*cache, out._compiled);
+    return out;
+}
+
+const engine::table::View& RuleFile::view() const
+{
+    return _snapshot->view();
+}
+
+bool RuleFile::cached() const
+{
+    return _input.has_value();
+}
+
+std::span<const std::string> RuleFile::sources() const
+{
+    return _sources;
+}
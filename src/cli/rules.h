@@ -0,0 +1,40 @@
+#pragma once
+#include "engine/snapshot.h"
+#include "engine/table.h"
+#include "io/input.h"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cli
+{
+    // a rule set loaded from a rule file, see `engine/source.h`. given a cache, the compiled rules are kept in
+    // a snapshot at that path, which later loads map in place rather than parsing and indexing the rules again,
+    // as long as the file is unchanged. a missing or stale snapshot is rewritten, and failing to write it only
+    // costs the next load its speed. without a cache, nothing besides the rule file is read or written
+    struct RuleFile
+    {
+        // throws `io::Error` if the file cannot be read, and `engine::rule::SourceError` if it is malformed
+        static RuleFile load(const std::string& path, const std::optional<std::string>& cache = std::nullopt);
+
+        const engine::table::View& view() const;
+
+        // whether the rules were mapped from an up-to-date snapshot rather than compiled
+        bool cached() const;
+
+        // the text of each rule as written in the file, in the order of the table
+        std::span<const std::string> sources() const;
+
+    private:
+        RuleFile() = default;
+
+        std::optional<io::Input> _input;
+        std::string _storage;
+        std::vector<std::byte> _compiled;
+        std::optional<engine::snapshot::Snapshot> _snapshot;
+        std::vector<std::string> _sources;
+    };
+}
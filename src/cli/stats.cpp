@@ -0,0 +1,152 @@
+#include "stats.h"
+
+#include <chrono>
+#include <string_view>
+#include <tuple>
+#include <utility>
+using namespace cli;
+using namespace engine::stats;
+
+namespace impl
+{
+    static double ms(std::chrono::nanoseconds time)
+    {
+        return std::chrono::duration<double, std::milli>(time).count();
+    }
+
+    static void write_escaped(std::FILE* out, std::string_view str)
+    {
+        std::fputc('"', out);
+
+        for (const char c : str)
+        {
+            if (c == '"' || c == '\\')
+                std::fprintf(out, "\\%c", c);
+            else if (static_cast<unsigned char>(c) < 0x20)
+                std::fprintf(out, "\\u%04x", static_cast<unsigned>(c));
+            else
+                std::fputc(c, out);
+        }
+        std::fputc('"', out);
+    }
+
+    static void write_text(std::FILE* out, const Stats& stats, const engine::CacheStats& cache, std::span<const std::string> sources)
+    {
+        // the allocation columns are left out where allocations aren't counted, rather than shown as zeroes
+        const bool allocations = engine::alloc::counting();
+        std::fprintf(out, "%-12s %12s %12s", "phase", "count", "ms");
+
+        if (allocations)
+            std::fprintf(out, " %12s %14s %12s", "allocs", "bytes", "peak bytes");
+        std::fputc('\n', out);
+
+        for (std::size_t i = 0; i < PHASE_COUNT; i++)
+        {
+            const PhaseStats& phase = stats.phases[i];
+            const std::string_view phase_name = name(static_cast<Phase>(i));
+            std::fprintf(out, "%-12.*s %12llu %12.3f", static_cast<int>(phase_name.size()), phase_name.data(),
+                static_cast<unsigned long long>(phase.count), ms(phase.time));
+
+            if (allocations)
+                std::fprintf(out, " %12llu %14llu %12llu", static_cast<unsigned long long>(phase.allocations),
+                    static_cast<unsigned long long>(phase.bytes), static_cast<unsigned long long>(phase.peak));
+            std::fputc('\n', out);
+        }
+
+        std::fprintf(out, "\n%-6s %12s %12s %12s %12s  %s\n",
+            "rule", "attempts", "hits", "match ms", "build ms", "source");
+
+        for (std::size_t i = 0; i < stats.rules.size(); i++)
+        {
+            const RuleStats& rule = stats.rules[i];
+
+            if (!rule.attempts && !rule.hits)
+                continue;
+
+            std::fprintf(out, "%-6zu %12llu %12llu %12.3f %12.3f  %s\n", i,
+                static_cast<unsigned long long>(rule.attempts), static_cast<unsigned long long>(rule.hits),
+                ms(rule.match_time), ms(rule.build_time), i < sources.size() ? sources[i].c_str() : "");
+        }
+
+        const auto used = [](const engine::cache::Stats& stats) { return stats.hits || stats.misses; };
+
+        if (used(cache.strings) || used(cache.subtrees))
+        {
+            std::fprintf(out, "\n%-12s %12s %12s %12s %12s\n", "cache", "hits", "misses", "evictions", "size");
+
+            for (const auto& [name, stats] : { std::pair{ "strings", cache.strings }, std::pair{ "subtrees", cache.subtrees } })
+            {
+                std::fprintf(out, "%-12s %12llu %12llu %12llu %12zu\n", name,
+                    static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+                    static_cast<unsigned long long>(stats.evictions), stats.size);
+            }
+        }
+    }
+
+    static void write_json(std::FILE* out, const Stats& stats, const engine::CacheStats& cache, std::span<const std::string> sources)
+    {
+        const bool allocations = engine::alloc::counting();
+        std::fprintf(out, "{\n  \"phases\": {");
+
+        for (std::size_t i = 0; i < PHASE_COUNT; i++)
+        {
+            const PhaseStats& phase = stats.phases[i];
+            const std::string_view phase_name = name(static_cast<Phase>(i));
+            std::fprintf(out, "%s\n    \"%.*s\": { \"count\": %llu, \"ns\": %lld", i ? "," : "",
+                static_cast<int>(phase_name.size()), phase_name.data(),
+                static_cast<unsigned long long>(phase.count), static_cast<long long>(phase.time.count()));
+
+            if (allocations)
+                std::fprintf(out, ", \"allocations\": %llu, \"bytes\": %llu, \"peak_bytes\": %llu",
+                    static_cast<unsigned long long>(phase.allocations), static_cast<unsigned long long>(phase.bytes),
+                    static_cast<unsigned long long>(phase.peak));
+            std::fprintf(out, " }");
+        }
+        std::fprintf(out, "\n  },\n  \"rules\": [");
+        bool first = true;
+
+        for (std::size_t i = 0; i < stats.rules.size(); i++)
+        {
+            const RuleStats& rule = stats.rules[i];
+
+            if (!rule.attempts && !rule.hits)
+                continue;
+
+            std::fprintf(out, "%s\n    { \"index\": %zu, ", first ? "" : ",", i);
+
+            if (i < sources.size())
+            {
+                std::fprintf(out, "\"source\": ");
+                write_escaped(out, sources[i]);
+                std::fprintf(out, ", ");
+            }
+            std::fprintf(out, "\"attempts\": %llu, \"hits\": %llu, \"match_ns\": %lld, \"build_ns\": %lld }",
+                static_cast<unsigned long long>(rule.attempts), static_cast<unsigned long long>(rule.hits),
+                static_cast<long long>(rule.match_time.count()), static_cast<long long>(rule.build_time.count()));
+            first = false;
+        }
+        std::fprintf(out, "%s],\n", first ? "" : "\n  ");
+        std::fprintf(out, "  \"cache\": {");
+
+        for (const auto& [name, stats, separator] : { std::tuple{ "strings", cache.strings, "," }, std::tuple{ "subtrees", cache.subtrees, "" } })
+        {
+            std::fprintf(out, "\n    \"%s\": { \"hits\": %llu, \"misses\": %llu, \"evictions\": %llu, \"size\": %zu }%s", name,
+                static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+                static_cast<unsigned long long>(stats.evictions), stats.size, separator);
+        }
+        std::fprintf(out, "\n  }\n}\n");
+    }
+}
+
+void cli::write_stats(std::FILE* out, const Stats& stats, const engine::CacheStats& cache, StatsFormat format, std::span<const std::string> sources)
+{
+    switch (format)
+    {
+    case StatsFormat::TEXT:
+        impl::write_text(out, stats, cache, sources);
+        break;
+    case StatsFormat::JSON:
+        impl::write_json(out, stats, cache, sources);
+        break;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "engine/engine.h"
+#include "engine/stats.h"
+
+#include <cstdio>
+#include <span>
+#include <string>
+
+namespace cli
+{
+    enum struct StatsFormat
+    {
+        TEXT,
+        JSON,
+    };
+
+    // writes the statistics of the engine, see `engine::stats`, along with those of its cache. rules are labelled
+    // with their source if given, by index otherwise. rules which were never attempted are left out, as is the
+    // cache in text while it is disabled
+    void write_stats
+    (
+        std::FILE* out,
+        const engine::stats::Stats& stats,
+        const engine::CacheStats& cache,
+        StatsFormat format,
+        std::span<const std::string> sources = {}
+    );
+}
@@ -0,0 +1,64 @@
+#include "alloc.h"
+
+#include <algorithm>
+#include <atomic>
+using namespace engine::alloc;
+
+namespace impl
+{
+    // trivially constructible, such that the first allocation of a thread needs no initialization of its own
+    struct State
+    {
+        std::uint64_t count;
+        std::uint64_t bytes;
+        std::int64_t live;
+        std::int64_t peak;
+    };
+
+    static thread_local State state;
+    static std::atomic<bool> hooked = false;
+}
+
+bool engine::alloc::counting()
+{
+    return impl::hooked.load(std::memory_order_relaxed);
+}
+
+void engine::alloc::allocated(std::size_t bytes)
+{
+    impl::State& state = impl::state;
+    state.count++;
+    state.bytes += bytes;
+    state.live += static_cast<std::int64_t>(bytes);
+    state.peak = std::max(state.peak, state.live);
+
+    if (!impl::hooked.load(std::memory_order_relaxed))
+        impl::hooked.store(true, std::memory_order_relaxed);
+}
+
+void engine::alloc::freed(std::size_t bytes)
+{
+    impl::state.live -= static_cast<std::int64_t>(bytes);
+}
+
+Scope::Scope()
+{
+    impl::State& state = impl::state;
+    _count = state.count;
+    _bytes = state.bytes;
+    _live = state.live;
+    _outer_peak = state.peak;
+    state.peak = state.live;
+}
+
+Scope::~Scope()
+{
+    impl::State& state = impl::state;
+    state.peak = std::max(state.peak, _outer_peak);
+}
+
+Counters Scope::read() const
+{
+    const impl::State& state = impl::state;
+    return { state.count - _count, state.bytes - _bytes, static_cast<std::uint64_t>(state.peak - _live) };
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// heap allocation accounting, to catch copies creeping back into the hot path. allocations are counted by
+// replacements of the global `operator new` and `operator delete` (see `alloc_hooks.cpp`), which are always
+// linked into `biss_bench` and `biss_check`, and into `biss` with the cmake option `BISS_COUNT_ALLOCATIONS`. they are left out
+// by default since they cost every allocation in the process, in which case nothing is counted
+namespace engine::alloc
+{
+    struct Counters
+    {
+        std::uint64_t count = 0;
+        std::uint64_t bytes = 0;
+        // most bytes live at once, beyond those live when the measurement started. blocks are accounted to the
+        // thread allocating or freeing them, so a block freed by another thread is never taken off
+        std::uint64_t peak = 0;
+    };
+
+    // whether the replacements are linked in
+    bool counting();
+
+    // measures the allocations of the calling thread from its construction on. scopes may be nested
+    struct Scope
+    {
+        Scope();
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        Counters read() const;
+
+    private:
+        std::uint64_t _count;
+        std::uint64_t _bytes;
+        std::int64_t _live;
+        // peak of the enclosing scope, restored once this one ends
+        std::int64_t _outer_peak;
+    };
+
+    // called by the replacements for each block allocated and freed
+    void allocated(std::size_t bytes);
+    void freed(std::size_t bytes);
+}
@@ -0,0 +1,100 @@
+#include "alloc.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// replacements of the global `operator new` and `operator delete`, which report to `engine::alloc`. each block
+// is preceded by a header holding its size, since unsized deletes don't tell. built apart from the rest of the
+// engine, see `engine/alloc.h`. the over-aligned forms are left as they are, nothing allocates over-aligned types
+namespace impl
+{
+    constexpr std::size_t HEADER = alignof(std::max_align_t);
+
+    static void* allocate(std::size_t size)
+    {
+        void* const block = std::malloc(HEADER + size);
+
+        if (!block)
+            throw std::bad_alloc();
+
+        *static_cast<std::size_t*>(block) = size;
+        engine::alloc::allocated(size);
+        return static_cast<std::byte*>(block) + HEADER;
+    }
+
+    static void free(void* ptr)
+    {
+        if (!ptr)
+            return;
+
+        void* const block = static_cast<std::byte*>(ptr) - HEADER;
+        engine::alloc::freed(*static_cast<const std::size_t*>(block));
+        std::free(block);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    return impl::allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return impl::allocate(size);
+}
+
+// every form has to be replaced, since the blocks of the replacements can only be freed by the replacements
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return impl::allocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return impl::allocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void* ptr) noexcept
+{
+    impl::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    impl::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    impl::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    impl::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    impl::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    impl::free(ptr);
+}
@@ -0,0 +1,29 @@
+#include "bitset.h"
+#include "eval/batch.h"
+using namespace engine::bitset;
+
+void engine::bitset::scalar(Op op, Word* a, const Word* b, std::size_t n)
+{
+    switch (op)
+    {
+    case Op::AND:
+        for (std::size_t w = 0; w < n; w++)
+            a[w] &= b[w];
+        break;
+    case Op::OR:
+        for (std::size_t w = 0; w < n; w++)
+            a[w] |= b[w];
+        break;
+    case Op::AND_NOT:
+        for (std::size_t w = 0; w < n; w++)
+            a[w] &= ~b[w];
+        break;
+    }
+}
+
+Kernel* engine::bitset::kernel()
+{
+    // the evaluator has already checked whether the cpu supports avx2, see `eval/batch.cpp`
+    static Kernel* const out = AVX2 && eval::batch::supported(eval::batch::Isa::AVX2) ? AVX2 : scalar;
+    return out;
+}
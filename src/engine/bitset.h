@@ -0,0 +1,244 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// kernels applying a bitwise operation to the words of two bitsets. like `eval/kernel.h`, each instruction set
+// has its own translation unit so that it can be compiled with the flags it needs, and the running cpu is only
+// checked once at runtime
+namespace engine::bitset
+{
+    using Word = std::uint64_t;
+
+    enum struct Op
+    {
+        AND,
+        OR,
+        AND_NOT,
+    };
+
+    // `a[i] = a[i] op b[i]` for each of the `n` words
+    using Kernel = void(Op op, Word* a, const Word* b, std::size_t n);
+
+    // a word (64 bits) at a time
+    void scalar(Op op, Word* a, const Word* b, std::size_t n);
+
+    // a vector register (256 bits) at a time, null if the build does not target avx2
+    extern Kernel* const AVX2;
+
+    // the widest kernel supported by both the build and the running cpu. checked once
+    Kernel* kernel();
+}
+
+namespace engine
+{
+    // dynamically sized bitset used for the candidate sets of the matcher. sets of up to `INLINE_BITS` bits
+    // are stored inline to avoid allocating for the common case of calls with only a few arguments, and are
+    // combined a word at a time. larger sets are combined by the widest kernel the cpu supports
+    struct Bitset
+    {
+        using Word = bitset::Word;
+        using Op = bitset::Op;
+
+        static constexpr std::size_t WORD_BITS = 64;
+        static constexpr std::size_t INLINE_WORDS = 2;
+        static constexpr std::size_t INLINE_BITS = INLINE_WORDS * WORD_BITS;
+        static constexpr std::size_t NPOS = SIZE_MAX;
+
+        Bitset() : Bitset(0) {}
+
+        explicit Bitset(std::size_t size, bool value = false) : _size(size), _inline{}
+        {
+            if (size > INLINE_BITS)
+                _heap.resize(word_count());
+            if (value)
+            {
+                std::fill_n(words(), word_count(), ~Word{ 0 });
+                clear_tail();
+            }
+        }
+
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        bool test(std::size_t i) const
+        {
+            assert(i < _size);
+            return (words()[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+        }
+
+        void set(std::size_t i)
+        {
+            assert(i < _size);
+            words()[i / WORD_BITS] |= Word{ 1 } << (i % WORD_BITS);
+        }
+
+        void reset(std::size_t i)
+        {
+            assert(i < _size);
+            words()[i / WORD_BITS] &= ~(Word{ 1 } << (i % WORD_BITS));
+        }
+
+        std::size_t count() const
+        {
+            std::size_t out = 0;
+
+            for (std::size_t w = 0; w < word_count(); w++)
+                out += std::popcount(words()[w]);
+            return out;
+        }
+
+        bool none() const
+        {
+            for (std::size_t w = 0; w < word_count(); w++)
+            {
+                if (words()[w])
+                    return false;
+            }
+            return true;
+        }
+
+        bool any() const
+        {
+            return !none();
+        }
+
+        // returns the index of the first set bit at or after `from`, or `NPOS` if there is none
+        std::size_t next(std::size_t from = 0) const
+        {
+            if (from >= _size)
+                return NPOS;
+
+            std::size_t w = from / WORD_BITS;
+            Word word = words()[w] & (~Word{ 0 } << (from % WORD_BITS));
+
+            while (true)
+            {
+                if (word)
+                    return w * WORD_BITS + std::countr_zero(word);
+                if (++w == word_count())
+                    return NPOS;
+                word = words()[w];
+            }
+        }
+
+        // invokes `f` with the index of each set bit in ascending order. stops early if `f` returns true
+        template<class F>
+        bool find_if(F&& f) const
+        {
+            for (std::size_t w = 0; w < word_count(); w++)
+            {
+                for (Word word = words()[w]; word; word &= word - 1)
+                {
+                    if (f(w * WORD_BITS + std::countr_zero(word)))
+                        return true;
+                }
+            }
+            return false;
+        }
+
+        Bitset& operator&=(const Bitset& other)
+        {
+            return apply<Op::AND>(other);
+        }
+
+        Bitset& operator|=(const Bitset& other)
+        {
+            return apply<Op::OR>(other);
+        }
+
+        // removes all bits set in `other`
+        Bitset& subtract(const Bitset& other)
+        {
+            return apply<Op::AND_NOT>(other);
+        }
+
+        bool is_subset_of(const Bitset& other) const
+        {
+            assert(_size == other._size);
+
+            for (std::size_t w = 0; w < word_count(); w++)
+            {
+                if (words()[w] & ~other.words()[w])
+                    return false;
+            }
+            return true;
+        }
+
+        bool intersects(const Bitset& other) const
+        {
+            assert(_size == other._size);
+
+            for (std::size_t w = 0; w < word_count(); w++)
+            {
+                if (words()[w] & other.words()[w])
+                    return true;
+            }
+            return false;
+        }
+
+        friend bool operator==(const Bitset& a, const Bitset& b)
+        {
+            return a._size == b._size && std::equal(a.words(), a.words() + a.word_count(), b.words());
+        }
+
+    private:
+        std::size_t word_count() const
+        {
+            return (_size + WORD_BITS - 1) / WORD_BITS;
+        }
+
+        Word* words()
+        {
+            return _size > INLINE_BITS ? _heap.data() : _inline;
+        }
+
+        const Word* words() const
+        {
+            return _size > INLINE_BITS ? _heap.data() : _inline;
+        }
+
+        void clear_tail()
+        {
+            if (const std::size_t bits = _size % WORD_BITS)
+                words()[word_count() - 1] &= (Word{ 1 } << bits) - 1;
+        }
+
+        template<Op OP>
+        static Word apply_word(Word a, Word b)
+        {
+            if constexpr (OP == Op::AND)
+                return a & b;
+            else if constexpr (OP == Op::OR)
+                return a | b;
+            else
+                return a & ~b;
+        }
+
+        template<Op OP>
+        Bitset& apply(const Bitset& other)
+        {
+            assert(_size == other._size);
+            Word* a = words();
+            const Word* b = other.words();
+            const std::size_t n = word_count();
+
+            if (n > INLINE_WORDS)
+            {
+                bitset::kernel()(OP, a, b, n);
+                return *this;
+            }
+            for (std::size_t w = 0; w < n; w++)
+                a[w] = apply_word<OP>(a[w], b[w]);
+            return *this;
+        }
+
+        std::size_t _size;
+        Word _inline[INLINE_WORDS];
+        std::vector<Word> _heap;
+    };
+}
@@ -0,0 +1,55 @@
+#include "bitset.h"
+
+// compiled with avx2 enabled when targeting x86, see `CMakeLists.txt`. only reached once the running cpu has
+// been checked to support it, and instantiates none of the inline functions of `bitset.h`
+#if defined(__AVX2__)
+#include <immintrin.h>
+using namespace engine::bitset;
+
+namespace
+{
+    template<Op OP>
+    void apply(Word* a, const Word* b, std::size_t n)
+    {
+        std::size_t w = 0;
+
+        for (; w + 4 <= n; w += 4)
+        {
+            const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + w));
+            const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + w));
+            __m256i vr;
+
+            if constexpr (OP == Op::AND)
+                vr = _mm256_and_si256(va, vb);
+            else if constexpr (OP == Op::OR)
+                vr = _mm256_or_si256(va, vb);
+            else
+                vr = _mm256_andnot_si256(vb, va);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + w), vr);
+        }
+        for (; w < n; w++)
+        {
+            if constexpr (OP == Op::AND)
+                a[w] &= b[w];
+            else if constexpr (OP == Op::OR)
+                a[w] |= b[w];
+            else
+                a[w] &= ~b[w];
+        }
+    }
+
+    void avx2(Op op, Word* a, const Word* b, std::size_t n)
+    {
+        switch (op)
+        {
+        case Op::AND:     apply<Op::AND>(a, b, n);     break;
+        case Op::OR:      apply<Op::OR>(a, b, n);      break;
+        case Op::AND_NOT: apply<Op::AND_NOT>(a, b, n); break;
+        }
+    }
+}
+
+Kernel* const engine::bitset::AVX2 = avx2;
+#else
+engine::bitset::Kernel* const engine::bitset::AVX2 = nullptr;
+#endif
@@ -0,0 +1,110 @@
+#include "bytecode.h"
+#include "match.h"
+
+#include <array>
+#include <format>
+using namespace engine::bytecode;
+
+namespace impl
+{
+    namespace pd = engine::predicate;
+
+    static void count_tags(const pd::Predicate& predicate, std::array<std::uint8_t, 256>& counts)
+    {
+        predicate.visit
+        (
+            [&](const pd::Tag& p)
+            {
+                counts[p.tag]++;
+                count_tags(*p.nested, counts);
+            },
+            [&](const pd::Call& p)
+            {
+                for (const pd::Predicate& arg : p.args)
+                    count_tags(arg, counts);
+            },
+            [](const auto&) {}
+        );
+    }
+
+    static void emit(Program& program, const pd::Predicate& predicate, const std::array<std::uint8_t, 256>& counts)
+    {
+        predicate.visit
+        (
+            [&](const pd::Any&)
+            {
+                program.code.push_back({ .op = Op::ANY });
+            },
+            [&](const pd::Literal& p)
+            {
+                program.code.push_back({ .op = Op::CHECK_LITERAL, .has_value = p.value.has_value(), .value = p.value.value_or(0.0) });
+            },
+            [&](const pd::Variable&)
+            {
+                program.code.push_back({ .op = Op::CHECK_VARIABLE });
+            },
+            [&](const pd::Tag& p)
+            {
+                const Op op = counts[p.tag] > 1 ? Op::COMPARE_TAG : Op::BIND_TAG;
+                program.code.push_back({ .op = op, .tag = p.tag });
+                emit(program, *p.nested, counts);
+            },
+            [&](const pd::Call& p)
+            {
+                const auto arity = static_cast<std::uint32_t>(p.args.size());
+                const auto offset = static_cast<std::uint32_t>(program.args.size());
+
+                program.code.push_back
+                ({
+                    .op = Op::CHECK_HEAD,
+                    .extensible = engine::match::extensible(p.fn),
+                    .arity = arity,
+                    .operand = offset,
+                    .function = ast::function::index(p.fn),
+                });
+                program.args.resize(program.args.size() + arity);
+
+                for (std::uint32_t i = 0; i < arity; i++)
+                {
+                    program.args[offset + i] = static_cast<std::uint32_t>(program.code.size());
+                    emit(program, p.args[i], counts);
+                }
+            }
+        );
+    }
+}
+
+Program engine::bytecode::compile(const predicate::Predicate& predicate)
+{
+    std::array<std::uint8_t, 256> counts{};
+    impl::count_tags(predicate, counts);
+
+    Program program;
+    impl::emit(program, predicate, counts);
+    return program;
+}
+
+std::string View::disassemble() const
+{
+    std::string out;
+
+    for (std::size_t pc = 0; pc < code.size(); pc++)
+    {
+        const Instruction& in = code[pc];
+        const std::string operands = [&]() -> std::string
+        {
+            switch (in.op)
+            {
+            case Op::ANY:            return "ANY";
+            case Op::CHECK_LITERAL:  return in.has_value ? std::format("CHECK_LITERAL {}", in.value) : "CHECK_LITERAL";
+            case Op::CHECK_VARIABLE: return "CHECK_VARIABLE";
+            case Op::BIND_TAG:       return std::format("BIND_TAG {}", in.tag);
+            case Op::COMPARE_TAG:    return std::format("COMPARE_TAG {}", in.tag);
+            case Op::CHECK_HEAD:     return std::format("CHECK_HEAD {} {}{} @{}", in.fn()->identifier, in.arity, in.extensible ? "+" : "", in.operand);
+            }
+            return "?";
+        }();
+        out += std::format("{:>4}  {}\n", pc, operands);
+    }
+    return out;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "engine/predicate.h"
+#include "ast/function.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engine::bytecode
+{
+    enum struct Op : std::uint8_t
+    {
+        // matches any expression
+        ANY,
+        // expression must be a literal, and equal to `value` if `has_value`
+        CHECK_LITERAL,
+        // expression must be a variable
+        CHECK_VARIABLE,
+        // binds the expression matched by the following node to `tag`, which occurs only once in the predicate
+        BIND_TAG,
+        // binds the expression matched by the following node to `tag` the first time it is encountered, and
+        // compares against the bound expression every subsequent time. emitted for every occurrence of a tag
+        // which is repeated in the predicate, since the order the occurrences are visited in is only known
+        // once candidates have been assigned
+        COMPARE_TAG,
+        // expression must be a call of `fn` with `arity` arguments, or more if `extensible` (see
+        // `match::extensible`). `operand` is the offset into `Program::args` of the entry points of each
+        // argument predicate, whose code follows
+        CHECK_HEAD,
+    };
+
+    struct Instruction
+    {
+        Op op;
+        std::uint8_t tag = 0;
+        bool has_value = false;
+        bool extensible = false;
+        std::uint32_t arity = 0;
+        std::uint32_t operand = 0;
+        // index of `fn` in `ast::function::ARRAY`, which keeps instructions free of pointers such that compiled
+        // rules can be stored in a file and mapped back in place, see `snapshot.h`
+        std::uint32_t function = 0;
+        double value = 0.0;
+
+        constexpr const ast::function::Function* fn() const
+        {
+            return &ast::function::ARRAY[function];
+        }
+    };
+
+    // non-owning view of a compiled predicate, either a `Program` or a slice of a static rule table (see
+    // `table.h`)
+    struct View
+    {
+        std::span<const Instruction> code;
+        std::span<const std::uint32_t> args;
+
+        std::string disassemble() const;
+    };
+
+    // a predicate compiled into a linear instruction stream in pre-order. every predicate node begins at an
+    // index into `code`, its entry point, and the entry points of the arguments of each call are stored
+    // contiguously in `args` such that the matcher can address them in any order. the stream is a flat layout
+    // of the predicate tree which the matchers walk by entry point, not code run by an interpreter
+    struct Program
+    {
+        std::vector<Instruction> code;
+        std::vector<std::uint32_t> args;
+
+        View view() const
+        {
+            return { code, args };
+        }
+
+        std::string disassemble() const
+        {
+            return view().disassemble();
+        }
+    };
+
+    Program compile(const predicate::Predicate& predicate);
+}
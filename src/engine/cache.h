@@ -0,0 +1,179 @@
+#pragma once
+#include "utility.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace engine::cache
+{
+    struct Stats
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        std::size_t size = 0;
+    };
+
+    // size-bounded concurrent map. entries are spread over shards by hash, each guarded by its own lock, so
+    // that threads rarely contend. each shard evicts using the CLOCK policy: entries sit on a ring with a
+    // reference bit set whenever they are found, and the hand sweeping the ring for a victim clears the bits it
+    // passes over, so recently used entries survive one more revolution. this approximates LRU without having
+    // to reorder a list on every hit.
+    //
+    // `Hash` and `Equal` may be transparent to allow lookups with a cheaper key type, e.g. `std::string_view`
+    // for `std::string` keys
+    template<class Key, class Value, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>>
+    struct Cache
+    {
+        // `capacity` is the total number of entries, divided between the shards as evenly as possible such that
+        // their capacities add up to it. a shard holds at least one entry
+        explicit Cache(std::size_t capacity, std::size_t shards = 64)
+        {
+            shards = std::max<std::size_t>(std::min(shards, capacity), 1);
+            const std::size_t per_shard = capacity / shards;
+            const std::size_t remainder = capacity % shards;
+
+            for (std::size_t i = 0; i < shards; i++)
+                _shards.push_back(std::make_unique<Shard>(std::max<std::size_t>(per_shard + (i < remainder), 1)));
+        }
+
+        // total number of entries held at most
+        std::size_t capacity() const
+        {
+            std::size_t out = 0;
+
+            for (const auto& shard : _shards)
+                out += shard->capacity;
+            return out;
+        }
+
+        template<class K>
+        std::optional<Value> find(const K& key)
+        {
+            Shard& shard = shard_of(key);
+            std::lock_guard lock(shard.mutex);
+            const auto it = shard.index.find(key);
+
+            if (it == shard.index.end())
+            {
+                shard.misses++;
+                return std::nullopt;
+            }
+            Slot& slot = shard.ring[it->second];
+            slot.referenced = true;
+            shard.hits++;
+            return slot.value;
+        }
+
+        // inserts an entry, or replaces the value of an existing one
+        void insert(Key key, Value value)
+        {
+            Shard& shard = shard_of(key);
+            std::lock_guard lock(shard.mutex);
+
+            if (const auto it = shard.index.find(key); it != shard.index.end())
+            {
+                Slot& slot = shard.ring[it->second];
+                slot.value = std::move(value);
+                slot.referenced = true;
+                return;
+            }
+
+            std::size_t position = shard.ring.size();
+
+            if (position == shard.capacity)
+            {
+                while (shard.ring[shard.hand].referenced)
+                {
+                    shard.ring[shard.hand].referenced = false;
+                    shard.hand = (shard.hand + 1) % shard.capacity;
+                }
+                position = shard.hand;
+                shard.hand = (shard.hand + 1) % shard.capacity;
+                shard.index.erase(shard.ring[position].entry);
+                shard.evictions++;
+            }
+            else
+            {
+                shard.ring.emplace_back();
+            }
+
+            const auto entry = shard.index.emplace(std::move(key), position).first;
+            shard.ring[position] = Slot{ entry, std::move(value), false };
+        }
+
+        void clear()
+        {
+            for (const auto& shard : _shards)
+            {
+                std::lock_guard lock(shard->mutex);
+                shard->index.clear();
+                shard->ring.clear();
+                shard->hand = 0;
+            }
+        }
+
+        Stats stats() const
+        {
+            Stats out;
+
+            for (const auto& shard : _shards)
+            {
+                std::lock_guard lock(shard->mutex);
+                out.hits += shard->hits;
+                out.misses += shard->misses;
+                out.evictions += shard->evictions;
+                out.size += shard->ring.size();
+            }
+            return out;
+        }
+
+    private:
+        using Index = std::unordered_map<Key, std::size_t, Hash, Equal>;
+
+        struct Slot
+        {
+            typename Index::iterator entry;
+            Value value;
+            bool referenced = false;
+        };
+
+        struct Shard
+        {
+            explicit Shard(std::size_t capacity) : capacity(capacity)
+            {
+                // the index never holds more than `capacity` entries, so it is never rehashed and the iterators
+                // held by the ring stay valid
+                index.reserve(capacity);
+                ring.reserve(capacity);
+            }
+
+            mutable std::mutex mutex;
+            const std::size_t capacity;
+            Index index;
+            std::vector<Slot> ring;
+            std::size_t hand = 0;
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t evictions = 0;
+        };
+
+        std::vector<std::unique_ptr<Shard>> _shards;
+
+        template<class K>
+        Shard& shard_of(const K& key)
+        {
+            // rehashed since the low bits of e.g. `std::hash` may be poorly distributed, and are what the index
+            // of the shard uses as well
+            const std::uint64_t hash = hash_mix(static_cast<std::uint64_t>(Hash{}(key)));
+            return *_shards[(hash >> 32) % _shards.size()];
+        }
+    };
+}
@@ -0,0 +1,832 @@
+#include "egraph.h"
+#include "stats.h"
+#include "eval/op.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <queue>
+#include <utility>
+using namespace engine::egraph;
+using namespace ast::prelude;
+using namespace function::prelude;
+
+namespace impl
+{
+    namespace bc = engine::bytecode;
+
+    constexpr Id UNBOUND = std::numeric_limits<Id>::max();
+
+    // the matcher checks the clock once per this many steps, since a single class may take long to match
+    // against a wide call
+    constexpr std::size_t STEPS_PER_CLOCK = 4096;
+
+    using Clock = std::chrono::steady_clock;
+
+    // a way the predicate of a rule matches a class. if the predicate only consumed some of the arguments of a
+    // flattened call, `rest` holds those left over, which are carried over to the rewritten node like
+    // `engine::rule::replace` does
+    struct Match
+    {
+        std::uint32_t rule;
+        Id id;
+        std::vector<std::pair<std::uint8_t, Id>> tags;
+        std::uint32_t function = 0;
+        std::vector<Id> rest;
+    };
+
+    // finds every way a compiled predicate (see `bytecode.h`) matches a class. unlike `engine::match`, a
+    // predicate matches a class if it matches any of the expressions the class stands for, so each choice of
+    // node for a call is searched in turn. the work still to be done is kept on a stack of goals: predicates
+    // yet to be matched against a class, and calls with arguments yet to be assigned
+    struct Matcher
+    {
+        const EGraph& graph;
+        bc::View program;
+        // arguments of the top-level predicate in the order they are assigned, most selective first
+        std::span<const std::size_t> pivots;
+        std::vector<Match>& out;
+        std::size_t budget;
+        Clock::time_point deadline;
+
+        std::uint32_t rule = 0;
+        Id root = 0;
+        bool expired = false;
+        std::size_t steps = 0;
+        std::array<Id, 256> tags = {};
+
+        struct Assignment
+        {
+            std::uint32_t pc;
+            const Node* node;
+            // whether this is the top-level call, and whether it may leave arguments unassigned
+            bool top;
+            bool partial;
+            std::size_t next;
+            std::vector<bool> used;
+        };
+
+        struct Goal
+        {
+            std::uint32_t pc;
+            Id id;
+            // index into `assignments` for a call with arguments left to assign, in which case `pc` and `id`
+            // are unused
+            std::size_t assignment;
+        };
+
+        static constexpr std::size_t MATCH = std::numeric_limits<std::size_t>::max();
+
+        std::vector<Goal> goals = {};
+        std::vector<Assignment> assignments = {};
+
+        void run(std::uint32_t rule, bc::View program, std::span<const std::size_t> pivots, Id id)
+        {
+            this->rule = rule;
+            this->program = program;
+            this->pivots = pivots;
+            root = id;
+            tags.fill(UNBOUND);
+            goals.assign(1, { 0, id, MATCH });
+            assignments.clear();
+            solve();
+        }
+
+        bool done() const
+        {
+            return expired || out.size() >= budget;
+        }
+
+        void emit()
+        {
+            Match& match = out.emplace_back(Match{ rule, root, {}, 0, {} });
+
+            for (std::size_t tag = 0; tag < tags.size(); tag++)
+            {
+                if (tags[tag] != UNBOUND)
+                    match.tags.emplace_back(static_cast<std::uint8_t>(tag), tags[tag]);
+            }
+
+            // the top-level call is the first assignment, and is only partial if the predicate is extensible
+            if (!assignments.empty() && assignments[0].partial)
+            {
+                const Assignment& top = assignments[0];
+                match.function = top.node->index;
+
+                for (std::size_t i = 0; i < top.node->args.size(); i++)
+                {
+                    if (!top.used[i])
+                        match.rest.push_back(top.node->args[i]);
+                }
+            }
+        }
+
+        bool exists(Id id, auto&& pred) const
+        {
+            for (const std::uint32_t index : graph.nodes(id))
+            {
+                if (pred(graph.node(index)))
+                    return true;
+            }
+            return false;
+        }
+
+        // continues with the remaining goals
+        void solve()
+        {
+            if (done())
+                return;
+
+            if (++steps % STEPS_PER_CLOCK == 0 && Clock::now() > deadline)
+            {
+                expired = true;
+                return;
+            }
+
+            if (goals.empty())
+            {
+                emit();
+                return;
+            }
+
+            const Goal goal = goals.back();
+            goals.pop_back();
+
+            if (goal.assignment == MATCH)
+                match(goal.pc, goal.id);
+            else
+                assign(goal.assignment);
+            goals.push_back(goal);
+        }
+
+        void match(std::uint32_t pc, Id id)
+        {
+            const bc::Instruction& in = program.code[pc];
+
+            switch (in.op)
+            {
+            case bc::Op::ANY:
+                solve();
+                break;
+            case bc::Op::CHECK_LITERAL:
+            {
+                const auto literal = [&](const Node& node)
+                {
+                    return node.kind == Kind::LITERAL && (!in.has_value || double_equality(in.value, node.value));
+                };
+                if (exists(id, literal))
+                    solve();
+                break;
+            }
+            case bc::Op::CHECK_VARIABLE:
+                if (exists(id, [](const Node& node) { return node.kind == Kind::VARIABLE; }))
+                    solve();
+                break;
+            case bc::Op::BIND_TAG:
+            case bc::Op::COMPARE_TAG:
+            {
+                Id& bound = tags[in.tag];
+
+                if (bound != UNBOUND && graph.find(bound) != graph.find(id))
+                    break;
+
+                const Id previous = bound;
+                bound = id;
+                goals.push_back({ pc + 1, id, MATCH });
+                solve();
+                goals.pop_back();
+                bound = previous;
+                break;
+            }
+            case bc::Op::CHECK_HEAD:
+            {
+                const std::uint32_t arity = in.arity;
+                const bool extensible = in.extensible;
+                const bool top = pc == engine::table::Lowering::untag(program.code, 0);
+
+                for (const std::uint32_t index : graph.nodes(id))
+                {
+                    const Node& node = graph.node(index);
+                    const std::size_t n = node.args.size();
+
+                    if (done())
+                        return;
+                    if (node.kind != Kind::CALL || node.index != in.function)
+                        continue;
+                    if (n != arity && !(top && extensible && n > arity))
+                        continue;
+
+                    assignments.push_back({ pc, &node, top, n > arity, 0, std::vector<bool>(n) });
+                    goals.push_back({ 0, 0, assignments.size() - 1 });
+                    solve();
+                    goals.pop_back();
+                    assignments.pop_back();
+                }
+                break;
+            }
+            default:
+                assert(false && "not an entry point");
+                break;
+            }
+        }
+
+        // assigns the next argument of a predicate call to an argument of the node. positional for calls which
+        // aren't commutative, and to any argument not assigned yet otherwise, except that the first argument
+        // of `Commutativity::TAIL` calls stays in place
+        void assign(std::size_t a)
+        {
+            // the assignments may grow while solving, so they are indexed anew each time
+            const std::uint32_t pc = assignments[a].pc;
+            const std::size_t arity = program.code[pc].arity;
+            const std::size_t next = assignments[a].next;
+
+            if (next == arity)
+            {
+                solve();
+                return;
+            }
+
+            const std::size_t i = assignments[a].top && pivots.size() == arity ? pivots[next] : next;
+            const std::uint32_t entry = program.args[program.code[pc].operand + i];
+            const Node& node = *assignments[a].node;
+            const Commutativity commutativity = node.fn()->commutativity;
+
+            const auto attempt = [&](std::size_t j)
+            {
+                assignments[a].used[j] = true;
+                assignments[a].next++;
+                goals.push_back({ 0, 0, a });
+                goals.push_back({ entry, node.args[j], MATCH });
+                solve();
+                goals.pop_back();
+                goals.pop_back();
+                assignments[a].next--;
+                assignments[a].used[j] = false;
+            };
+
+            if (commutativity == Commutativity::NONE || (commutativity == Commutativity::TAIL && i == 0))
+            {
+                if (!assignments[a].used[i])
+                    attempt(i);
+                return;
+            }
+
+            const std::size_t first = commutativity == Commutativity::TAIL ? 1 : 0;
+
+            for (std::size_t j = first; j < node.args.size() && !done(); j++)
+            {
+                // equal arguments are interchangeable, and commutative arguments are sorted, so only the first
+                // of a run of equal ones is tried. the first argument of a tail call is not among them, even if
+                // it equals the second
+                const bool repeated = j > first && !assignments[a].used[j - 1] && node.args[j - 1] == node.args[j];
+
+                if (!assignments[a].used[j] && !repeated)
+                    attempt(j);
+            }
+        }
+    };
+}
+
+double engine::egraph::cost::size(const Node&)
+{
+    return 1.0;
+}
+
+double engine::egraph::cost::evaluation(const Node& node)
+{
+    if (node.kind != Kind::CALL)
+        return 1.0;
+
+    const double weight = [&]()
+    {
+        switch (eval::lower(node.fn()).op)
+        {
+        case eval::Op::POW:  return 16.0;
+        case eval::Op::DIV:
+        case eval::Op::MOD:
+        case eval::Op::SQRT: return 8.0;
+        case eval::Op::MUL:  return 2.0;
+        default:             return 1.0;
+        }
+    }();
+
+    // a call of `n` arguments is evaluated as `n - 1` operations, see `eval::Fold`
+    return weight * static_cast<double>(std::max<std::size_t>(node.args.size(), 2) - 1);
+}
+
+std::size_t EGraph::NodeHash::operator()(const Node& node) const
+{
+    std::uint64_t out = hash_combine(static_cast<std::uint64_t>(node.kind), node.index);
+    out = hash_combine(out, std::bit_cast<std::uint64_t>(node.value));
+
+    for (const Id arg : node.args)
+        out = hash_combine(out, arg);
+    return static_cast<std::size_t>(out);
+}
+
+bool EGraph::NodeEqual::operator()(const Node& a, const Node& b) const
+{
+    return a.kind == b.kind && a.index == b.index && a.args == b.args
+        && std::bit_cast<std::uint64_t>(a.value) == std::bit_cast<std::uint64_t>(b.value);
+}
+
+Id EGraph::add(const ast::Ast& ast)
+{
+    // postfix order, like `ast::binary::Encoder`; the classes of the arguments are pending on `ids` until
+    // their call is added
+    std::vector<std::pair<const Ast*, bool>> stack{ { &ast, false } };
+    std::vector<Id> ids;
+
+    while (!stack.empty())
+    {
+        const auto [next, expanded] = stack.back();
+        stack.pop_back();
+
+        next->visit
+        (
+            [&](const Call& call)
+            {
+                if (!expanded)
+                {
+                    stack.emplace_back(next, true);
+
+                    for (auto it = call.args.rbegin(); it != call.args.rend(); ++it)
+                        stack.emplace_back(&*it, false);
+                    return;
+                }
+
+                const auto first = ids.end() - static_cast<std::ptrdiff_t>(call.args.size());
+                Node node{ Kind::CALL, function::index(call.fn), 0.0, std::vector<Id>(first, ids.end()) };
+                ids.erase(first, ids.end());
+                ids.push_back(add(std::move(node)));
+            },
+            [&](const Literal& literal)
+            {
+                ids.push_back(add(Node{ Kind::LITERAL, 0, literal.value, {} }));
+            },
+            [&](const Variable& variable)
+            {
+                ids.push_back(add(Node{ Kind::VARIABLE, identifier(variable.identifier), 0.0, {} }));
+            }
+        );
+    }
+    return ids.back();
+}
+
+Id EGraph::find(Id id) const
+{
+    // path halving
+    while (_parents[id] != id)
+    {
+        _parents[id] = _parents[_parents[id]];
+        id = _parents[id];
+    }
+    return id;
+}
+
+bool EGraph::merge(Id a, Id b)
+{
+    a = find(a);
+    b = find(b);
+
+    if (a == b)
+        return false;
+
+    // the class with fewer nodes and uses is merged into the other, such that each is moved a logarithmic
+    // number of times
+    if (_classes[a].nodes.size() + _classes[a].uses.size() < _classes[b].nodes.size() + _classes[b].uses.size())
+        std::swap(a, b);
+
+    // the nodes using `a` still refer to a class which hasn't been merged into another, so only those using
+    // `b` have to be repaired
+    _parents[b] = a;
+    Class& into = _classes[a];
+    Class& from = _classes[b];
+    into.nodes.insert(into.nodes.end(), from.nodes.begin(), from.nodes.end());
+    into.uses.insert(into.uses.end(), from.uses.begin(), from.uses.end());
+    _pending.insert(_pending.end(), from.uses.begin(), from.uses.end());
+    from = Class{};
+    return true;
+}
+
+void EGraph::repair(std::uint32_t index, std::vector<Id>& touched)
+{
+    Node& node = _nodes[index];
+
+    if (const auto it = _memo.find(node); it != _memo.end() && it->second == index)
+        _memo.erase(it);
+    canonicalize(node);
+
+    const auto [it, inserted] = _memo.try_emplace(node, index);
+    touched.push_back(_owners[index]);
+
+    // congruence: the node became equal to another one, so their classes are equal too
+    if (!inserted && it->second != index)
+        merge(_owners[index], _owners[it->second]);
+}
+
+void EGraph::rebuild()
+{
+    std::vector<std::uint32_t> todo;
+    std::vector<Id> touched;
+
+    // repairing may merge further classes, whose uses are repaired in the next round
+    while (!_pending.empty())
+    {
+        todo.swap(_pending);
+        _pending.clear();
+        std::ranges::sort(todo);
+        todo.erase(std::unique(todo.begin(), todo.end()), todo.end());
+
+        for (const std::uint32_t index : todo)
+            repair(index, touched);
+    }
+
+    // drops the nodes which have become duplicates of others, and repeated uses
+    for (Id& id : touched)
+        id = find(id);
+    std::ranges::sort(touched);
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    for (const Id id : touched)
+    {
+        Class& cls = _classes[id];
+        std::erase_if(cls.nodes, [&](std::uint32_t index) { return _memo.find(_nodes[index])->second != index; });
+        std::ranges::sort(cls.nodes);
+        cls.nodes.erase(std::unique(cls.nodes.begin(), cls.nodes.end()), cls.nodes.end());
+        std::ranges::sort(cls.uses);
+        cls.uses.erase(std::unique(cls.uses.begin(), cls.uses.end()), cls.uses.end());
+    }
+}
+
+Stats EGraph::saturate(const table::View& rules, const Limits& limits)
+{
+    const impl::Clock::time_point deadline = impl::Clock::now() + limits.max_time;
+    Stats stats;
+    std::vector<impl::Match> matches;
+    std::vector<std::uint32_t> candidates;
+    std::vector<double> literals;
+    std::vector<Id> built;
+    std::array<Id, 256> tags;
+
+    impl::Matcher matcher{ *this, {}, {}, matches, limits.max_matches, deadline };
+
+    // a rule is attempted once per class, and hits once per match applied, see `stats::RuleStats`
+    const bool counted = stats::enabled();
+    const auto now = [&] { return counted ? impl::Clock::now() : impl::Clock::time_point{}; };
+
+    // adds the expression described by the result nodes of a rule, like `table::View::apply` builds it. the
+    // nodes are in prefix order, so they are added in reverse with the classes of the arguments pending
+    const auto build = [&](std::span<const table::result::Node> result)
+    {
+        built.clear();
+
+        for (auto it = result.rbegin(); it != result.rend(); ++it)
+        {
+            switch (it->kind)
+            {
+            case table::result::Kind::TAG:
+                assert(tags[it->tag] != impl::UNBOUND && "result refers to a tag not bound by the predicate");
+                built.push_back(tags[it->tag]);
+                break;
+            case table::result::Kind::LITERAL:
+                built.push_back(add(Node{ Kind::LITERAL, 0, it->value, {} }));
+                break;
+            case table::result::Kind::VARIABLE:
+                built.push_back(add(Node{ Kind::VARIABLE, identifier(rules.names[it->name]), 0.0, {} }));
+                break;
+            case table::result::Kind::CALL:
+            {
+                Node node{ Kind::CALL, it->function, 0.0, {} };
+
+                for (std::uint32_t i = 0; i < it->arity; i++)
+                {
+                    node.args.push_back(built.back());
+                    built.pop_back();
+                }
+                built.push_back(add(std::move(node)));
+                break;
+            }
+            }
+        }
+        return built.back();
+    };
+
+    while (true)
+    {
+        if (stats.iterations == limits.max_iterations)
+        {
+            stats.stop = Stop::ITERATIONS;
+            break;
+        }
+        if (size() >= limits.max_nodes)
+        {
+            stats.stop = Stop::NODES;
+            break;
+        }
+        if (impl::Clock::now() > deadline)
+        {
+            stats.stop = Stop::TIME;
+            break;
+        }
+        stats.iterations++;
+        matches.clear();
+
+        // all matches are found before any is applied, such that the graph isn't altered while it is searched.
+        // the rules attempted on a class are the candidates of any of its nodes, see `table::View::candidates`
+        const std::size_t class_count = _classes.size();
+
+        for (Id id = 0; id < class_count && !matcher.done(); id++)
+        {
+            if (find(id) != id)
+                continue;
+
+            candidates.clear();
+
+            for (const std::uint32_t index : _classes[id].nodes)
+            {
+                const Node& node = _nodes[index];
+                literals.clear();
+
+                switch (node.kind)
+                {
+                case Kind::CALL:
+                    // an argument matches a literal if its class holds one
+                    for (const Id arg : node.args)
+                    {
+                        for (const std::uint32_t member : _classes[find(arg)].nodes)
+                        {
+                            if (_nodes[member].kind == Kind::LITERAL)
+                                literals.push_back(_nodes[member].value);
+                        }
+                    }
+                    rules.candidates(node.index, node.args.size(), literals, candidates);
+                    break;
+                case Kind::LITERAL:
+                    rules.candidates(table::LITERALS, 0, std::span(&node.value, 1), candidates);
+                    break;
+                case Kind::VARIABLE:
+                    rules.candidates(table::VARIABLES, 0, {}, candidates);
+                    break;
+                }
+            }
+            std::ranges::sort(candidates);
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+            for (const std::uint32_t rule : candidates)
+            {
+                const table::Entry& entry = rules.rules[rule];
+                const impl::Clock::time_point start = now();
+                matcher.run(rule, rules.program(rule), rules.pivots.subspan(entry.pivots, entry.pivot_count), id);
+
+                if (counted)
+                    stats::record(rule, 1, 0, impl::Clock::now() - start, {});
+            }
+        }
+        stats.matches += matches.size();
+
+        // the matches found before running out of time are still applied
+        const std::size_t nodes = size();
+        bool merged = false;
+        std::size_t applied = 0;
+
+        for (; applied < matches.size() && size() < limits.max_nodes; applied++)
+        {
+            const impl::Match& match = matches[applied];
+
+            if (applied % impl::STEPS_PER_CLOCK == 0 && impl::Clock::now() > deadline)
+                break;
+
+            const table::Entry& entry = rules.rules[match.rule];
+            const impl::Clock::time_point start = now();
+            tags.fill(impl::UNBOUND);
+
+            for (const auto& [tag, id] : match.tags)
+                tags[tag] = id;
+
+            Id out = build(rules.results.subspan(entry.result, entry.result_size));
+
+            if (!match.rest.empty())
+            {
+                Node node{ Kind::CALL, match.function, 0.0, { out } };
+                node.args.insert(node.args.end(), match.rest.begin(), match.rest.end());
+                out = add(std::move(node));
+            }
+            merged |= merge(match.id, out);
+
+            if (counted)
+                stats::record(match.rule, 0, 1, {}, impl::Clock::now() - start);
+        }
+        rebuild();
+
+        if (applied == matches.size() && !merged && size() == nodes)
+        {
+            stats.stop = Stop::SATURATED;
+            break;
+        }
+    }
+
+    stats.nodes = size();
+    stats.classes = classes();
+    return stats;
+}
+
+Ast EGraph::extract(Id id, const Cost& cost) const
+{
+    // the cheapest node of each class is found cheapest first, like paths in dijkstra's algorithm: a node can
+    // be costed once the cheapest nodes of all its arguments are known, and since costs are positive, the
+    // cheapest node not yet chosen for its class is the cheapest the class has
+    constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+    const Id target = find(id);
+
+    std::vector<double> costs(_classes.size(), 0.0);
+    std::vector<std::uint32_t> best(_classes.size(), NONE);
+    // number of distinct argument classes of each node not chosen yet, or `NONE` for dropped nodes
+    std::vector<std::uint32_t> remaining(_nodes.size(), NONE);
+    // last class whose choice has been counted for each node, since a node may use a class several times
+    std::vector<Id> counted(_nodes.size(), impl::UNBOUND);
+
+    using Entry = std::pair<double, std::uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+
+    const auto push = [&](std::uint32_t index)
+    {
+        const Node& node = _nodes[index];
+        double total = cost(node);
+        assert(total > 0.0 && "costs have to be positive");
+
+        for (const Id arg : node.args)
+            total += costs[find(arg)];
+        queue.emplace(total, index);
+    };
+
+    std::vector<Id> distinct;
+
+    for (Id cls = 0; cls < _classes.size(); cls++)
+    {
+        for (const std::uint32_t index : _classes[cls].nodes)
+        {
+            distinct.clear();
+
+            for (const Id arg : _nodes[index].args)
+                distinct.push_back(find(arg));
+            std::ranges::sort(distinct);
+            remaining[index] = static_cast<std::uint32_t>(std::unique(distinct.begin(), distinct.end()) - distinct.begin());
+
+            if (!remaining[index])
+                push(index);
+        }
+    }
+
+    while (!queue.empty() && best[target] == NONE)
+    {
+        const auto [total, index] = queue.top();
+        queue.pop();
+        const Id cls = find(_owners[index]);
+
+        if (best[cls] != NONE)
+            continue;
+
+        best[cls] = index;
+        costs[cls] = total;
+
+        for (const std::uint32_t use : _classes[cls].uses)
+        {
+            if (remaining[use] == NONE || counted[use] == cls)
+                continue;
+            counted[use] = cls;
+
+            if (--remaining[use] == 0)
+                push(use);
+        }
+    }
+    assert(best[target] != NONE && "every class has a finite expression");
+
+    // built in postfix order like `add`, with the arguments of each call pending on `out`
+    std::vector<std::pair<Id, bool>> stack{ { target, false } };
+    std::vector<Ast> out;
+
+    while (!stack.empty())
+    {
+        const auto [cls, expanded] = stack.back();
+        stack.pop_back();
+        const Node& node = _nodes[best[cls]];
+
+        switch (node.kind)
+        {
+        case Kind::LITERAL:
+            out.push_back(Literal{ node.value });
+            break;
+        case Kind::VARIABLE:
+            out.push_back(Variable{ _identifiers[node.index] });
+            break;
+        case Kind::CALL:
+        {
+            if (!expanded)
+            {
+                stack.emplace_back(cls, true);
+
+                for (auto it = node.args.rbegin(); it != node.args.rend(); ++it)
+                    stack.emplace_back(find(*it), false);
+                break;
+            }
+
+            const auto first = out.end() - static_cast<std::ptrdiff_t>(node.args.size());
+            std::vector<Ast> args(std::make_move_iterator(first), std::make_move_iterator(out.end()));
+            out.erase(first, out.end());
+            out.push_back(Call{ node.fn(), std::move(args) });
+            break;
+        }
+        }
+    }
+    return std::move(out.back());
+}
+
+std::span<const std::uint32_t> EGraph::nodes(Id id) const
+{
+    return _classes[find(id)].nodes;
+}
+
+const Node& EGraph::node(std::uint32_t index) const
+{
+    return _nodes[index];
+}
+
+std::size_t EGraph::size() const
+{
+    return _memo.size();
+}
+
+std::size_t EGraph::classes() const
+{
+    std::size_t out = 0;
+
+    for (Id id = 0; id < _parents.size(); id++)
+        out += find(id) == id;
+    return out;
+}
+
+Id EGraph::add(Node node)
+{
+    canonicalize(node);
+
+    if (const auto it = _memo.find(node); it != _memo.end())
+        return find(_owners[it->second]);
+
+    const auto id = static_cast<Id>(_classes.size());
+    const auto index = static_cast<std::uint32_t>(_nodes.size());
+    _parents.push_back(id);
+    _classes.push_back({ { index }, {} });
+
+    for (const Id arg : node.args)
+        _classes[arg].uses.push_back(index);
+
+    _owners.push_back(id);
+    _memo.emplace(node, index);
+    _nodes.push_back(std::move(node));
+    return id;
+}
+
+void EGraph::canonicalize(Node& node) const
+{
+    for (Id& arg : node.args)
+        arg = find(arg);
+
+    if (node.kind != Kind::CALL || node.args.empty())
+        return;
+
+    switch (node.fn()->commutativity)
+    {
+    case Commutativity::ALL:
+        std::ranges::sort(node.args);
+        break;
+    case Commutativity::TAIL:
+        std::sort(node.args.begin() + 1, node.args.end());
+        break;
+    case Commutativity::NONE:
+        break;
+    }
+}
+
+std::uint32_t EGraph::identifier(std::string_view identifier)
+{
+    auto it = _indices.find(identifier);
+
+    if (it == _indices.end())
+    {
+        it = _indices.emplace(std::string(identifier), static_cast<std::uint32_t>(_identifiers.size())).first;
+        _identifiers.emplace_back(identifier);
+    }
+    return it->second;
+}
+
+Stats engine::egraph::simplify(ast::Ast& ast, const table::View& rules, const Options& options)
+{
+    EGraph graph;
+    const Id id = graph.add(ast);
+    const Stats stats = graph.saturate(rules, options.limits);
+    ast = graph.extract(id, options.cost);
+    return stats;
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include "ast/ast.h"
+#include "ast/function.h"
+#include "engine/table.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// equality saturation. rather than rewriting an expression in place, where every rewrite destroys the form it
+// was applied to and an early choice may rule out a better one later, all forms the rules reach are recorded
+// side by side in an e-graph: nodes are grouped in equivalence classes (e-classes), and the arguments of a node
+// are classes rather than nodes, such that each class stands for every expression it can be extracted as. once
+// no rule adds anything new, or a limit is reached, the cheapest expression is extracted
+namespace engine::egraph
+{
+    // index of an e-class. classes are merged with a union-find, so an id may refer to a class which has been
+    // merged into another, see `EGraph::find`
+    using Id = std::uint32_t;
+
+    enum struct Kind : std::uint8_t
+    {
+        LITERAL,
+        VARIABLE,
+        CALL,
+    };
+
+    // an e-node. the arguments of commutative calls are sorted by class, so that equal nodes compare equal
+    struct Node
+    {
+        Kind kind = Kind::LITERAL;
+        // index of the function in `ast::function::ARRAY` for calls, or of the identifier for variables
+        std::uint32_t index = 0;
+        double value = 0.0;
+        std::vector<Id> args;
+
+        const ast::function::Function* fn() const
+        {
+            return &ast::function::ARRAY[index];
+        }
+    };
+
+    // cost of a node on its own, which has to be positive. the cost of an expression is the sum of the costs of
+    // its nodes
+    using Cost = std::function<double(const Node& node)>;
+
+    namespace cost
+    {
+        // every node costs the same, so the expression with the fewest nodes is extracted
+        double size(const Node& node);
+
+        // estimate of the time taken to evaluate a node, see `eval::lower`
+        double evaluation(const Node& node);
+    }
+
+    struct Limits
+    {
+        // nodes in the graph, past which no rules are applied
+        std::size_t max_nodes = 10000;
+
+        // matches found in one iteration, past which no more are searched for
+        std::size_t max_matches = 10000;
+
+        // rounds of matching every rule against every class
+        std::size_t max_iterations = 16;
+
+        std::chrono::microseconds max_time = std::chrono::milliseconds(50);
+    };
+
+    // why saturation stopped
+    enum struct Stop : std::uint8_t
+    {
+        SATURATED,
+        NODES,
+        ITERATIONS,
+        TIME,
+    };
+
+    struct Stats
+    {
+        std::size_t iterations = 0;
+        std::size_t matches = 0;
+        std::size_t nodes = 0;
+        std::size_t classes = 0;
+        Stop stop = Stop::SATURATED;
+    };
+
+    struct EGraph
+    {
+        // adds an expression, and returns its class
+        Id add(const ast::Ast& ast);
+
+        // the class an id has been merged into
+        Id find(Id id) const;
+
+        // merges two classes, and returns whether they were distinct. the graph has to be rebuilt before it is
+        // matched against again
+        bool merge(Id a, Id b);
+
+        // restores the invariants broken by merging: the arguments of every node refer to the class they were
+        // merged into, and nodes which became equal by that are merged in turn (congruence)
+        void rebuild();
+
+        // applies rules until none adds anything new, or a limit is reached. earlier rules aren't prioritized
+        // over later ones, since every rule applying is kept
+        Stats saturate(const table::View& rules, const Limits& limits = {});
+
+        // the cheapest expression of a class
+        ast::Ast extract(Id id, const Cost& cost = cost::size) const;
+
+        // the nodes of a class, as indices for `node`
+        std::span<const std::uint32_t> nodes(Id id) const;
+        const Node& node(std::uint32_t index) const;
+
+        // number of distinct nodes
+        std::size_t size() const;
+
+        // number of classes which haven't been merged into another
+        std::size_t classes() const;
+
+    private:
+        struct Class
+        {
+            std::vector<std::uint32_t> nodes;
+            // nodes with this class as an argument
+            std::vector<std::uint32_t> uses;
+        };
+
+        struct NodeHash
+        {
+            std::size_t operator()(const Node& node) const;
+        };
+
+        struct NodeEqual
+        {
+            bool operator()(const Node& a, const Node& b) const;
+        };
+
+        struct StringHash
+        {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view str) const
+            {
+                return std::hash<std::string_view>{}(str);
+            }
+        };
+
+        Id add(Node node);
+        void canonicalize(Node& node) const;
+        void repair(std::uint32_t node, std::vector<Id>& touched);
+        std::uint32_t identifier(std::string_view identifier);
+
+        // parent of each class in the union-find, which is the class itself for classes not merged
+        mutable std::vector<Id> _parents;
+        std::vector<Class> _classes;
+        std::vector<Node> _nodes;
+        // class each node was added to
+        std::vector<Id> _owners;
+        std::unordered_map<Node, std::uint32_t, NodeHash, NodeEqual> _memo;
+        // nodes with an argument merged into another class since the last rebuild
+        std::vector<std::uint32_t> _pending;
+        std::vector<std::string> _identifiers;
+        std::unordered_map<std::string, std::uint32_t, StringHash, std::equal_to<>> _indices;
+    };
+
+    struct Options
+    {
+        Limits limits;
+        Cost cost = cost::size;
+    };
+
+    // replaces an expression with the cheapest one equivalent to it by the rules
+    Stats simplify(ast::Ast& ast, const table::View& rules, const Options& options = {});
+}
@@ -1,7 +1,14 @@
 #include "engine.h"
+#include "ast/canonical.h"
 #include "ast/function.h"
+#include "engine/stats.h"
+#include "eval/fold.h"
 #include "parser/parser.h"
+#include <cstdint>
 #include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 using namespace ast::prelude;
 using namespace function::prelude;
@@ -13,52 +20,230 @@ namespace impl
     // expressions such as `1 + (2 + 3)` and `(1 + 2) + 3` to a common AST `+(1, 2, 3)`, which helps with
     // predicate-matching against long nested expressions. it is also more cache-efficient since arguments
     // that are semantically "next to" each other (and will therefore be accessed at the same time) are also
-    // physically next to each other in memory
-    Ast flatten(ast::Ast ast)
+    // physically next to each other in memory.
+    //
+    // nested calls are merged top-down, such that each argument is moved once rather than once per level of
+    // nesting it is merged through, which would be quadratic for long chains
+    void merge(Call& call)
     {
-        if (!ast.has<Call>())
-            return ast;
+        const auto mergeable = [&](const std::vector<Ast>& args, std::size_t i)
+        {
+            const Ast& arg = args[i];
+            const bool associativity_match =
+                (call.fn->associativity == Associativity::LEFT && i == 0) ||
+                (call.fn->associativity == Associativity::RIGHT && i == args.size() - 1) ||
+                (call.fn->associativity == Associativity::ALL);
+            return associativity_match && call.fn->arity_type == ArityType::DYNAMIC
+                && arg.has<Call>() && arg.get<Call>().fn == call.fn;
+        };
 
-        Call& call = ast.get<Call>();
-        std::vector<Ast> new_args;
-        const std::size_t last_i = call.args.size() - 1;
+        struct Frame
+        {
+            std::vector<Ast>* args;
+            std::size_t next;
+        };
+        // kept across calls, since every normalization merges many calls
+        static thread_local std::vector<Ast> new_args;
+        static thread_local std::vector<Frame> stack;
+        stack.clear();
 
-        for (std::size_t i = 0; i < call.args.size(); i++)
+        for (std::size_t i = 0; i < call.args.size() && stack.empty(); i++)
         {
-            Ast flat_arg = flatten(std::move(call.args[i]));
-            
-            if (flat_arg.has<Call>())
+            if (mergeable(call.args, i))
+                stack.push_back({ &call.args, 0 });
+        }
+
+        // nothing to merge, the arguments stay where they are
+        if (stack.empty())
+            return;
+
+        while (!stack.empty())
+        {
+            Frame& frame = stack.back();
+
+            if (frame.next == frame.args->size())
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            const std::size_t i = frame.next++;
+            Ast& arg = (*frame.args)[i];
+
+            if (mergeable(*frame.args, i))
             {
-                Call& sub_call = flat_arg.get<Call>();
-                const bool associativity_match = 
-                    (call.fn->associativity == Associativity::LEFT && i == 0) ||
-                    (call.fn->associativity == Associativity::RIGHT && i == last_i) ||
-                    (call.fn->associativity == Associativity::ALL);
-                
-                if (sub_call.fn == call.fn && associativity_match)
+                stack.push_back({ &arg.get<Call>().args, 0 });
+                continue;
+            }
+            new_args.push_back(std::move(arg));
+        }
+
+        // the arguments are moved back if they fit, such that neither vector is reallocated. otherwise the
+        // buffer is handed to the call, and the old arguments take its place
+        if (call.args.capacity() >= new_args.size())
+        {
+            call.args.clear();
+            std::move(new_args.begin(), new_args.end(), std::back_inserter(call.args));
+        }
+        else
+        {
+            call.args.swap(new_args);
+        }
+        new_args.clear();
+    }
+
+    // folds the literals of a call whose arguments are normalized (see `eval::fold`), and sorts its arguments
+    // unless it folded into a literal. folding first spares the matcher the common fully numeric expression
+    void finish(Ast& ast)
+    {
+        eval::fold(ast);
+
+        if (ast.has<Call>())
+            ast::canonical::sort_arguments(ast.get<Call>());
+    }
+
+    // puts an expression in normal form: calls are flattened (see `merge`), their literals folded, and their
+    // arguments sorted into canonical order (see `ast::canonical`), such that e.g. `b + (c + a)` and
+    // `(a + b) + c` are both normalized to `+(a, b, c)`
+    Ast normalize(Ast ast)
+    {
+        // each call is merged on the way down and finished on the way up, once its arguments are normalized,
+        // so every node is visited once while its arguments are still in cache. iterative, since deep trees
+        // would overflow the native stack, which is kept across calls since every evaluation normalizes
+        static thread_local std::vector<std::pair<Ast*, std::size_t>> stack;
+        stack.clear();
+
+        if (ast.has<Call>())
+        {
+            merge(ast.get<Call>());
+            stack.emplace_back(&ast, 0);
+        }
+
+        while (!stack.empty())
+        {
+            auto& [node, next] = stack.back();
+            Call& call = node->get<Call>();
+
+            if (next < call.args.size())
+            {
+                Ast& arg = call.args[next++];
+
+                if (arg.has<Call>())
                 {
-                    new_args.insert
-                    (
-                        new_args.end(),
-                        std::make_move_iterator(sub_call.args.begin()),
-                        std::make_move_iterator(sub_call.args.end())
-                    );
-                    continue;
+                    merge(arg.get<Call>());
+                    stack.emplace_back(&arg, 0);
                 }
+                continue;
             }
-            // else
-            new_args.push_back(std::move(flat_arg));
+            finish(*node);
+            stack.pop_back();
+        }
+        return ast;
+    }
+
+    struct StringHash
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view str) const
+        {
+            return std::hash<std::string_view>{}(str);
         }
-        return Call{ call.fn, std::move(new_args) };
+    };
+
+    using StringCache = engine::cache::Cache<std::string, std::shared_ptr<const Ast>, StringHash, std::equal_to<>>;
+
+    // null while disabled
+    static std::unique_ptr<StringCache> strings;
+    static std::unique_ptr<engine::rewrite::Memo> subtrees;
+    static const engine::table::View* rules = nullptr;
+    static engine::RuleOptions rule_options;
+
+    Ast parse(std::string_view str)
+    {
+        const engine::stats::Scope scope(engine::stats::Phase::PARSE);
+        return parser::parse(str);
     }
 }
 
 Ast engine::evaluate_str(std::string_view str)
 {
-    return evaluate_expr(parser::parse(str));
+    if (impl::strings)
+        return evaluate_shared(str)->copy();
+
+    const stats::Scope scope(stats::Phase::EVALUATE);
+    return evaluate_expr(impl::parse(str));
+}
+
+std::shared_ptr<const Ast> engine::evaluate_shared(std::string_view str)
+{
+    const stats::Scope scope(stats::Phase::EVALUATE);
+
+    if (!impl::strings)
+        return std::make_shared<const Ast>(evaluate_expr(impl::parse(str)));
+
+    if (const auto hit = impl::strings->find(str))
+        return *hit;
+
+    // errors propagate without being memoized, so that they are reported again on every attempt
+    auto out = std::make_shared<const Ast>(evaluate_expr(impl::parse(str)));
+    impl::strings->insert(std::string(str), out);
+    return out;
 }
 
 Ast engine::evaluate_expr(ast::Ast ast)
 {
-    return impl::flatten(std::move(ast));
+    {
+        const stats::Scope scope(stats::Phase::NORMALIZE);
+        ast = impl::normalize(std::move(ast));
+    }
+
+    if (!impl::rules)
+        return ast;
+
+    const stats::Scope scope(stats::Phase::REWRITE);
+
+    switch (impl::rule_options.strategy)
+    {
+    case Strategy::INNERMOST:
+    {
+        rewrite::Options options = impl::rule_options.rewrite;
+        options.memo = impl::subtrees.get();
+        rewrite::innermost(ast, *impl::rules, options);
+        break;
+    }
+    case Strategy::SATURATE:
+        // the extracted expression is put together from nodes of different forms, which may nest calls that
+        // flatten
+        egraph::simplify(ast, *impl::rules, impl::rule_options.egraph);
+        ast = impl::normalize(std::move(ast));
+        break;
+    }
+    return ast;
+}
+
+void engine::configure_rules(const table::View* rules, const RuleOptions& options)
+{
+    impl::rules = rules;
+    impl::rule_options = options;
+
+    if (impl::strings)
+        impl::strings->clear();
+    if (impl::subtrees)
+        impl::subtrees->clear();
+}
+
+void engine::configure_cache(const CacheOptions& options)
+{
+    impl::strings = options.strings ? std::make_unique<impl::StringCache>(options.strings) : nullptr;
+    impl::subtrees = options.subtrees ? std::make_unique<rewrite::Memo>(options.subtrees) : nullptr;
+}
+
+engine::CacheStats engine::cache_stats()
+{
+    return
+    {
+        .strings = impl::strings ? impl::strings->stats() : cache::Stats{},
+        .subtrees = impl::subtrees ? impl::subtrees->stats() : cache::Stats{},
+    };
 }
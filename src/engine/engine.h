@@ -1,11 +1,72 @@
 #pragma once
 #include "ast/ast.h"
+#include "engine/cache.h"
+#include "engine/egraph.h"
+#include "engine/rewrite.h"
+#include "engine/table.h"
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
 
 namespace engine
 {
     // parses and evaluates string
     ast::Ast evaluate_str(std::string_view str);
 
-    // evaluates expression. this is a massive TODO, currently only flattens the expression
+    // same as `evaluate_str`, but shares the result with the cache of input strings rather than copying it out of
+    // it, see `configure_cache`
+    std::shared_ptr<const ast::Ast> evaluate_shared(std::string_view str);
+
+    // simplifies an expression. it is first normalized: nested calls of associative functions are flattened
+    // into one, e.g. `(a + b) + c` into `+(a, b, c)`, literal arguments are folded (see `eval::fold`), and the
+    // arguments of commutative calls are sorted into canonical order (see `ast::canonical`). the configured
+    // rules, if any, are then applied by the configured strategy (see `configure_rules`). the result is
+    // normalized as well, so expressions that differ only in grouping or argument order give equal results
     ast::Ast evaluate_expr(ast::Ast ast);
+
+    // how the rules are applied
+    enum struct Strategy
+    {
+        // rewrites until none of the rules applies, see `rewrite::innermost`
+        INNERMOST,
+        // extracts the cheapest expression of all the rules reach, see `egraph::simplify`. slower, but doesn't
+        // depend on the order rewrites happen in
+        SATURATE,
+    };
+
+    struct RuleOptions
+    {
+        Strategy strategy = Strategy::INNERMOST;
+        rewrite::Options rewrite;
+        egraph::Options egraph;
+    };
+
+    // replaces the rules expressions are simplified with, which have to outlive their use. null disables
+    // simplification, which is the default. discards the memoized input strings and subexpressions, since they
+    // were evaluated with the previous rules. must not be called while evaluating concurrently
+    void configure_rules(const table::View* rules, const RuleOptions& options = {});
+
+    // memoization of `evaluate_str` by input string, such that repeated inputs are parsed, normalized and
+    // rewritten once, and of the normal forms of subexpressions under the `INNERMOST` strategy, such that
+    // subexpressions repeated between inputs are rewritten once (see `rewrite::Memo`). safe to use from several
+    // threads at once. disabled by default; a capacity of zero disables either again
+    struct CacheOptions
+    {
+        // maximum number of input strings memoized
+        std::size_t strings = 0;
+        // maximum number of subexpressions memoized. replaces the memo of `RuleOptions::rewrite`
+        std::size_t subtrees = 0;
+    };
+
+    // replaces the caches, discarding their contents. must not be called while evaluating concurrently
+    void configure_cache(const CacheOptions& options);
+
+    struct CacheStats
+    {
+        cache::Stats strings;
+        cache::Stats subtrees;
+    };
+
+    CacheStats cache_stats();
 }
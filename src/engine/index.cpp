@@ -0,0 +1,92 @@
+#include "index.h"
+
+#include <algorithm>
+using namespace engine::index;
+using namespace ast::prelude;
+
+void Net::candidates
+(
+    std::uint32_t group,
+    std::size_t arity,
+    std::span<const double> literals,
+    std::vector<std::uint32_t>& out
+) const {
+    const std::size_t begin = out.size();
+    const std::span<const Bucket> range = buckets.subspan(groups[group], groups[group + 1] - groups[group]);
+
+    const auto take = [&](const Bucket& bucket)
+    {
+        const std::span<const std::uint32_t> rules = order.subspan(bucket.first, bucket.size);
+        out.insert(out.end(), rules.begin(), rules.end());
+    };
+
+    const auto find = [&](const Key& key)
+    {
+        const auto it = std::ranges::lower_bound(range, key, {}, &Bucket::key);
+
+        if (it != range.end() && it->key == key)
+            take(*it);
+    };
+
+    // the rules of a shape which require no literal, and those which require one of the literals given
+    const auto probe = [&](bool extensible, std::uint32_t n)
+    {
+        find({ .group = group, .extensible = extensible, .arity = n });
+
+        for (const double value : literals)
+        {
+            const std::int64_t key = quantize(value);
+
+            for (std::int64_t literal = key - 1; literal <= key + 1; literal++)
+                find({ .group = group, .extensible = extensible, .arity = n, .keyed = true, .literal = literal });
+        }
+    };
+
+    if (arity <= UINT32_MAX)
+        probe(false, static_cast<std::uint32_t>(arity));
+
+    // the rules which may match a subset of the arguments, by each of their arities up to that of the call
+    auto it = std::ranges::lower_bound(range, Key{ .group = group, .extensible = true }, {}, &Bucket::key);
+
+    while (it != range.end() && it->key.arity <= arity)
+    {
+        const std::uint32_t n = it->key.arity;
+        probe(true, n);
+        it = std::ranges::upper_bound(range, Key{ group, true, n, true, INT64_MAX }, {}, &Bucket::key);
+    }
+
+    for (const Bucket& bucket : buckets.subspan(groups[WILDCARDS], groups[WILDCARDS + 1] - groups[WILDCARDS]))
+        take(bucket);
+
+    // a rule may be reached through several literals, and the rules of the group and the wildcards are merged
+    // such that they are attempted in priority order
+    std::sort(out.begin() + static_cast<std::ptrdiff_t>(begin), out.end());
+    out.erase(std::unique(out.begin() + static_cast<std::ptrdiff_t>(begin), out.end()), out.end());
+}
+
+void Net::candidates(const ast::Ast& expr, std::vector<std::uint32_t>& out) const
+{
+    static thread_local std::vector<double> literals;
+    literals.clear();
+
+    expr.visit
+    (
+        [&](const Call& e)
+        {
+            for (const Ast& arg : e.args)
+            {
+                if (arg.has<Literal>())
+                    literals.push_back(arg.get<Literal>().value);
+            }
+            candidates(function::index(e.fn), e.args.size(), literals, out);
+        },
+        [&](const Literal& e)
+        {
+            candidates(LITERALS, 0, std::span(&e.value, 1), out);
+        },
+        [&](const Variable&)
+        {
+            candidates(VARIABLES, 0, {}, out);
+        }
+    );
+}
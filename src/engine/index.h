@@ -0,0 +1,125 @@
+#pragma once
+#include "ast/ast.h"
+#include "ast/function.h"
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <vector>
+
+// discrimination net over the shape of the top-level predicates of a set of rules. rules are keyed on the head
+// function of the predicate, its arity, and one of the literal constants it requires, and the net is flattened
+// into sorted arrays, such that looking up the rules that could possibly match an expression costs in
+// proportion to its number of literal arguments and the number of rules returned, not the size of the rule
+// set. the arrays hold no pointers, so a net can equally be built at runtime, during compilation, or mapped
+// from a file
+namespace engine::index
+{
+    // rules are grouped by the kind of expression their predicate can match. calls are grouped by the index of
+    // their function in `ast::function::ARRAY`, followed by the groups below
+    enum Group : std::uint32_t
+    {
+        LITERALS = ast::function::ARRAY.size(),
+        VARIABLES,
+        // rules whose predicate matches any expression, which are candidates for every expression
+        WILDCARDS,
+        GROUP_COUNT,
+    };
+
+    // literals are keyed by their bit pattern with the 20 lowest mantissa bits dropped, leaving a granularity
+    // of 2^-32 relative to the value. since that is coarser than the epsilon of `double_equality`, two values
+    // considered equal are always keyed either identically or adjacently, so probing a key and its two
+    // neighbours finds every constant that could match
+    constexpr std::int64_t quantize(double value)
+    {
+        if (value == 0.0)
+            value = 0.0;
+        return std::bit_cast<std::int64_t>(value) >> 20;
+    }
+
+    // the shape of the expressions a rule may match, by which the rules of a group are split into buckets
+    struct Key
+    {
+        std::uint32_t group = 0;
+        // whether a call may have more arguments than `arity`, see `match::extensible`
+        bool extensible = false;
+        // number of arguments of a call, zero otherwise
+        std::uint32_t arity = 0;
+        // whether the rules require a literal, the first literal argument of a call or the literal itself, whose
+        // value is keyed by `literal`
+        bool keyed = false;
+        std::int64_t literal = 0;
+
+        constexpr auto operator<=>(const Key&) const = default;
+    };
+
+    // rules sharing a key, which are `order[first..first + size)` in ascending order
+    struct Bucket
+    {
+        Key key;
+        std::uint32_t first = 0;
+        std::uint32_t size = 0;
+    };
+
+    // sorts the rules by their keys, keeping the rules sharing a key in ascending order, and builds a bucket for
+    // each key. returns the number of buckets. `buckets` has room for one per rule, and `groups` has
+    // `GROUP_COUNT + 1` entries and is expected to be zeroed
+    constexpr std::uint32_t build
+    (
+        std::span<const Key> keys,
+        std::span<std::uint32_t> order,
+        std::span<Bucket> buckets,
+        std::span<std::uint32_t> groups
+    ) {
+        for (std::uint32_t i = 0; i < keys.size(); i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b)
+        {
+            return std::tie(keys[a], a) < std::tie(keys[b], b);
+        });
+
+        std::uint32_t count = 0;
+
+        for (std::uint32_t i = 0; i < keys.size(); i++)
+        {
+            const Key& next = keys[order[i]];
+
+            if (!count || buckets[count - 1].key != next)
+            {
+                buckets[count++] = { next, i, 0 };
+                groups[next.group + 1]++;
+            }
+            buckets[count - 1].size++;
+        }
+        for (std::size_t g = 0; g < GROUP_COUNT; g++)
+            groups[g + 1] += groups[g];
+        return count;
+    }
+
+    // non-owning view of the arrays of a net, as filled in by `build`
+    struct Net
+    {
+        // indices of the rules of each bucket
+        std::span<const std::uint32_t> order;
+        // sorted by key. the buckets of group `g` are `buckets[groups[g]..groups[g + 1])`
+        std::span<const Bucket> buckets;
+        std::span<const std::uint32_t> groups;
+
+        // appends the indices of all rules which may match an expression of the group with `arity` arguments to
+        // `out`, in ascending order, along with the rules matching any expression. `literals` are the values of
+        // the literal arguments of a call, or the value of a literal
+        void candidates
+        (
+            std::uint32_t group,
+            std::size_t arity,
+            std::span<const double> literals,
+            std::vector<std::uint32_t>& out
+        ) const;
+
+        // appends the indices of all rules which may match the expression to `out`, in ascending order
+        void candidates(const ast::Ast& expr, std::vector<std::uint32_t>& out) const;
+    };
+}
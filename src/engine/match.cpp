@@ -0,0 +1,778 @@
+#include "match.h"
+#include "ast/store.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+using namespace engine;
+using namespace engine::match;
+using namespace ast::prelude;
+using namespace function::prelude;
+using ast::store::Id;
+
+namespace impl
+{
+    namespace bc = engine::bytecode;
+
+    // entry point of a predicate node into the instruction stream of a compiled predicate
+    using Node = std::uint32_t;
+
+    // a compiled predicate, whose arguments are addressed through the argument table
+    struct Pattern
+    {
+        bc::View program;
+
+        const bc::Instruction& at(Node pc) const      { return program.code[pc];                               }
+        bc::Op op(Node pc) const                      { return program.code[pc].op;                            }
+        Node arg(Node pc, std::size_t i) const        { return program.args[program.code[pc].operand + i];     }
+
+        // the entry point past the code of the node, whose last argument's code comes last
+        Node end(Node pc) const
+        {
+            while (true)
+            {
+                const bc::Instruction& in = program.code[pc];
+
+                if (in.op == bc::Op::BIND_TAG || in.op == bc::Op::COMPARE_TAG)
+                    pc++;
+                else if (in.op == bc::Op::CHECK_HEAD && in.arity)
+                    pc = arg(pc, in.arity - 1);
+                else
+                    return pc + 1;
+            }
+        }
+    };
+
+    // a summary equal expressions share. literals within epsilon of each other are equal (see `double_equality`)
+    // but may differ in every bit, so literals only share their kind
+    static std::uint64_t shape(const Ast& expr)
+    {
+        return expr.visit
+        (
+            [](const Literal&)           { return std::uint64_t(1);                                                          },
+            [](const Variable& variable) { return hash_combine(2, std::hash<std::string>{}(variable.identifier));             },
+            [](const Call& call)         { return hash_combine(hash_combine(3, call.fn->identifier_hash), call.args.size()); }
+        );
+    }
+
+    // whether a leaf of the expression satisfies a leaf instruction
+    static bool leaf_fits(const bc::Instruction& in, const Ast& expr)
+    {
+        switch (in.op)
+        {
+        case bc::Op::ANY:
+            return true;
+        case bc::Op::CHECK_LITERAL:
+            return expr.has_predicate<Literal>([&](const Literal& e)
+            {
+                return !in.has_value || double_equality(in.value, e.value);
+            });
+        case bc::Op::CHECK_VARIABLE:
+            return expr.has<Variable>();
+        default:
+            assert(false && "not a leaf");
+            return false;
+        }
+    }
+
+    // runs the instruction stream against an expression, checking the conditions every match has to meet: the
+    // heads, numbers of arguments and leaves wherever the arguments of the expression are in order, and for each
+    // argument of a call where they aren't, that the call has some argument with its head or of its kind. an
+    // argument of a call is gone through in order, the instructions of each following the ones of the one
+    // before, such that a call is entered by its head and left once its last argument is checked. nothing is
+    // interned or recorded, so most of the candidates the index yields are turned down here at little cost
+    static bool admits(const Pattern& pattern, const Ast& expr)
+    {
+        struct Frame
+        {
+            const Call* call;
+            // arguments of the predicate call checked so far, and in total
+            std::uint32_t checked;
+            std::uint32_t arity;
+        };
+        static thread_local std::vector<Frame> frames;
+        frames.clear();
+
+        // the expression the next instruction is checked against, or null if it may be any argument of the
+        // innermost call entered whose arguments aren't in order
+        const Ast* target = &expr;
+        Node pc = 0;
+
+        while (true)
+        {
+            const bc::Instruction& in = pattern.at(pc);
+
+            switch (in.op)
+            {
+            case bc::Op::BIND_TAG:
+            case bc::Op::COMPARE_TAG:
+                pc++;
+                continue;
+            case bc::Op::ANY:
+            case bc::Op::CHECK_LITERAL:
+            case bc::Op::CHECK_VARIABLE:
+            {
+                const auto fits = [&](const Ast& arg) { return leaf_fits(in, arg); };
+
+                if (target ? !fits(*target) : std::ranges::none_of(frames.back().call->args, fits))
+                    return false;
+                pc++;
+                break;
+            }
+            case bc::Op::CHECK_HEAD:
+            {
+                const auto heads = [&](const Ast& arg)
+                {
+                    return arg.has<Call>() && arg.get<Call>().fn == in.fn() && arg.get<Call>().args.size() == in.arity;
+                };
+
+                if (target)
+                {
+                    if (!target->has<Call>() || target->get<Call>().fn != in.fn())
+                        return false;
+
+                    // the arguments the predicate doesn't consume are carried over, see `extensible`
+                    const Call& call = target->get<Call>();
+
+                    if (call.args.size() != in.arity && !(target == &expr && in.extensible && call.args.size() > in.arity))
+                        return false;
+                    frames.push_back({ &call, 0, in.arity });
+                    pc++;
+                }
+                else
+                {
+                    // the arguments of calls among unordered arguments are checked once the call is assigned
+                    if (std::ranges::none_of(frames.back().call->args, heads))
+                        return false;
+                    pc = pattern.end(pc);
+                }
+                break;
+            }
+            }
+
+            while (!frames.empty() && frames.back().checked == frames.back().arity)
+                frames.pop_back();
+
+            if (frames.empty())
+                return true;
+
+            // the first argument of a call commuting in its tail stays in place
+            Frame& frame = frames.back();
+            const std::uint32_t i = frame.checked++;
+
+            switch (frame.call->fn->commutativity)
+            {
+            case Commutativity::NONE:
+                target = &frame.call->args[i];
+                break;
+            case Commutativity::TAIL:
+                target = i ? nullptr : &frame.call->args[0];
+                break;
+            case Commutativity::ALL:
+                target = nullptr;
+                break;
+            }
+        }
+    }
+
+    // non-owning reference to the remainder of a match, invoked once the current predicate has been matched.
+    // returning false rejects the choices made so far and makes the matcher backtrack
+    struct Continuation
+    {
+        template<class F>
+        Continuation(const F& f) : _context(&f), _invoke([](const void* c) { return (*static_cast<const F*>(c))(); }) {}
+
+        bool operator()() const
+        {
+            return _invoke(_context);
+        }
+
+    private:
+        const void* _context;
+        bool (*_invoke)(const void*);
+    };
+
+    struct PairHash
+    {
+        std::size_t operator()(const std::pair<const void*, const void*>& pair) const
+        {
+            return hash_combine(std::bit_cast<std::uintptr_t>(pair.first), std::bit_cast<std::uintptr_t>(pair.second));
+        }
+    };
+
+    // candidate set of each argument of a predicate call against an expression call
+    using Candidates = std::vector<Bitset>;
+
+    // state of a match, kept between matches to reuse its allocations
+    struct Context
+    {
+        // interned expressions used to compare tag values in constant time. kept across matches during a
+        // session, see `Session`
+        ast::store::Store store;
+        std::unordered_map<const Ast*, Id> ids;
+        // number of the rewrite run of the session, or zero
+        std::uint64_t run = 0;
+
+        // memoized candidates of predicate calls against expression calls, or nullopt if they can't match
+        std::unordered_map<std::pair<const void*, const void*>, std::optional<Candidates>, PairHash> candidates;
+
+        // expressions each occurrence of a repeated tag may be bound to, keyed by the occurrence. they are only
+        // interned once the predicate is known to fit, since interning walks them whole
+        std::unordered_map<const void*, std::pair<std::uint8_t, std::vector<const Ast*>>> occurrences;
+
+        // values each repeated tag may be bound to; the intersection of the values of all its occurrences
+        std::unordered_map<std::uint8_t, std::unordered_set<Id>> allowed;
+
+        Bindings bound;
+        const Ast* root;
+        std::span<const std::size_t> pivot_order;
+        Bitset consumed;
+        // arguments of the top-level call consumed by earlier matches, which are not assigned again
+        Bitset excluded;
+
+        void reset(const Ast& expr, bool extensible_root, std::span<const std::size_t> pivot_order)
+        {
+            if (!run)
+                store.clear();
+            ids.clear();
+            candidates.clear();
+            occurrences.clear();
+            allowed.clear();
+            bound.fill(nullptr);
+
+            this->root = extensible_root ? &expr : nullptr;
+            this->pivot_order = pivot_order;
+            this->consumed = Bitset();
+            this->excluded = Bitset();
+        }
+
+        Id id(const Ast& expr)
+        {
+            const auto [it, inserted] = ids.try_emplace(&expr, ast::store::NONE);
+
+            if (inserted)
+                it->second = store.intern(expr, run);
+            return it->second;
+        }
+
+        bool equal(const Ast& a, const Ast& b)
+        {
+            return &a == &b || id(a) == id(b);
+        }
+    };
+
+    static thread_local Context context;
+
+    struct Matcher
+    {
+        Context& ctx;
+        const Pattern& pattern;
+
+        static bool is_tag(bc::Op op)
+        {
+            return op == bc::Op::BIND_TAG || op == bc::Op::COMPARE_TAG;
+        }
+
+        // determines whether an expression has the shape described by a predicate, disregarding whether the
+        // values of repeated tags agree
+        bool fits(Node node, const Ast& expr)
+        {
+            while (is_tag(pattern.op(node)))
+                node++;
+
+            if (pattern.op(node) == bc::Op::CHECK_HEAD)
+                return candidates(node, expr) != nullptr;
+            return leaf_fits(pattern.at(node), expr);
+        }
+
+        // removes candidates whose value occurs fewer times among the arguments than a tag repeated within
+        // the same call requires; `Any[0] + Any[0]` can only match arguments whose value occurs at least twice
+        void prune_repeated(Node node, const Call& expr, Candidates& candidates)
+        {
+            const std::size_t k = pattern.at(node).arity;
+            std::array<std::uint8_t, 256> local_count{};
+
+            const auto tag_of = [&](std::size_t i) -> std::optional<std::uint8_t>
+            {
+                const Node arg = pattern.arg(node, i);
+
+                if (is_tag(pattern.op(arg)))
+                    return pattern.at(arg).tag;
+                return std::nullopt;
+            };
+
+            for (std::size_t i = 0; i < k; i++)
+            {
+                if (const auto tag = tag_of(i))
+                    local_count[*tag]++;
+            }
+
+            for (std::size_t tag = 0; tag < local_count.size(); tag++)
+            {
+                const std::size_t required = local_count[tag];
+
+                if (required < 2)
+                    continue;
+
+                Bitset any_candidate(expr.args.size());
+
+                for (std::size_t i = 0; i < k; i++)
+                {
+                    if (tag_of(i) == tag)
+                        any_candidate |= candidates[i];
+                }
+
+                // arguments whose shape occurs too rarely are told apart without interning them
+                std::unordered_map<std::uint64_t, std::size_t> shapes;
+                any_candidate.find_if([&](std::size_t j)
+                {
+                    shapes[shape(expr.args[j])]++;
+                    return false;
+                });
+
+                std::unordered_map<Id, std::size_t> occurrences;
+                any_candidate.find_if([&](std::size_t j)
+                {
+                    if (shapes[shape(expr.args[j])] < required)
+                        any_candidate.reset(j);
+                    else
+                        occurrences[ctx.id(expr.args[j])]++;
+                    return false;
+                });
+
+                for (std::size_t i = 0; i < k; i++)
+                {
+                    if (tag_of(i) != tag)
+                        continue;
+
+                    candidates[i].find_if([&](std::size_t j)
+                    {
+                        if (!any_candidate.test(j) || occurrences[ctx.id(expr.args[j])] < required)
+                            candidates[i].reset(j);
+                        return false;
+                    });
+                }
+            }
+        }
+
+        std::optional<Candidates> compute_candidates(Node node, const Call& expr, bool root)
+        {
+            const bc::Instruction& head = pattern.at(node);
+            const std::size_t k = head.arity;
+            const std::size_t n = expr.args.size();
+
+            if (head.fn() != expr.fn)
+                return std::nullopt;
+            if (n != k && !(root && n > k && head.extensible))
+                return std::nullopt;
+
+            std::vector<std::size_t> order(k);
+            const bool pivoted = root && ctx.pivot_order.size() == k;
+
+            if (pivoted)
+                std::ranges::copy(ctx.pivot_order, order.begin());
+            else
+                std::iota(order.begin(), order.end(), 0);
+
+            Candidates candidates(k, Bitset(n));
+
+            for (const std::size_t i : order)
+            {
+                // positional constraints imposed by the commutativity of the function
+                std::size_t begin = 0;
+                std::size_t end = n;
+
+                switch (expr.fn->commutativity)
+                {
+                case Commutativity::NONE:
+                    begin = i;
+                    end = i + 1;
+                    break;
+                case Commutativity::TAIL:
+                    begin = i ? 1 : 0;
+                    end = i ? n : 1;
+                    break;
+                case Commutativity::ALL:
+                    break;
+                }
+
+                const Node arg = pattern.arg(node, i);
+
+                for (std::size_t j = begin; j < end; j++)
+                {
+                    if (fits(arg, expr.args[j]))
+                        candidates[i].set(j);
+                }
+                if (candidates[i].none())
+                    return std::nullopt;
+            }
+
+            prune_repeated(node, expr, candidates);
+
+            if (!resolve(candidates) || !assignable(candidates, n))
+                return std::nullopt;
+
+            // record the values repeated tags may take on for the global intersection
+            for (std::size_t i = 0; i < k; i++)
+            {
+                const Node arg = pattern.arg(node, i);
+
+                if (pattern.op(arg) != bc::Op::COMPARE_TAG)
+                    continue;
+
+                auto& [tag, values] = ctx.occurrences[&pattern.at(arg)];
+                tag = pattern.at(arg).tag;
+
+                candidates[i].find_if([&](std::size_t j)
+                {
+                    values.push_back(&expr.args[j]);
+                    return false;
+                });
+            }
+            return candidates;
+        }
+
+        const Candidates* candidates(Node node, const Ast& expr)
+        {
+            if (!expr.has<Call>())
+                return nullptr;
+
+            const auto key = std::pair<const void*, const void*>{ &pattern.at(node), &expr };
+            auto it = ctx.candidates.find(key);
+
+            if (it == ctx.candidates.end())
+            {
+                std::optional<Candidates> computed = compute_candidates(node, expr.get<Call>(), &expr == ctx.root);
+                it = ctx.candidates.emplace(key, std::move(computed)).first;
+            }
+            return it->second ? &*it->second : nullptr;
+        }
+
+        // assigns each unassigned argument of a predicate call to one of its free candidates, picking the most
+        // constrained argument first
+        bool assign
+        (
+            Node node,
+            const Call& expr,
+            const Candidates& candidates,
+            Bitset& used,
+            std::vector<bool>& assigned,
+            std::size_t remaining,
+            bool root,
+            Continuation next
+        ) {
+            if (remaining == 0)
+            {
+                if (root)
+                {
+                    ctx.consumed = used;
+
+                    if (ctx.excluded.size())
+                        ctx.consumed.subtract(ctx.excluded);
+                }
+                return next();
+            }
+
+            std::size_t pivot = SIZE_MAX;
+            Bitset pivot_free;
+            std::size_t pivot_count = SIZE_MAX;
+
+            for (std::size_t i = 0; i < candidates.size(); i++)
+            {
+                if (assigned[i])
+                    continue;
+
+                Bitset free = candidates[i];
+                free.subtract(used);
+                const std::size_t count = free.count();
+
+                if (count == 0)
+                    return false;
+                if (count < pivot_count)
+                {
+                    pivot = i;
+                    pivot_count = count;
+                    pivot_free = std::move(free);
+                }
+            }
+
+            assigned[pivot] = true;
+            const Node arg = pattern.arg(node, pivot);
+            const bool matched = pivot_free.find_if([&](std::size_t j)
+            {
+                used.set(j);
+                const auto rest = [&]()
+                {
+                    return assign(node, expr, candidates, used, assigned, remaining - 1, root, next);
+                };
+
+                if (search(arg, expr.args[j], rest))
+                    return true;
+                used.reset(j);
+                return false;
+            });
+
+            if (!matched)
+                assigned[pivot] = false;
+            return matched;
+        }
+
+        // matches an expression against a predicate, binding tags, and invokes `next` for each way of doing
+        // so until it accepts
+        bool search(Node node, const Ast& expr, Continuation next)
+        {
+            switch (pattern.op(node))
+            {
+            case bc::Op::ANY:
+                return next();
+            case bc::Op::CHECK_LITERAL:
+            case bc::Op::CHECK_VARIABLE:
+                return leaf_fits(pattern.at(node), expr) && next();
+            case bc::Op::BIND_TAG:
+            case bc::Op::COMPARE_TAG:
+            {
+                const std::uint8_t tag = pattern.at(node).tag;
+
+                if (const Ast* bound = ctx.bound[tag])
+                    return ctx.equal(*bound, expr) && next();
+
+                if (const auto it = ctx.allowed.find(tag); it != ctx.allowed.end() && !it->second.contains(ctx.id(expr)))
+                    return false;
+
+                const auto bind = [&]()
+                {
+                    ctx.bound[tag] = &expr;
+
+                    if (next())
+                        return true;
+                    ctx.bound[tag] = nullptr;
+                    return false;
+                };
+                return search(node + 1, expr, bind);
+            }
+            case bc::Op::CHECK_HEAD:
+            {
+                const Candidates* call_candidates = candidates(node, expr);
+
+                if (!call_candidates)
+                    return false;
+
+                const Call& call = expr.get<Call>();
+                const std::size_t arity = pattern.at(node).arity;
+                const bool root = &expr == ctx.root;
+                Bitset used = root && ctx.excluded.size() ? ctx.excluded : Bitset(call.args.size());
+                std::vector<bool> assigned(arity, false);
+
+                return assign(node, call, *call_candidates, used, assigned, arity, root, next);
+            }
+            }
+            return false;
+        }
+
+        std::optional<Match> run(const Ast& expr, std::span<const std::size_t> pivot_order)
+        {
+            constexpr Node root = 0;
+
+            if (!admits(pattern, expr))
+                return std::nullopt;
+
+            ctx.reset(expr, pattern.op(root) == bc::Op::CHECK_HEAD, pivot_order);
+
+            if (!fits(root, expr))
+                return std::nullopt;
+
+            if (pattern.op(root) == bc::Op::COMPARE_TAG)
+            {
+                auto& [tag, values] = ctx.occurrences[&pattern.at(root)];
+                tag = pattern.at(root).tag;
+                values.push_back(&expr);
+            }
+            if (!intersect_occurrences())
+                return std::nullopt;
+
+            const auto accept = []() { return true; };
+
+            if (!search(root, expr, accept))
+                return std::nullopt;
+            return Match{ ctx.bound, std::move(ctx.consumed) };
+        }
+
+        // finds the first match like `run`, and then each next one among the arguments of the top-level call the
+        // earlier ones left over. the candidates computed for the first match still hold for the arguments left,
+        // so they are reused
+        void run_all(const Ast& expr, std::span<const std::size_t> pivot_order, const std::function<bool(const Match&)>& f)
+        {
+            std::optional<Match> match = run(expr, pivot_order);
+            const auto accept = []() { return true; };
+
+            while (match && f(*match))
+            {
+                // the match consumed the whole expression, so nothing is left over
+                if (match->consumed.count() == match->consumed.size())
+                    return;
+
+                if (ctx.excluded.size())
+                    ctx.excluded |= match->consumed;
+                else
+                    ctx.excluded = std::move(match->consumed);
+
+                ctx.bound.fill(nullptr);
+                match.reset();
+
+                if (search(0, expr, accept))
+                    match = Match{ ctx.bound, std::move(ctx.consumed) };
+            }
+        }
+
+        // intersects the values recorded for each occurrence of a repeated tag. returns false if any tag has
+        // no value all its occurrences agree upon
+        bool intersect_occurrences()
+        {
+            std::unordered_set<Id> values;
+
+            for (const auto& [occurrence, entry] : ctx.occurrences)
+            {
+                const auto& [tag, exprs] = entry;
+                values.clear();
+
+                for (const Ast* expr : exprs)
+                    values.insert(ctx.id(*expr));
+
+                const auto [it, inserted] = ctx.allowed.try_emplace(tag, values);
+
+                if (!inserted)
+                    std::erase_if(it->second, [&](Id id) { return !values.contains(id); });
+                if (it->second.empty())
+                    return false;
+            }
+            return true;
+        }
+
+        // local conflict resolution. if a group of `n` predicates together only have the same `n` candidates,
+        // those candidates must be claimed by that group in every possible assignment, and are removed from
+        // all other predicates. a group of more than `n` predicates sharing `n` candidates can never be
+        // assigned
+        static bool resolve(Candidates& candidates)
+        {
+            const std::size_t k = candidates.size();
+            std::vector<bool> settled(k, false);
+            std::vector<std::size_t> group;
+            bool changed = true;
+
+            while (changed)
+            {
+                changed = false;
+
+                for (std::size_t i = 0; i < k; i++)
+                {
+                    if (settled[i])
+                        continue;
+
+                    const std::size_t count = candidates[i].count();
+
+                    if (count == 0)
+                        return false;
+
+                    group.clear();
+
+                    for (std::size_t j = 0; j < k; j++)
+                    {
+                        if (!settled[j] && candidates[j].is_subset_of(candidates[i]))
+                            group.push_back(j);
+                    }
+                    if (group.size() > count)
+                        return false;
+                    if (group.size() < count)
+                        continue;
+
+                    const Bitset claimed = candidates[i];
+
+                    for (const std::size_t j : group)
+                        settled[j] = true;
+
+                    for (std::size_t j = 0; j < k; j++)
+                    {
+                        if (settled[j] || !candidates[j].intersects(claimed))
+                            continue;
+                        candidates[j].subtract(claimed);
+                        changed = true;
+
+                        if (candidates[j].none())
+                            return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // determines whether each predicate can be assigned a distinct candidate, using augmenting paths
+        static bool assignable(const Candidates& candidates, std::size_t n)
+        {
+            constexpr std::size_t UNASSIGNED = SIZE_MAX;
+            std::vector<std::size_t> owner(n, UNASSIGNED);
+            Bitset visited(n);
+
+            const auto augment = [&](const auto& augment, std::size_t i) -> bool
+            {
+                return candidates[i].find_if([&](std::size_t j)
+                {
+                    if (visited.test(j))
+                        return false;
+                    visited.set(j);
+
+                    if (owner[j] == UNASSIGNED || augment(augment, owner[j]))
+                    {
+                        owner[j] = i;
+                        return true;
+                    }
+                    return false;
+                });
+            };
+
+            for (std::size_t i = 0; i < candidates.size(); i++)
+            {
+                visited = Bitset(n);
+
+                if (!augment(augment, i))
+                    return false;
+            }
+            return true;
+        }
+    };
+}
+
+engine::match::Session::Session(std::uint64_t run)
+{
+    assert(!impl::context.run && "sessions don't nest");
+    impl::context.store.clear();
+    impl::context.run = run;
+}
+
+engine::match::Session::~Session()
+{
+    impl::context.store.clear();
+    impl::context.run = 0;
+}
+
+std::optional<Match> engine::match::match
+(
+    bytecode::View program,
+    const ast::Ast& expr,
+    std::span<const std::size_t> pivot_order
+) {
+    const impl::Pattern pattern{ program };
+    return impl::Matcher{ impl::context, pattern }.run(expr, pivot_order);
+}
+
+void engine::match::match_all
+(
+    bytecode::View program,
+    const ast::Ast& expr,
+    std::span<const std::size_t> pivot_order,
+    const std::function<bool(const Match&)>& f
+) {
+    const impl::Pattern pattern{ program };
+    impl::Matcher{ impl::context, pattern }.run_all(expr, pivot_order, f);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "ast/ast.h"
+#include "engine/bitset.h"
+#include "engine/bytecode.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+
+namespace engine::match
+{
+    // sub-expressions bound to each tag by a successful match, or null for tags not present in the predicate
+    using Bindings = std::array<const ast::Ast*, 256>;
+
+    struct Match
+    {
+        Bindings tags;
+
+        // arguments of the matched top-level call consumed by the predicate. a predicate call may match only a
+        // subset of the arguments of a flattened call (e.g. `1 * Any[0]` against `*(x, 1, y)`), in which case
+        // the arguments not set here have to be carried over to the rewritten expression. empty if the
+        // predicate matched the expression as a whole
+        Bitset consumed;
+    };
+
+    // keeps the expressions the matcher of the calling thread interns from one match to the next, for as long as
+    // the session lasts, rather than interning them anew for every match. meant to last for a run of
+    // `rewrite::innermost`, whose number `run` is: the calls it marks in normal form aren't altered for the rest of
+    // the run, so their ids are recorded on them and reused by every later match (see `ast::Call::interned`).
+    // sessions don't nest
+    struct Session
+    {
+        explicit Session(std::uint64_t run);
+        ~Session();
+
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+    };
+
+    // determines whether a predicate call of the function may match a subset of the arguments of a call with
+    // more arguments. only possible if the left-over arguments can be re-associated with the rewritten ones
+    constexpr bool extensible(const ast::function::Function* fn)
+    {
+        using namespace ast::function::prelude;
+
+        return fn->arity_type == ArityType::DYNAMIC && (
+            (fn->commutativity == Commutativity::ALL  && fn->associativity == Associativity::ALL) ||
+            (fn->commutativity == Commutativity::TAIL && fn->associativity == Associativity::LEFT)
+        );
+    }
+
+    // attempts to match an expression against a compiled predicate. the instruction stream is first run against
+    // the expression to check the heads, numbers of arguments and leaves any match requires, which turns down
+    // attempts whose shape could never match. the match itself is then done in three steps (see the readme):
+    //
+    //   1. for each argument of each predicate call, the arguments of the expression call it could match
+    //      are recorded as candidates in a bitset
+    //   2. local conflicts are resolved by removing candidates claimed by a group of `n` predicates sharing
+    //      the same `n` candidates from all other predicates in the call
+    //   3. the candidates of all occurrences of a repeated tag are intersected globally
+    //
+    // the remaining candidates are then searched for a consistent assignment of tags, most constrained
+    // argument first. `pivot_order` optionally specifies the order in which the candidates of the top-level
+    // predicate arguments are computed such that a failing match is rejected as early as possible
+    std::optional<Match> match
+    (
+        bytecode::View program,
+        const ast::Ast& expr,
+        std::span<const std::size_t> pivot_order = {}
+    );
+
+    // matches a compiled predicate like above, and then again and again among the arguments of a flattened call
+    // which no earlier match consumed, such that every disjoint match of a wide call is found at once. invokes
+    // `f` with each match until none is left or `f` returns false. the matches refer into the expression, which
+    // must not be altered until this returns
+    void match_all
+    (
+        bytecode::View program,
+        const ast::Ast& expr,
+        std::span<const std::size_t> pivot_order,
+        const std::function<bool(const Match&)>& f
+    );
+}
@@ -5,26 +5,21 @@
 #include <memory>
 #include <vector>
 #include <optional>
-#include <type_traits>
 #include <span>
 #include <cassert>
 
+// the tree of a predicate as parsed from the text of a rule, see `source.h`. rules known at compile time are
+// written with the builders of `table.h` instead
 namespace engine::predicate
 {
     struct Predicate;
 
-    template<class Child>
-    struct Taggable
-    {
-        Predicate operator[](std::uint8_t tag);
-    };
-
-    struct Any : Taggable<Any>
+    struct Any
     {
         Any() {}
     };
 
-    struct Literal : Taggable<Literal>
+    struct Literal
     {
         std::optional<double> value;
 
@@ -39,23 +34,17 @@ namespace engine::predicate
         Tag(Predicate nested, std::uint8_t tag);
     };
 
-    struct Variable : Taggable<Variable>
+    struct Variable
     {
         Variable() {}
-
-        Predicate operator[](std::uint8_t tag);
     };
 
-    struct Call : Taggable<Call>
+    struct Call
     {
         const ast::function::Function* fn;
         std::vector<Predicate> args;
-        
-        template<class... Args>
-        Call(std::string_view identifier, Args&&... args);
-        Call(const ast::function::Function* fn, std::vector<Predicate> args);
 
-        Predicate operator[](std::uint8_t tag);
+        Call(const ast::function::Function* fn, std::vector<Predicate> args);
     };
 
     struct Predicate : Variant<Any, Literal, Tag, Variable, Call>
@@ -65,25 +54,11 @@ namespace engine::predicate
         // implicitly delete copy constructor to forbid accidental copies
         Predicate(Predicate&&) = default;
         Predicate& operator=(Predicate&&) = default;
-
-        Predicate(double value) : Predicate(Literal{ value }) {}
     };
-    
-    template<class Child>
-    Predicate Taggable<Child>::operator[](std::uint8_t tag)
-    {
-        return Tag{ std::move(*static_cast<Child*>(this)), tag };
-    }
 
     inline Tag::Tag(Predicate nested, std::uint8_t tag)
         : nested(std::make_unique<Predicate>(std::move(nested))), tag(tag) {}
-    
-    template<class... Args>
-    inline Call::Call(std::string_view identifier, Args&&... args) : Call
-    (
-        ast::function::get(identifier, sizeof...(args)),
-        move_to_vector<Predicate>(std::forward<Args>(args)...)
-    ) {}
+
 
     inline Call::Call(const ast::function::Function* fn, std::vector<Predicate> args)
         : fn(fn), args(std::move(args))
@@ -2,10 +2,11 @@
 #include "ast/ast.h"
 
 #include <functional>
-#include <type_traits>
 #include <vector>
 #include <cassert>
 
+// the tree of a result as parsed from the text of a rule, see `source.h`. rules known at compile time are
+// written with the builders of `table.h` instead
 namespace engine::result
 {
     struct Result;
@@ -25,8 +26,6 @@ namespace engine::result
         const ast::function::Function* fn;
         std::vector<Result> args;
 
-        template<class... Args>
-        Call(std::string_view identifier, Args&&... args);
         Call(const ast::function::Function* fn, std::vector<Result> args);
     };
 
@@ -37,9 +36,6 @@ namespace engine::result
         // implicitly delete copy constructor to forbid accidental copies
         Result(Result&&) = default;
         Result& operator=(Result&&) = default;
-
-        template<class T> requires(std::is_convertible_v<T, ast::Ast>)
-        Result(T expr) : Result(Ast{ std::move(expr) }) {}
     };
 
     inline Call::Call(const ast::function::Function* fn, std::vector<Result> args)
@@ -48,13 +44,6 @@ namespace engine::result
         assert(fn);
     }
 
-    template<class... Args>
-    inline Call::Call(std::string_view identifier, Args&&... args) : Call
-    (
-        ast::function::get(identifier, sizeof...(args)),
-        move_to_vector<Result>(std::forward<Args>(args)...)
-    ) {}
-
     namespace prelude
     {
         using result::Tag;
@@ -0,0 +1,358 @@
+#include "rewrite.h"
+#include "ast/canonical.h"
+#include "engine/match.h"
+#include "eval/fold.h"
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+using namespace engine::rewrite;
+using namespace ast::prelude;
+using namespace function::prelude;
+
+namespace impl
+{
+    // each run marks the nodes it finds in normal form with its own number, such that marks left by earlier
+    // runs, possibly with other rules, are never mistaken for its own
+    static std::atomic<std::uint64_t> runs = 0;
+
+    static bool marked(const Ast& ast, std::uint64_t run)
+    {
+        return ast.has<Call>() && ast.get<Call>().normal == run;
+    }
+
+    // merges the arguments which are calls of the same function into the call, see `engine::evaluate_expr`.
+    // the arguments are flattened already, so only one level has to be merged
+    static void flatten(Call& call)
+    {
+        const auto mergeable = [&](std::size_t i)
+        {
+            const Ast& arg = call.args[i];
+            const bool associativity_match =
+                (call.fn->associativity == Associativity::LEFT && i == 0) ||
+                (call.fn->associativity == Associativity::RIGHT && i == call.args.size() - 1) ||
+                (call.fn->associativity == Associativity::ALL);
+            return associativity_match && call.fn->arity_type == ArityType::DYNAMIC
+                && arg.has<Call>() && arg.get<Call>().fn == call.fn;
+        };
+
+        std::size_t i = 0;
+
+        while (i < call.args.size() && !mergeable(i))
+            i++;
+
+        if (i == call.args.size())
+            return;
+
+        // kept across calls. the merged arguments are moved back where they fit, such that the call keeps its
+        // buffer, and handed over otherwise
+        static thread_local std::vector<Ast> args;
+        args.clear();
+
+        for (std::size_t j = 0; j < call.args.size(); j++)
+        {
+            if (j < i || !mergeable(j))
+            {
+                args.push_back(std::move(call.args[j]));
+                continue;
+            }
+            std::vector<Ast>& nested = call.args[j].get<Call>().args;
+            args.insert(args.end(), std::make_move_iterator(nested.begin()), std::make_move_iterator(nested.end()));
+        }
+
+        if (call.args.capacity() >= args.size())
+        {
+            call.args.clear();
+            std::move(args.begin(), args.end(), std::back_inserter(call.args));
+        }
+        else
+        {
+            call.args.swap(args);
+        }
+        args.clear();
+    }
+
+    static void mark(Ast& ast, std::uint64_t run)
+    {
+        // an id recorded by an earlier run refers into the store of that run
+        if (ast.has<Call>())
+        {
+            ast.get<Call>().normal = run;
+            ast.get<Call>().interned = UINT32_MAX;
+        }
+    }
+
+    // the hash (see `ast::canonical::hash`) and number of nodes of a subexpression
+    struct Summary
+    {
+        std::uint64_t hash;
+        std::size_t size;
+    };
+
+    // summarizes every subexpression of an expression, in pre-order. computed bottom-up in one pass, since
+    // hashing or counting each subexpression by itself would walk the lower levels once per level above them.
+    // only the subexpressions which may be memoized are hashed, along with their arguments
+    static void summarize(const Ast& ast, std::vector<Summary>& out)
+    {
+        static thread_local std::vector<const Ast*> nodes;
+        static thread_local std::vector<const Ast*> stack;
+        nodes.clear();
+        stack.assign(1, &ast);
+
+        while (!stack.empty())
+        {
+            const Ast* node = stack.back();
+            stack.pop_back();
+            nodes.push_back(node);
+
+            if (node->has<Call>())
+            {
+                const std::vector<Ast>& args = node->get<Call>().args;
+
+                for (std::size_t i = args.size(); i-- > 0;)
+                    stack.push_back(&args[i]);
+            }
+        }
+
+        const auto hash_leaf = [](const Ast& leaf)
+        {
+            return leaf.has<Literal>()
+                ? ast::canonical::hash_literal(leaf.get<Literal>().value)
+                : ast::canonical::hash_variable(leaf.get<Variable>().identifier);
+        };
+
+        // the arguments of the node at `i` follow it, each one after the subexpression of the one before
+        out.resize(nodes.size());
+
+        for (std::size_t i = nodes.size(); i-- > 0;)
+        {
+            if (!nodes[i]->has<Call>())
+            {
+                out[i] = { 0, 1 };
+                continue;
+            }
+
+            const Call& call = nodes[i]->get<Call>();
+            std::size_t size = 1;
+
+            for (std::size_t arg = 0; arg < call.args.size(); arg++)
+                size += out[i + size].size;
+            out[i] = { 0, size };
+
+            if (size > MAX_MEMO_NODES)
+                continue;
+
+            ast::canonical::CallHasher hasher(call.fn);
+            std::size_t next = i + 1;
+
+            for (const Ast& arg : call.args)
+            {
+                hasher.add(arg.has<Call>() ? out[next].hash : hash_leaf(arg));
+                next += out[next].size;
+            }
+            out[i].hash = hasher.finish();
+        }
+    }
+
+    enum struct Recall
+    {
+        // the subexpression is to be rewritten, and is memoized once it is if a key was pushed
+        MISS,
+        // the subexpression is in normal form as it is
+        SAME,
+        // the subexpression was replaced by its normal form
+        REPLACED,
+    };
+
+    // looks up the normal form of a subexpression in the memo. if it isn't there but is to be memoized, its key
+    // is pushed onto `keys`
+    static Recall recall(Ast& node, const Summary& summary, bool memoize, std::uint64_t run, Memo& memo, std::vector<SubtreeKey>& keys)
+    {
+        if (!node.has<Call>() || summary.size < MIN_MEMO_NODES || summary.size > MAX_MEMO_NODES)
+            return Recall::MISS;
+
+        if (const auto hit = memo.find(SubtreeRef{ summary.hash, &node }))
+        {
+            if (*hit)
+                node = (*hit)->copy();
+            mark(node, run);
+            return *hit ? Recall::REPLACED : Recall::SAME;
+        }
+
+        if (memoize)
+            keys.push_back({ summary.hash, node.copy() });
+        return Recall::MISS;
+    }
+
+    static Stats innermost(Ast& ast, const engine::table::View& rules, const Options& options)
+    {
+        const std::uint64_t run = ++runs;
+        const engine::match::Session session(run);
+        Stats stats;
+
+        // nodes whose arguments are being brought into normal form. `changed` is set once the node or any of
+        // its arguments was rewritten, since it then has to be flattened and sorted again. the arguments of a
+        // rewritten node which aren't marked were built by the rule, and have not been normalized either.
+        // `keyed` is set for the nodes whose key is on top of `keys` by the time they are in normal form
+        struct Frame
+        {
+            Ast* node;
+            std::size_t next;
+            bool rewritten;
+            bool changed;
+            bool keyed;
+        };
+        std::vector<Frame> stack;
+        std::vector<SubtreeKey> keys;
+
+        // the nodes of the expression as given are entered in pre-order, subexpressions found in the memo
+        // being skipped as a whole, such that `position` is the index of the summary of the next one
+        static thread_local std::vector<Summary> summaries;
+        std::size_t position = 0;
+
+        if (options.memo)
+            summarize(ast, summaries);
+
+        // pushes a node of the expression as given, unless its normal form is memoized. returns whether it was
+        // replaced by a different one. only the outermost subexpressions memoized are keyed, since keying every
+        // one below them as well would copy each node once per level above it. the ones below are still looked
+        // up, since they may have been memoized as the outermost ones of another expression
+        const auto enter = [&](Ast& node)
+        {
+            if (!options.memo)
+            {
+                stack.push_back({ &node, 0, false, false, false });
+                return false;
+            }
+
+            const Summary& summary = summaries[position];
+            const std::size_t pending = keys.size();
+            const Recall recalled = recall(node, summary, keys.empty(), run, *options.memo, keys);
+
+            if (recalled == Recall::MISS)
+            {
+                stack.push_back({ &node, 0, false, false, keys.size() > pending });
+                position++;
+                return false;
+            }
+            position += summary.size;
+            return recalled == Recall::REPLACED;
+        };
+        enter(ast);
+
+        while (!stack.empty())
+        {
+            Frame& frame = stack.back();
+            Ast& node = *frame.node;
+
+            if (node.has<Call>() && frame.next < node.get<Call>().args.size())
+            {
+                Ast& arg = node.get<Call>().args[frame.next++];
+
+                // the arguments of a rewritten node are either new, or were copied from nodes in normal form.
+                // only the nodes of the expression as given are normalized, and therefore memoized
+                if (marked(arg, run))
+                    continue;
+                if (frame.rewritten)
+                    stack.push_back({ &arg, 0, false, true, false });
+                else if (enter(arg))
+                    frame.changed = true;
+                continue;
+            }
+
+            if (frame.changed && node.has<Call>())
+            {
+                flatten(node.get<Call>());
+                eval::fold(node);
+
+                if (node.has<Call>())
+                    ast::canonical::sort_arguments(node.get<Call>());
+            }
+
+            if (stats.rewrites < options.max_rewrites)
+            {
+                stats.visits++;
+
+                if (const std::size_t applied = rules.apply(node))
+                {
+                    stats.rewrites += applied;
+                    frame.next = 0;
+                    frame.rewritten = true;
+                    frame.changed = true;
+                    continue;
+                }
+            }
+            else
+            {
+                stats.exhausted = true;
+            }
+
+            mark(node, run);
+
+            // a normal form reached within the budget is the same wherever the subexpression occurs
+            if (frame.keyed)
+            {
+                SubtreeKey key = std::move(keys.back());
+                keys.pop_back();
+
+                if (!stats.exhausted)
+                    options.memo->insert(std::move(key), frame.changed ? std::make_shared<const Ast>(node.copy()) : nullptr);
+            }
+
+            const bool changed = frame.changed;
+            stack.pop_back();
+
+            if (changed && !stack.empty())
+                stack.back().changed = true;
+        }
+        return stats;
+    }
+}
+
+Stats engine::rewrite::innermost(ast::Ast& ast, const table::View& rules, const Options& options)
+{
+    return impl::innermost(ast, rules, options);
+}
+
+bool engine::rewrite::SubtreeEqual::identical(const ast::Ast& a, const ast::Ast& b)
+{
+    std::vector<std::pair<const Ast*, const Ast*>> stack{ { &a, &b } };
+
+    while (!stack.empty())
+    {
+        const auto [next_a, next_b] = stack.back();
+        stack.pop_back();
+
+        const bool equal = std::visit(Overload
+        {
+            [&](const Call& a, const Call& b) -> bool
+            {
+                if (a.fn != b.fn || a.args.size() != b.args.size())
+                    return false;
+
+                for (std::size_t i = a.args.size(); i-- > 0;)
+                    stack.emplace_back(&a.args[i], &b.args[i]);
+                return true;
+            },
+            [](const Literal& a, const Literal& b) -> bool
+            {
+                return std::bit_cast<std::uint64_t>(a.value) == std::bit_cast<std::uint64_t>(b.value);
+            },
+            [](const Variable& a, const Variable& b) -> bool
+            {
+                return a.identifier == b.identifier;
+            },
+            [](const auto&, const auto&) -> bool
+            {
+                return false;
+            },
+        }, *next_a, *next_b);
+
+        if (!equal)
+            return false;
+    }
+    return true;
+}
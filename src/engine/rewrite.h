@@ -0,0 +1,97 @@
+#pragma once
+#include "ast/ast.h"
+#include "engine/cache.h"
+#include "engine/table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// applies rules to an expression until none of them applies anywhere, i.e. until it is in normal form
+namespace engine::rewrite
+{
+    // a normalized subexpression along with its hash, see `ast::canonical::hash`
+    struct SubtreeKey
+    {
+        std::uint64_t hash;
+        ast::Ast ast;
+    };
+
+    // looks up a subexpression without copying it
+    struct SubtreeRef
+    {
+        std::uint64_t hash;
+        const ast::Ast* ast;
+    };
+
+    struct SubtreeHash
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(const SubtreeKey& key) const { return static_cast<std::size_t>(key.hash); }
+        std::size_t operator()(const SubtreeRef& key) const { return static_cast<std::size_t>(key.hash); }
+    };
+
+    // literals are compared by their exact bit pattern rather than by `double_equality`, since the normal form
+    // of an expression is not that of another one whose literals are merely close to its own
+    struct SubtreeEqual
+    {
+        using is_transparent = void;
+
+        static const ast::Ast& deref(const SubtreeKey& key) { return key.ast; }
+        static const ast::Ast& deref(const SubtreeRef& key) { return *key.ast; }
+
+        static bool identical(const ast::Ast& a, const ast::Ast& b);
+
+        bool operator()(const auto& a, const auto& b) const
+        {
+            return a.hash == b.hash && identical(deref(a), deref(b));
+        }
+    };
+
+    // the normal forms of subexpressions, shared between runs of the same rules such that a subexpression
+    // repeated between expressions is rewritten once. the value is null for subexpressions which are in normal
+    // form already, which are then left as they are rather than replaced by a copy
+    using Memo = cache::Cache<SubtreeKey, std::shared_ptr<const ast::Ast>, SubtreeHash, SubtreeEqual>;
+
+    // subexpressions smaller than this are cheaper to rewrite than to look up, and larger ones are not memoized
+    // whole since their keys would have to be copied and compared. the subexpressions of a larger expression
+    // are memoized instead
+    constexpr std::size_t MIN_MEMO_NODES = 4;
+    constexpr std::size_t MAX_MEMO_NODES = 64;
+
+    struct Options
+    {
+        // rewrites applied before giving up, since rules may rewrite each other indefinitely, like `a -> b` and
+        // `b -> a`
+        std::size_t max_rewrites = 1 << 20;
+
+        // if given, the subexpressions of the expression as given of between `MIN_MEMO_NODES` and
+        // `MAX_MEMO_NODES` nodes are looked up before they are rewritten, and the outermost of them memoized once
+        // they are. must only ever be used with the same rules
+        Memo* memo = nullptr;
+    };
+
+    struct Stats
+    {
+        // number of times rules were attempted on a node
+        std::size_t visits = 0;
+
+        // number of rules applied
+        std::size_t rewrites = 0;
+
+        // whether `Options::max_rewrites` was reached, in which case the expression may not be in normal form
+        bool exhausted = false;
+    };
+
+    // rewrites an expression innermost-first: rules are attempted on a node only once its arguments are in
+    // normal form. the expression has to be normalized beforehand, see `engine::evaluate_expr`, and is kept
+    // normalized; a rewritten node and its ancestors are flattened, folded and sorted again.
+    //
+    // nodes found in normal form are marked as such (see `Call::normal`), so after a rewrite only the new nodes
+    // of its result are visited, while the subexpressions it copied from the matched node are skipped. each
+    // ancestor of the rewritten node is visited once more, when it would have been visited anyway. the number
+    // of visits is thus the size of the expression plus the size of the results built, rather than the size of
+    // the expression times the number of rewrites
+    Stats innermost(ast::Ast& ast, const table::View& rules, const Options& options = {});
+}
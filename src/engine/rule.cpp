@@ -1,14 +1,98 @@
 #include "rule.h"
+#include "match.h"
 #include "utility.h"
 
+#include <algorithm>
+#include <numeric>
 using namespace engine::rule;
+using namespace ast::prelude;
 
-Rule::Rule(Predicate predicate, Result result) : predicate(std::move(predicate)), result(std::move(result))
+namespace impl
 {
-    
+    namespace pd = engine::predicate;
+    namespace rs = engine::result;
+
+    // ranks how many expressions a predicate may match, lower is more selective
+    static int selectivity(const Predicate& predicate)
+    {
+        return predicate.visit
+        (
+            [](const pd::Literal& p) { return p.value ? 0 : 3;                 },
+            [](const pd::Call&)      { return 1;                               },
+            [](const pd::Variable&)  { return 2;                               },
+            [](const pd::Any&)       { return 4;                               },
+            [](const pd::Tag& p)     { return selectivity(*p.nested);          }
+        );
+    }
+
+    // builds the expression described by a result from the sub-expressions bound by a match
+    static Ast build(const Result& result, const engine::match::Bindings& tags)
+    {
+        return result.visit
+        (
+            [&](const rs::Tag& r) -> Ast
+            {
+                const Ast* bound = tags[r.value];
+                assert(bound && "result refers to a tag not bound by the predicate");
+                return bound->copy();
+            },
+            [&](const rs::Ast& r) -> Ast
+            {
+                return r.value.copy();
+            },
+            [&](const rs::Call& r) -> Ast
+            {
+                std::vector<Ast> args;
+                args.reserve(r.args.size());
+
+                for (const Result& arg : r.args)
+                    args.push_back(build(arg, tags));
+                return Call{ r.fn, std::move(args) };
+            }
+        );
+    }
+}
+
+Rule::Rule(Predicate predicate, Result result)
+    : predicate(std::move(predicate)), result(std::move(result)), program(bytecode::compile(this->predicate))
+{
+    if (this->predicate.has<predicate::Call>())
+    {
+        const auto& args = this->predicate.get<predicate::Call>().args;
+        pivot_order.resize(args.size());
+        std::iota(pivot_order.begin(), pivot_order.end(), 0);
+        std::ranges::stable_sort(pivot_order, {}, [&](std::size_t i) { return impl::selectivity(args[i]); });
+    }
 }
 
-ast::Ast Rule::apply(ast::Ast expr) const
+bool Rule::apply(ast::Ast& expr) const
 {
-    assert(false);
+    std::optional<match::Match> match = match::match(program.view(), expr, pivot_order);
+
+    if (!match)
+        return false;
+
+    replace(expr, impl::build(result, match->tags), match->consumed);
+    return true;
+}
+
+void engine::rule::replace(ast::Ast& expr, ast::Ast out, const Bitset& consumed)
+{
+    if (consumed.count() < consumed.size())
+    {
+        Call& call = expr.get<Call>();
+        const std::size_t first = consumed.next();
+        std::vector<Ast> args;
+        args.reserve(call.args.size() - consumed.count() + 1);
+
+        for (std::size_t i = 0; i < call.args.size(); i++)
+        {
+            if (i == first)
+                args.push_back(std::move(out));
+            else if (!consumed.test(i))
+                args.push_back(std::move(call.args[i]));
+        }
+        out = Call{ call.fn, std::move(args) };
+    }
+    expr = std::move(out);
 }
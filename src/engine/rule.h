@@ -1,6 +1,8 @@
 #pragma once
 #include "predicate.h"
 #include "result.h"
+#include "bytecode.h"
+#include "bitset.h"
 
 namespace engine::rule
 {
@@ -11,15 +13,19 @@ namespace engine::rule
     {
         Predicate predicate;
         Result result;
+        // order in which the arguments of a top-level predicate call are matched, most selective first
         std::vector<std::size_t> pivot_order;
+        // the predicate compiled for the matcher, see `bytecode.h`
+        bytecode::Program program;
 
         Rule(Predicate predicate, Result result);
 
-        ast::Ast apply(ast::Ast expr) const;
+        // attempts to rewrite the expression in place. returns whether the predicate matched
+        bool apply(ast::Ast& expr) const;
     };
 
-    inline Rule operator>(predicate::Predicate predicate, result::Result result)
-    {
-        return Rule{ std::move(predicate), std::move(result) };
-    }
+    // replaces the expression matched by a rule with its rewritten form. if the predicate only consumed some of
+    // the arguments of a flattened call, the rewritten form takes the place of the first consumed argument and
+    // the rest are carried over
+    void replace(ast::Ast& expr, ast::Ast out, const Bitset& consumed);
 }
@@ -0,0 +1,468 @@
+#include "snapshot.h"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <type_traits>
+using namespace engine;
+using namespace engine::snapshot;
+using namespace ast::prelude;
+
+namespace impl
+{
+    namespace bc = engine::bytecode;
+    namespace rs = engine::result;
+    namespace ts = engine::table::result;
+
+    constexpr std::size_t ARRAY_COUNT = 9;
+    constexpr std::size_t HEADER_SIZE = 4 + 2 + 2 + 8 + 8 + 8 * ARRAY_COUNT;
+    constexpr std::size_t ALIGNMENT = 8;
+
+    static_assert(std::is_trivially_copyable_v<bc::Instruction>);
+    static_assert(std::is_trivially_copyable_v<ts::Node>);
+    static_assert(std::is_trivially_copyable_v<table::Entry>);
+    static_assert(std::is_trivially_copyable_v<table::Bucket>);
+    static_assert(alignof(bc::Instruction) <= ALIGNMENT && alignof(ts::Node) <= ALIGNMENT && alignof(table::Bucket) <= ALIGNMENT);
+
+    // identifies everything a snapshot depends on besides its source; the layout of the arrays, and the
+    // functions their indices refer to
+    constexpr std::uint64_t FINGERPRINT = []()
+    {
+        std::uint64_t out = hash(MAGIC);
+
+        const auto mix = [&](std::uint64_t value)
+        {
+            out = (out ^ value) * 0x100000001B3;
+        };
+        mix(sizeof(bc::Instruction));
+        mix(sizeof(ts::Node));
+        mix(sizeof(table::Entry));
+        mix(sizeof(table::Bucket));
+        mix(sizeof(std::size_t));
+        mix(std::endian::native == std::endian::little);
+
+        for (const ast::function::Function& fn : ast::function::ARRAY)
+        {
+            mix(hash(fn.identifier));
+            mix(static_cast<std::uint64_t>(fn.syntax));
+            mix(static_cast<std::uint64_t>(fn.commutativity));
+            mix(static_cast<std::uint64_t>(fn.associativity));
+            mix(static_cast<std::uint64_t>(fn.arity_type));
+            mix(fn.arity);
+        }
+        return out;
+    }();
+
+    static std::size_t align(std::size_t offset)
+    {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    // appends an array to the output at the next aligned offset
+    template<class T>
+    static void put_array(std::vector<std::byte>& out, std::span<const T> values)
+    {
+        out.resize(align(out.size()));
+        const std::size_t offset = out.size();
+        out.resize(offset + values.size_bytes());
+
+        if (!values.empty())
+            std::memcpy(out.data() + offset, values.data(), values.size_bytes());
+    }
+
+    template<class T>
+    static void put_value(std::vector<std::byte>& out, T value)
+    {
+        const auto bytes = std::bit_cast<std::array<std::byte, sizeof(T)>>(value);
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+
+    // result nodes of an expression in pre-order, walked with an explicit stack such that an arbitrarily deep
+    // expression cannot exhaust the native stack
+    static void flatten(const Ast& ast, std::vector<ts::Node>& out, std::vector<std::string_view>& names)
+    {
+        std::vector<const Ast*> stack{ &ast };
+
+        while (!stack.empty())
+        {
+            const Ast* next = stack.back();
+            stack.pop_back();
+
+            next->visit
+            (
+                [&](const Call& e)
+                {
+                    out.push_back({ .kind = ts::Kind::CALL, .arity = static_cast<std::uint32_t>(e.args.size()), .function = ast::function::index(e.fn) });
+
+                    for (auto it = e.args.rbegin(); it != e.args.rend(); ++it)
+                        stack.push_back(&*it);
+                },
+                [&](const Literal& e)
+                {
+                    out.push_back({ .kind = ts::Kind::LITERAL, .value = e.value });
+                },
+                [&](const Variable& e)
+                {
+                    out.push_back({ .kind = ts::Kind::VARIABLE, .name = static_cast<std::uint32_t>(names.size()) });
+                    names.push_back(e.identifier);
+                }
+            );
+        }
+    }
+
+    static void flatten(const rs::Result& result, std::vector<ts::Node>& out, std::vector<std::string_view>& names)
+    {
+        std::vector<const rs::Result*> stack{ &result };
+
+        while (!stack.empty())
+        {
+            const rs::Result* next = stack.back();
+            stack.pop_back();
+
+            next->visit
+            (
+                [&](const rs::Tag& r)
+                {
+                    out.push_back({ .kind = ts::Kind::TAG, .tag = r.value });
+                },
+                [&](const rs::Ast& r)
+                {
+                    flatten(r.value, out, names);
+                },
+                [&](const rs::Call& r)
+                {
+                    out.push_back({ .kind = ts::Kind::CALL, .arity = static_cast<std::uint32_t>(r.args.size()), .function = ast::function::index(r.fn) });
+
+                    for (auto it = r.args.rbegin(); it != r.args.rend(); ++it)
+                        stack.push_back(&*it);
+                }
+            );
+        }
+    }
+
+    // bounds-checked reading of the header and arrays
+    struct Cursor
+    {
+        std::span<const std::byte> data;
+        std::size_t offset = 0;
+
+        template<class T>
+        T value()
+        {
+            if (data.size() - offset < sizeof(T))
+                throw Error("truncated snapshot");
+
+            std::array<std::byte, sizeof(T)> bytes;
+            std::memcpy(bytes.data(), data.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return std::bit_cast<T>(bytes);
+        }
+
+        template<class T>
+        std::span<const T> array(std::uint64_t count)
+        {
+            offset = std::min(align(offset), data.size());
+
+            if (count > (data.size() - offset) / sizeof(T))
+                throw Error("truncated snapshot");
+
+            const std::span<const T> out{ reinterpret_cast<const T*>(data.data() + offset), static_cast<std::size_t>(count) };
+            offset += out.size_bytes();
+            return out;
+        }
+    };
+
+    // checks that the compiled predicate of a rule is well-formed as far as the matcher relies on it, and
+    // records the tags it binds. it is walked from the root like the matcher does, and has to form a tree; every
+    // entry point is reached at most once and only leads forwards, so matching neither loops nor revisits a
+    // shared predicate exponentially often
+    static void validate_predicate(bc::View program, std::array<bool, 256>& bound)
+    {
+        const std::span<const bc::Instruction> code = program.code;
+        std::vector<bool> visited(code.size());
+        std::vector<std::size_t> stack{ 0 };
+
+        while (!stack.empty())
+        {
+            const std::size_t pc = stack.back();
+            stack.pop_back();
+
+            if (pc >= code.size() || visited[pc])
+                throw Error("malformed predicate");
+            visited[pc] = true;
+
+            const bc::Instruction& in = code[pc];
+
+            switch (in.op)
+            {
+            case bc::Op::ANY:
+            case bc::Op::CHECK_LITERAL:
+            case bc::Op::CHECK_VARIABLE:
+                break;
+            case bc::Op::BIND_TAG:
+            case bc::Op::COMPARE_TAG:
+                bound[in.tag] = true;
+                stack.push_back(pc + 1);
+                break;
+            case bc::Op::CHECK_HEAD:
+            {
+                if (in.function >= ast::function::ARRAY.size())
+                    throw Error("malformed predicate");
+                if (in.operand > program.args.size() || program.args.size() - in.operand < in.arity)
+                    throw Error("malformed predicate");
+
+                for (std::size_t i = 0; i < in.arity; i++)
+                {
+                    const std::uint32_t entry = program.args[in.operand + i];
+
+                    if (entry <= pc)
+                        throw Error("malformed predicate");
+                    stack.push_back(entry);
+                }
+                break;
+            }
+            default:
+                throw Error("malformed predicate");
+            }
+        }
+    }
+
+    // checks that the result nodes of a rule form exactly one pre-order tree, and only refer to bound tags
+    static void validate_result(std::span<const ts::Node> nodes, std::size_t names, const std::array<bool, 256>& bound)
+    {
+        // number of nodes still expected to complete the tree
+        std::uint64_t open = 1;
+
+        for (const ts::Node& node : nodes)
+        {
+            if (!open)
+                throw Error("malformed result");
+            open--;
+
+            switch (node.kind)
+            {
+            case ts::Kind::TAG:
+                if (!bound[node.tag])
+                    throw Error("result refers to an unbound tag");
+                break;
+            case ts::Kind::LITERAL:
+                break;
+            case ts::Kind::VARIABLE:
+                if (node.name >= names)
+                    throw Error("malformed result");
+                break;
+            case ts::Kind::CALL:
+                if (node.function >= ast::function::ARRAY.size())
+                    throw Error("malformed result");
+                open += node.arity;
+                break;
+            default:
+                throw Error("malformed result");
+            }
+        }
+
+        if (open)
+            throw Error("malformed result");
+    }
+}
+
+std::vector<std::byte> engine::snapshot::write(std::span<const rule::Rule> rules, std::uint64_t source_hash)
+{
+    std::vector<bytecode::Instruction> code;
+    std::vector<std::uint32_t> args;
+    std::vector<std::size_t> pivots;
+    std::vector<table::result::Node> results;
+    std::vector<std::string_view> names;
+    std::vector<table::Entry> entries;
+
+    for (const rule::Rule& rule : rules)
+    {
+        table::Entry& entry = entries.emplace_back();
+        entry.code = static_cast<std::uint32_t>(code.size());
+        entry.args = static_cast<std::uint32_t>(args.size());
+        entry.pivots = static_cast<std::uint32_t>(pivots.size());
+        entry.result = static_cast<std::uint32_t>(results.size());
+
+        code.insert(code.end(), rule.program.code.begin(), rule.program.code.end());
+        args.insert(args.end(), rule.program.args.begin(), rule.program.args.end());
+        pivots.insert(pivots.end(), rule.pivot_order.begin(), rule.pivot_order.end());
+        impl::flatten(rule.result, results, names);
+
+        entry.code_size = static_cast<std::uint32_t>(code.size()) - entry.code;
+        entry.args_size = static_cast<std::uint32_t>(args.size()) - entry.args;
+        entry.pivot_count = static_cast<std::uint32_t>(pivots.size()) - entry.pivots;
+        entry.result_size = static_cast<std::uint32_t>(results.size()) - entry.result;
+    }
+
+    std::vector<table::Key> keys;
+
+    for (const rule::Rule& rule : rules)
+        keys.push_back(table::Lowering::key(rule.program.view()));
+
+    std::vector<std::uint32_t> order(entries.size());
+    std::vector<table::Bucket> buckets(entries.size());
+    std::vector<std::uint32_t> groups(table::GROUP_COUNT + 1);
+    buckets.resize(index::build(keys, order, buckets, groups));
+
+    std::vector<std::byte> out;
+
+    for (const char c : MAGIC)
+        out.push_back(static_cast<std::byte>(c));
+    impl::put_value<std::uint16_t>(out, VERSION);
+    impl::put_value<std::uint16_t>(out, 0);
+    impl::put_value<std::uint64_t>(out, impl::FINGERPRINT);
+    impl::put_value<std::uint64_t>(out, source_hash);
+
+    for (const std::size_t count : { code.size(), args.size(), pivots.size(), results.size(), names.size(), entries.size(), order.size(), buckets.size(), groups.size() })
+        impl::put_value<std::uint64_t>(out, count);
+
+    impl::put_array<bytecode::Instruction>(out, code);
+    impl::put_array<std::uint32_t>(out, args);
+    impl::put_array<std::size_t>(out, pivots);
+    impl::put_array<table::result::Node>(out, results);
+    impl::put_array<table::Entry>(out, entries);
+    impl::put_array<std::uint32_t>(out, order);
+    impl::put_array<table::Bucket>(out, buckets);
+    impl::put_array<std::uint32_t>(out, groups);
+
+    for (const std::string_view name : names)
+    {
+        impl::put_value<std::uint32_t>(out, static_cast<std::uint32_t>(name.size()));
+
+        for (const char c : name)
+            out.push_back(static_cast<std::byte>(c));
+    }
+    return out;
+}
+
+Snapshot::Snapshot(std::span<const std::byte> data)
+{
+    if (reinterpret_cast<std::uintptr_t>(data.data()) % impl::ALIGNMENT)
+        throw Error("misaligned snapshot");
+
+    impl::Cursor cursor{ data };
+
+    for (const char c : MAGIC)
+    {
+        if (cursor.value<char>() != c)
+            throw Error("not a rule snapshot");
+    }
+    if (cursor.value<std::uint16_t>() != VERSION)
+        throw Error("unsupported snapshot version");
+    cursor.value<std::uint16_t>(); // reserved
+
+    if (cursor.value<std::uint64_t>() != impl::FINGERPRINT)
+        throw Error("snapshot was written by an incompatible build");
+    _source_hash = cursor.value<std::uint64_t>();
+
+    std::array<std::uint64_t, impl::ARRAY_COUNT> counts;
+
+    for (std::uint64_t& count : counts)
+        count = cursor.value<std::uint64_t>();
+
+    const auto [code, args, pivots, results, names, rules, order, buckets, groups] = counts;
+    _view.code = cursor.array<bytecode::Instruction>(code);
+    _view.args = cursor.array<std::uint32_t>(args);
+    _view.pivots = cursor.array<std::size_t>(pivots);
+    _view.results = cursor.array<table::result::Node>(results);
+    _view.rules = cursor.array<table::Entry>(rules);
+    _view.order = cursor.array<std::uint32_t>(order);
+    _view.buckets = cursor.array<table::Bucket>(buckets);
+    _view.groups = cursor.array<std::uint32_t>(groups);
+
+    if (names > data.size())
+        throw Error("truncated snapshot");
+    _names.reserve(static_cast<std::size_t>(names));
+
+    for (std::uint64_t i = 0; i < names; i++)
+    {
+        const std::uint32_t length = cursor.value<std::uint32_t>();
+
+        if (data.size() - cursor.offset < length)
+            throw Error("truncated snapshot");
+        _names.emplace_back(reinterpret_cast<const char*>(data.data() + cursor.offset), length);
+        cursor.offset += length;
+    }
+    _view.names = _names;
+
+    // the rules and their index
+    if (_view.order.size() != _view.rules.size() || _view.groups.size() != table::GROUP_COUNT + 1)
+        throw Error("malformed index");
+
+    for (const table::Entry& entry : _view.rules)
+    {
+        const bool in_bounds =
+            entry.code <= code && code - entry.code >= entry.code_size &&
+            entry.args <= args && args - entry.args >= entry.args_size &&
+            entry.pivots <= pivots && pivots - entry.pivots >= entry.pivot_count &&
+            entry.result <= results && results - entry.result >= entry.result_size;
+
+        if (!in_bounds)
+            throw Error("malformed rule");
+
+        const bytecode::View program{ _view.code.subspan(entry.code, entry.code_size), _view.args.subspan(entry.args, entry.args_size) };
+        std::array<bool, 256> bound{};
+        impl::validate_predicate(program, bound);
+        impl::validate_result(_view.results.subspan(entry.result, entry.result_size), _names.size(), bound);
+
+        // pivots are only given for the arguments of a call at the root
+        const std::size_t arity = program.code[0].op == bytecode::Op::CHECK_HEAD ? program.code[0].arity : 0;
+
+        if (entry.pivot_count && entry.pivot_count != arity)
+            throw Error("malformed rule");
+
+        for (const std::size_t pivot : _view.pivots.subspan(entry.pivots, entry.pivot_count))
+        {
+            if (pivot >= arity)
+                throw Error("malformed rule");
+        }
+    }
+
+    if (_view.groups.front() != 0 || _view.groups.back() != _view.buckets.size())
+        throw Error("malformed index");
+
+    for (std::size_t g = 0; g < table::GROUP_COUNT; g++)
+    {
+        if (_view.groups[g] > _view.groups[g + 1])
+            throw Error("malformed index");
+    }
+
+    // the buckets partition the order in sequence, each under the key of every rule in it, and are sorted by
+    // their keys such that they can be searched; each rule is listed exactly once
+    std::vector<bool> listed(_view.rules.size());
+    std::uint32_t next = 0;
+
+    for (std::size_t g = 0; g < table::GROUP_COUNT; g++)
+    {
+        for (std::uint32_t b = _view.groups[g]; b < _view.groups[g + 1]; b++)
+        {
+            const table::Bucket& bucket = _view.buckets[b];
+
+            if (bucket.key.group != g || bucket.first != next || !bucket.size || _view.order.size() - next < bucket.size)
+                throw Error("malformed index");
+            if (b > _view.groups[g] && !(_view.buckets[b - 1].key < bucket.key))
+                throw Error("malformed index");
+            next += bucket.size;
+
+            for (const std::uint32_t rule : _view.order.subspan(bucket.first, bucket.size))
+            {
+                if (rule >= _view.rules.size() || listed[rule] || table::Lowering::key(_view.program(rule)) != bucket.key)
+                    throw Error("malformed index");
+                listed[rule] = true;
+            }
+        }
+    }
+
+    if (next != _view.order.size())
+        throw Error("malformed index");
+}
+
+std::uint64_t Snapshot::source_hash() const
+{
+    return _source_hash;
+}
+
+const table::View& Snapshot::view() const
+{
+    return _view;
+}
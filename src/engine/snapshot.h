@@ -0,0 +1,71 @@
+#pragma once
+#include "engine/rule.h"
+#include "engine/table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// compiled rule sets stored in a file, such that a rule set which has already been compiled is mapped back in
+// place rather than parsed and indexed again. a snapshot holds the arrays of a `table::Table`, which contain
+// no pointers, in the native layout of the build that wrote it:
+//
+//   header    "BISR", version (u16), reserved (u16), fingerprint of the build (u64), hash of the source the
+//             rules were compiled from (u64), number of elements of each array (9 u64)
+//   arrays    code, args, pivots, results, rules, order, buckets and groups, each aligned to 8 bytes
+//   names     length (u32) and chars of each variable name in results
+//
+// a snapshot written by a build with a different layout or list of functions is rejected, since the indices
+// of functions stored in it would refer to other functions
+namespace engine::snapshot
+{
+    constexpr std::string_view MAGIC = "BISR";
+    constexpr std::uint16_t VERSION = 3;
+
+    // malformed snapshot, or one written by an incompatible build
+    struct Error : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    // FNV-1a hash of the source of a rule set, used to tell whether a snapshot is up to date
+    constexpr std::uint64_t hash(std::string_view source)
+    {
+        std::uint64_t out = 0xCBF29CE484222325;
+
+        for (const char c : source)
+        {
+            out ^= static_cast<unsigned char>(c);
+            out *= 0x100000001B3;
+        }
+        return out;
+    }
+
+    // lowers the rules into the arrays of a table, and serializes them along with the hash of their source
+    std::vector<std::byte> write(std::span<const rule::Rule> rules, std::uint64_t source_hash);
+
+    // a snapshot viewed in place. the data has to outlive the snapshot, and is expected to be aligned to 8
+    // bytes, which a memory-mapped file always is
+    struct Snapshot
+    {
+        // validates the header and the contents, such that applying the rules never reads out of bounds
+        explicit Snapshot(std::span<const std::byte> data);
+
+        // the view refers to the table of names, which a copy would not share
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot(Snapshot&&) = default;
+        Snapshot& operator=(Snapshot&&) = default;
+
+        std::uint64_t source_hash() const;
+        const table::View& view() const;
+
+    private:
+        std::uint64_t _source_hash = 0;
+        std::vector<std::string_view> _names;
+        table::View _view;
+    };
+}
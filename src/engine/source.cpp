@@ -0,0 +1,245 @@
+#include "source.h"
+#include "parser/grammar.h"
+#include "parser/lexer.h"
+
+#include <array>
+#include <format>
+#include <optional>
+using namespace engine::rule;
+using namespace ast::function::prelude;
+
+namespace impl
+{
+    namespace pd = engine::predicate;
+    namespace rs = engine::result;
+
+    // counts the nodes built for one side of a rule, rejecting it once it has more than `MAX_SIZE`
+    static void count(const parser::Lexer& lexer, std::size_t& size)
+    {
+        if (++size > MAX_SIZE)
+            throw parser::Error(lexer.last_token_start(), std::format("either side of a rule may have at most {} nodes", MAX_SIZE));
+    }
+
+    // builds predicates, where placeholders match expressions of the kind given by their sigil
+    struct PredicateBuilder
+    {
+        using Node = pd::Predicate;
+        static constexpr std::string_view SIGILS = "$#@";
+
+        const parser::Lexer& lexer;
+        std::size_t size = 0;
+
+        Node literal(double value)
+        {
+            count(lexer, size);
+            return pd::Literal{ value };
+        }
+
+        Node variable(std::string_view identifier)
+        {
+            throw parser::Error(lexer.last_token_start(), std::format("predicates cannot refer to the variable '{}'; use '@n' to match any variable", identifier));
+        }
+
+        Node call(const Function* fn, std::vector<Node> args)
+        {
+            count(lexer, size);
+            return pd::Call{ fn, std::move(args) };
+        }
+
+        Node placeholder(char sigil, std::uint8_t index)
+        {
+            count(lexer, size);
+
+            switch (sigil)
+            {
+            case '#': return pd::Tag{ pd::Literal{ std::nullopt }, index };
+            case '@': return pd::Tag{ pd::Variable{}, index };
+            default:  return pd::Tag{ pd::Any{}, index };
+            }
+        }
+    };
+
+    // builds results, where every placeholder refers to a tag
+    struct ResultBuilder
+    {
+        using Node = rs::Result;
+        static constexpr std::string_view SIGILS = PredicateBuilder::SIGILS;
+
+        const parser::Lexer& lexer;
+        std::size_t size = 0;
+
+        Node literal(double value)
+        {
+            count(lexer, size);
+            return rs::Ast{ ast::Literal{ value } };
+        }
+
+        Node variable(std::string_view identifier)
+        {
+            count(lexer, size);
+            return rs::Ast{ ast::Variable{ std::string(identifier) } };
+        }
+
+        Node call(const Function* fn, std::vector<Node> args)
+        {
+            count(lexer, size);
+            return rs::Call{ fn, std::move(args) };
+        }
+
+        Node placeholder(char, std::uint8_t index)
+        {
+            count(lexer, size);
+            return rs::Tag{ index };
+        }
+    };
+
+    static void bound_tags(const pd::Predicate& predicate, std::array<bool, 256>& out)
+    {
+        std::vector<const pd::Predicate*> stack{ &predicate };
+
+        while (!stack.empty())
+        {
+            const pd::Predicate* next = stack.back();
+            stack.pop_back();
+
+            next->visit
+            (
+                [&](const pd::Tag& p)
+                {
+                    out[p.tag] = true;
+                    stack.push_back(p.nested.get());
+                },
+                [&](const pd::Call& p)
+                {
+                    for (const pd::Predicate& arg : p.args)
+                        stack.push_back(&arg);
+                },
+                [](const auto&) {}
+            );
+        }
+    }
+
+    // returns the first tag in pre-order the result refers to which is not bound by the predicate, if any
+    static std::optional<std::uint8_t> unbound_tag(const rs::Result& result, const std::array<bool, 256>& bound)
+    {
+        std::vector<const rs::Result*> stack{ &result };
+
+        while (!stack.empty())
+        {
+            const rs::Result* next = stack.back();
+            stack.pop_back();
+
+            const std::optional<std::uint8_t> tag = next->visit
+            (
+                [&](const rs::Tag& r) -> std::optional<std::uint8_t>
+                {
+                    return bound[r.value] ? std::nullopt : std::optional{ r.value };
+                },
+                [&](const rs::Call& r) -> std::optional<std::uint8_t>
+                {
+                    for (auto it = r.args.rbegin(); it != r.args.rend(); ++it)
+                        stack.push_back(&*it);
+                    return std::nullopt;
+                },
+                [](const rs::Ast&) -> std::optional<std::uint8_t>
+                {
+                    return std::nullopt;
+                }
+            );
+
+            if (tag)
+                return tag;
+        }
+        return std::nullopt;
+    }
+}
+
+Rule engine::rule::parse(std::string_view text)
+{
+    constexpr std::string_view ARROW = "->";
+    const std::size_t arrow = text.find(ARROW);
+
+    if (arrow == std::string_view::npos)
+        throw SourceError(0, text.size(), "expected '->' between the predicate and the result");
+
+    const std::string_view lhs = text.substr(0, arrow);
+    const std::string_view rhs = text.substr(arrow + ARROW.size());
+    const std::size_t rhs_offset = arrow + ARROW.size();
+
+    predicate::Predicate predicate = [&]()
+    {
+        try
+        {
+            parser::Lexer lexer{ lhs };
+            impl::PredicateBuilder builder{ lexer };
+            return parser::grammar::Parser{ lexer, builder }.parse_input();
+        }
+        catch (const parser::Error& e)
+        {
+            throw SourceError(0, e.column, e.msg);
+        }
+    }();
+
+    result::Result result = [&]()
+    {
+        try
+        {
+            parser::Lexer lexer{ rhs };
+            impl::ResultBuilder builder{ lexer };
+            return parser::grammar::Parser{ lexer, builder }.parse_input();
+        }
+        catch (const parser::Error& e)
+        {
+            throw SourceError(0, rhs_offset + e.column, e.msg);
+        }
+    }();
+
+    std::array<bool, 256> bound{};
+    impl::bound_tags(predicate, bound);
+
+    if (const std::optional<std::uint8_t> tag = impl::unbound_tag(result, bound))
+        throw SourceError(0, rhs_offset, std::format("result refers to tag {} which the predicate does not bind", static_cast<unsigned>(*tag)));
+    return Rule{ std::move(predicate), std::move(result) };
+}
+
+std::vector<Line> engine::rule::lines(std::string_view text)
+{
+    std::vector<Line> out;
+    std::size_t number = 0;
+
+    while (!text.empty())
+    {
+        const std::size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        number++;
+
+        if (line.ends_with('\r'))
+            line.remove_suffix(1);
+
+        const std::size_t start = line.find_first_not_of(" \t");
+
+        if (start == std::string_view::npos || line.substr(start).starts_with("//"))
+            continue;
+        out.push_back({ number, line });
+    }
+    return out;
+}
+
+std::vector<Rule> engine::rule::parse_file(std::string_view text)
+{
+    std::vector<Rule> out;
+
+    for (const Line& line : lines(text))
+    {
+        try
+        {
+            out.push_back(parse(line.text));
+        }
+        catch (const SourceError& e)
+        {
+            throw SourceError(line.number, e.column, e.msg);
+        }
+    }
+    return out;
+}
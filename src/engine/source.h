@@ -0,0 +1,56 @@
+#pragma once
+#include "engine/rule.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// rules written as text, which are parsed at runtime rather than compiled in. a rule is written as
+// `predicate -> result`, where both sides are expressions which may contain placeholders:
+//
+//   $n    matches any expression, and binds it to tag `n`
+//   #n    matches any literal, and binds it to tag `n`
+//   @n    matches any variable, and binds it to tag `n`
+//
+// in the result, each placeholder is replaced by the expression bound to its tag, regardless of its sigil.
+// e.g. `1 * $0 -> $0` or `max(#0, #0) -> #0`. a rule file holds one rule per line; blank lines and lines
+// starting with `//` are ignored
+namespace engine::rule
+{
+    struct SourceError : std::runtime_error
+    {
+        // line of the error, counting from 1. 0 for a single rule parsed on its own
+        std::size_t line;
+
+        // column of the error, counting from 0
+        std::size_t column;
+
+        std::string msg;
+
+        SourceError(std::size_t line, std::size_t column, std::string msg)
+            : std::runtime_error(msg.data()), line(line), column(column), msg(std::move(msg)) {}
+    };
+
+    // most nodes either side of a rule may have. predicates and results are compiled and destroyed by recursing
+    // into them, so this bounds how deep the native stack grows for any rule
+    constexpr std::size_t MAX_SIZE = std::size_t(1) << 12;
+
+    // a line of a rule file holding a rule
+    struct Line
+    {
+        // counting from 1
+        std::size_t number;
+        std::string_view text;
+    };
+
+    // parses a single rule
+    Rule parse(std::string_view text);
+
+    // the lines of a rule file which hold rules, in order, skipping blank lines and comments
+    std::vector<Line> lines(std::string_view text);
+
+    // parses each rule of a rule file, in order
+    std::vector<Rule> parse_file(std::string_view text);
+}
@@ -0,0 +1,253 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+using namespace engine::stats;
+
+namespace impl
+{
+    static std::atomic<bool> on = false;
+
+    // written by a single thread and read by any. the owner adds with a plain load and store, which costs no
+    // more than a non-atomic add, since no other thread ever writes it concurrently
+    struct Counter
+    {
+        std::atomic<std::uint64_t> value = 0;
+
+        void add(std::uint64_t n)
+        {
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        std::uint64_t get() const
+        {
+            return value.load(std::memory_order_relaxed);
+        }
+
+        // only ever raises the value
+        void max(std::uint64_t n)
+        {
+            if (n > value.load(std::memory_order_relaxed))
+                value.store(n, std::memory_order_relaxed);
+        }
+
+        void clear()
+        {
+            value.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    struct PhaseCounters
+    {
+        Counter count;
+        Counter ns;
+        Counter allocations;
+        Counter bytes;
+        Counter peak;
+    };
+
+    struct RuleCounters
+    {
+        Counter attempts;
+        Counter hits;
+        Counter match_ns;
+        Counter build_ns;
+    };
+
+    // the counters of one thread
+    struct Block
+    {
+        std::array<PhaseCounters, PHASE_COUNT> phases;
+        // grown by the owner under `mutex`, which readers hold while reading. a deque keeps its elements in
+        // place as it grows, so the owner counts into them without the lock
+        std::deque<RuleCounters> rules;
+        std::mutex mutex;
+    };
+
+    static void add(Stats& out, const Block& block)
+    {
+        for (std::size_t i = 0; i < PHASE_COUNT; i++)
+        {
+            out.phases[i].count += block.phases[i].count.get();
+            out.phases[i].time += std::chrono::nanoseconds(block.phases[i].ns.get());
+            out.phases[i].allocations += block.phases[i].allocations.get();
+            out.phases[i].bytes += block.phases[i].bytes.get();
+            out.phases[i].peak = std::max(out.phases[i].peak, block.phases[i].peak.get());
+        }
+
+        if (out.rules.size() < block.rules.size())
+            out.rules.resize(block.rules.size());
+
+        for (std::size_t i = 0; i < block.rules.size(); i++)
+        {
+            const RuleCounters& rule = block.rules[i];
+            out.rules[i].attempts += rule.attempts.get();
+            out.rules[i].hits += rule.hits.get();
+            out.rules[i].match_time += std::chrono::nanoseconds(rule.match_ns.get());
+            out.rules[i].build_time += std::chrono::nanoseconds(rule.build_ns.get());
+        }
+    }
+
+    // the blocks of all running threads, and the sum of those which have exited. locked before any block
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<Block*> blocks;
+        Stats retired;
+    };
+
+    static Registry& registry()
+    {
+        // the blocks of the threads still running at exit are destroyed before any object of static storage
+        static Registry registry;
+        return registry;
+    }
+
+    struct Owner
+    {
+        Block block;
+
+        Owner()
+        {
+            Registry& r = registry();
+            const std::scoped_lock lock(r.mutex);
+            r.blocks.push_back(&block);
+        }
+
+        ~Owner()
+        {
+            Registry& r = registry();
+            const std::scoped_lock lock(r.mutex);
+            add(r.retired, block);
+            std::erase(r.blocks, &block);
+        }
+    };
+
+    static Block& local()
+    {
+        static thread_local Owner owner;
+        return owner.block;
+    }
+
+    static std::uint64_t ns(std::chrono::nanoseconds time)
+    {
+        return static_cast<std::uint64_t>(time.count());
+    }
+}
+
+std::string_view engine::stats::name(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::EVALUATE:  return "evaluate";
+    case Phase::PARSE:     return "parse";
+    case Phase::NORMALIZE: return "normalize";
+    case Phase::REWRITE:   return "rewrite";
+    }
+    return "";
+}
+
+void engine::stats::enable(bool enabled)
+{
+    impl::on.store(enabled, std::memory_order_relaxed);
+}
+
+bool engine::stats::enabled()
+{
+    return impl::on.load(std::memory_order_relaxed);
+}
+
+Stats engine::stats::read()
+{
+    impl::Registry& registry = impl::registry();
+    const std::scoped_lock lock(registry.mutex);
+    Stats out = registry.retired;
+
+    for (impl::Block* block : registry.blocks)
+    {
+        const std::scoped_lock block_lock(block->mutex);
+        impl::add(out, *block);
+    }
+    return out;
+}
+
+void engine::stats::reset()
+{
+    impl::Registry& registry = impl::registry();
+    const std::scoped_lock lock(registry.mutex);
+    registry.retired = {};
+
+    for (impl::Block* block : registry.blocks)
+    {
+        const std::scoped_lock block_lock(block->mutex);
+
+        for (impl::PhaseCounters& phase : block->phases)
+        {
+            phase.count.clear();
+            phase.ns.clear();
+            phase.allocations.clear();
+            phase.bytes.clear();
+            phase.peak.clear();
+        }
+
+        for (impl::RuleCounters& rule : block->rules)
+        {
+            rule.attempts.clear();
+            rule.hits.clear();
+            rule.match_ns.clear();
+            rule.build_ns.clear();
+        }
+    }
+}
+
+void engine::stats::record(Phase phase, std::chrono::nanoseconds time, const alloc::Counters& allocations)
+{
+    impl::PhaseCounters& counters = impl::local().phases[static_cast<std::size_t>(phase)];
+    counters.count.add(1);
+    counters.ns.add(impl::ns(time));
+    counters.allocations.add(allocations.count);
+    counters.bytes.add(allocations.bytes);
+    counters.peak.max(allocations.peak);
+}
+
+void engine::stats::record
+(
+    std::size_t rule,
+    std::uint64_t attempts,
+    std::uint64_t hits,
+    std::chrono::nanoseconds match,
+    std::chrono::nanoseconds build
+) {
+    impl::Block& block = impl::local();
+
+    if (rule >= block.rules.size())
+    {
+        const std::scoped_lock lock(block.mutex);
+
+        while (block.rules.size() <= rule)
+            block.rules.emplace_back();
+    }
+
+    impl::RuleCounters& counters = block.rules[rule];
+    counters.attempts.add(attempts);
+    counters.hits.add(hits);
+    counters.match_ns.add(impl::ns(match));
+    counters.build_ns.add(impl::ns(build));
+}
+
+Scope::Scope(Phase phase) : _phase(phase), _enabled(enabled())
+{
+    if (!_enabled)
+        return;
+
+    _allocations.emplace();
+    _start = std::chrono::steady_clock::now();
+}
+
+Scope::~Scope()
+{
+    if (_enabled)
+        record(_phase, std::chrono::steady_clock::now() - _start, _allocations->read());
+}
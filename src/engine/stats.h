@@ -0,0 +1,97 @@
+#pragma once
+#include "engine/alloc.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// opt-in statistics of evaluation: the time and heap allocations spent in each phase, and how often each rule
+// is attempted and applied along with the time that takes. allocations are only counted where the hooks of
+// `engine::alloc` are linked in. each thread counts into counters of its own, which are only ever
+// written by that thread and are summed when read, so counting takes neither locks nor atomic read-modify-writes
+namespace engine::stats
+{
+    enum struct Phase : std::uint8_t
+    {
+        // whole calls of `engine::evaluate_str`, including those answered by the cache, around the phases below
+        EVALUATE,
+        // lexing and parsing, which are interleaved since the parser pulls tokens from the lexer as it goes
+        PARSE,
+        // flattening, folding and sorting, see `engine::evaluate_expr`
+        NORMALIZE,
+        // applying the configured rules, by either strategy
+        REWRITE,
+    };
+    constexpr std::size_t PHASE_COUNT = 4;
+
+    std::string_view name(Phase phase);
+
+    struct PhaseStats
+    {
+        std::uint64_t count = 0;
+        std::chrono::nanoseconds time{};
+        std::uint64_t allocations = 0;
+        std::uint64_t bytes = 0;
+        // most bytes live at once during any single run of the phase, see `alloc::Counters::peak`
+        std::uint64_t peak = 0;
+    };
+
+    struct RuleStats
+    {
+        // times the predicate was matched against an expression, or against an e-class when saturating
+        std::uint64_t attempts = 0;
+        // times the result was built and took the place of what the predicate matched
+        std::uint64_t hits = 0;
+        std::chrono::nanoseconds match_time{};
+        std::chrono::nanoseconds build_time{};
+    };
+
+    struct Stats
+    {
+        std::array<PhaseStats, PHASE_COUNT> phases;
+        // by the index of the rule in the table of the configured rules, see `engine::configure_rules`. only as
+        // long as the highest index counted
+        std::vector<RuleStats> rules;
+    };
+
+    // enables or disables counting, which is disabled by default. counts are kept while disabled
+    void enable(bool enabled);
+    bool enabled();
+
+    // the counts of all threads, including those which have exited
+    Stats read();
+
+    // zeroes all counters. counts made concurrently may be lost
+    void reset();
+
+    // records a phase, or an attempt at applying a rule. only to be called while enabled, see `Scope`
+    void record(Phase phase, std::chrono::nanoseconds time, const alloc::Counters& allocations = {});
+    void record
+    (
+        std::size_t rule,
+        std::uint64_t attempts,
+        std::uint64_t hits,
+        std::chrono::nanoseconds match,
+        std::chrono::nanoseconds build
+    );
+
+    // records the time and allocations until the end of the scope as a phase, if enabled at its start
+    struct Scope
+    {
+        explicit Scope(Phase phase);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Phase _phase;
+        bool _enabled;
+        std::chrono::steady_clock::time_point _start;
+        std::optional<alloc::Scope> _allocations;
+    };
+}
@@ -0,0 +1,204 @@
+#include "table.h"
+#include "rule.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+#include <vector>
+using namespace engine::table;
+using namespace ast::prelude;
+
+namespace impl
+{
+    namespace pd = engine::table::predicate;
+    namespace rs = engine::table::result;
+
+    // builds the expression described by the result nodes starting at `i`, and advances `i` past them
+    static Ast build(std::span<const rs::Node> nodes, std::span<const std::string_view> names, std::size_t& i, const engine::match::Bindings& tags)
+    {
+        const rs::Node& node = nodes[i++];
+
+        switch (node.kind)
+        {
+        case rs::Kind::TAG:
+        {
+            const Ast* bound = tags[node.tag];
+            assert(bound && "result refers to a tag not bound by the predicate");
+            return bound->copy();
+        }
+        case rs::Kind::LITERAL:
+            return Literal{ node.value };
+        case rs::Kind::VARIABLE:
+            return Variable{ std::string(names[node.name]) };
+        case rs::Kind::CALL:
+            break;
+        }
+
+        std::vector<Ast> args;
+        args.reserve(node.arity);
+
+        for (std::uint32_t j = 0; j < node.arity; j++)
+            args.push_back(build(nodes, names, i, tags));
+        return Call{ &function::ARRAY[node.function], std::move(args) };
+    }
+
+    // replaces the arguments of a call consumed by several disjoint matches with their results, each in place
+    // of the first argument it consumed, like `rule::replace` does for a single match
+    static void splice(Call& call, std::vector<std::pair<std::size_t, Ast>>& results, const engine::Bitset& consumed)
+    {
+        std::ranges::sort(results, {}, &std::pair<std::size_t, Ast>::first);
+        std::vector<Ast> args;
+        args.reserve(call.args.size() - consumed.count() + results.size());
+        auto it = results.begin();
+
+        for (std::size_t i = 0; i < call.args.size(); i++)
+        {
+            if (it != results.end() && it->first == i)
+                args.push_back(std::move((it++)->second));
+            else if (!consumed.test(i))
+                args.push_back(std::move(call.args[i]));
+        }
+        call.args = std::move(args);
+    }
+
+    // a small table checked during compilation; tags are compared where repeated, the literal argument is
+    // pivoted first, and the rules are bucketed by the head of their predicate and its literal argument
+    constexpr auto EXAMPLE = compile
+    (
+        pd::Call("+", pd::Any{}[0], pd::Any{}[0]) > rs::Call("*", 2.0, rs::Tag(0)),
+        pd::Call("*", pd::Any{}[0], 1.0) > rs::Tag(0),
+        pd::Any{}[0] > rs::Tag(0)
+    );
+
+    // the same table written with the builders the nodes are spelled out in terms of
+    constexpr auto BUILT = compile
+    (
+        pd::call("+", pd::any()[0], pd::any()[0]) > rs::call("*", 2.0, rs::tag(0)),
+        pd::call("*", pd::any()[0], 1.0) > rs::tag(0),
+        pd::any()[0] > rs::tag(0)
+    );
+
+    consteval bool same_lowering(const auto& a, const auto& b)
+    {
+        for (std::size_t i = 0; i < a.code.size(); i++)
+        {
+            if (a.code[i].op != b.code[i].op || a.code[i].tag != b.code[i].tag || a.code[i].value != b.code[i].value || a.code[i].operand != b.code[i].operand)
+                return false;
+        }
+        for (std::size_t i = 0; i < a.results.size(); i++)
+        {
+            if (a.results[i].kind != b.results[i].kind || a.results[i].tag != b.results[i].tag || a.results[i].value != b.results[i].value)
+                return false;
+        }
+        return a.args == b.args && a.pivots == b.pivots;
+    }
+
+    static_assert(std::is_same_v<decltype(EXAMPLE), decltype(BUILT)> && same_lowering(EXAMPLE, BUILT));
+
+    static_assert(EXAMPLE.code.size() == 5 + 4 + 2);
+    static_assert(EXAMPLE.code[1].op == engine::bytecode::Op::COMPARE_TAG);
+    static_assert(EXAMPLE.code[6].op == engine::bytecode::Op::BIND_TAG);
+    static_assert(EXAMPLE.pivots[2] == 1 && EXAMPLE.pivots[3] == 0);
+    static_assert(EXAMPLE.results.size() == 3 + 1 + 1);
+    static_assert(EXAMPLE.bucket_count == 3 && EXAMPLE.groups[GROUP_COUNT] == 3);
+    static_assert(EXAMPLE.buckets[EXAMPLE.groups[function::index(function::get("*", 2))]].key.keyed);
+    static_assert(EXAMPLE.order[EXAMPLE.buckets[EXAMPLE.groups[WILDCARDS]].first] == 2);
+}
+
+std::size_t View::size() const
+{
+    return rules.size();
+}
+
+engine::bytecode::View View::program(std::size_t rule) const
+{
+    const Entry& entry = rules[rule];
+    return { code.subspan(entry.code, entry.code_size), args.subspan(entry.args, entry.args_size) };
+}
+
+engine::index::Net View::net() const
+{
+    return { order, buckets, groups };
+}
+
+std::span<const std::size_t> View::pivot_order(std::size_t rule) const
+{
+    const Entry& entry = rules[rule];
+    return pivots.subspan(entry.pivots, entry.pivot_count);
+}
+
+void View::candidates
+(
+    std::uint32_t group,
+    std::size_t arity,
+    std::span<const double> literals,
+    std::vector<std::uint32_t>& out
+) const {
+    net().candidates(group, arity, literals, out);
+}
+
+void View::candidates(const ast::Ast& expr, std::vector<std::uint32_t>& out) const
+{
+    net().candidates(expr, out);
+}
+
+std::size_t View::apply(ast::Ast& expr) const
+{
+    static thread_local std::vector<std::uint32_t> found;
+    found.clear();
+    candidates(expr, found);
+
+    // the clock is only read while statistics are enabled, since that costs about as much as a failing match
+    using Clock = std::chrono::steady_clock;
+    const bool counted = stats::enabled();
+    const auto now = [&] { return counted ? Clock::now() : Clock::time_point{}; };
+
+    // the result of each match, by the first argument it consumed
+    std::vector<std::pair<std::size_t, Ast>> rewritten;
+    Bitset consumed;
+
+    for (const std::uint32_t rule : found)
+    {
+        const Entry& entry = rules[rule];
+        const Clock::time_point start = now();
+        Clock::duration building{};
+
+        // every disjoint match of the rule is applied at once, rather than by the caller visiting the call
+        // again after each
+        match::match_all(program(rule), expr, pivot_order(rule), [&](const match::Match& match)
+        {
+            const Clock::time_point built = now();
+            std::size_t i = 0;
+            rewritten.emplace_back(match.consumed.size() ? match.consumed.next() : 0, impl::build(results.subspan(entry.result, entry.result_size), names, i, match.tags));
+
+            if (consumed.size())
+                consumed |= match.consumed;
+            else
+                consumed = match.consumed;
+
+            if (counted)
+                building += Clock::now() - built;
+            return true;
+        });
+
+        if (rewritten.empty())
+        {
+            if (counted)
+                stats::record(rule, 1, 0, Clock::now() - start, {});
+            continue;
+        }
+
+        if (rewritten.size() == 1)
+            rule::replace(expr, std::move(rewritten[0].second), consumed);
+        else
+            impl::splice(expr.get<Call>(), rewritten, consumed);
+
+        if (counted)
+            stats::record(rule, 1, rewritten.size(), Clock::now() - start - building, building);
+        return rewritten.size();
+    }
+    return 0;
+}
@@ -0,0 +1,557 @@
+#pragma once
+#include "engine/bytecode.h"
+#include "engine/index.h"
+#include "engine/match.h"
+#include "ast/ast.h"
+#include "ast/function.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// rule tables built during compilation. rules are written as `Predicate > Result` with the nodes below, which
+// are evaluated in constant evaluation and lower straight into fixed-size arrays, so that a table is a constant
+// in read-only data. loading it allocates nothing, and matching walks contiguous instructions rather than a
+// tree of heap nodes. rules read from text at runtime are parsed into trees instead, see `source.h`:
+//
+//   namespace pd = engine::table::predicate;
+//   namespace rs = engine::table::result;
+//
+//   constexpr auto RULES = engine::table::compile
+//   (
+//       pd::Call("*", 1.0, pd::Any{}[0]) > rs::Tag(0),
+//       pd::Call("+", pd::Any{}[0], pd::Any{}[0]) > rs::Call("*", 2.0, rs::Tag(0))
+//   );
+//
+// the nodes are named after those of the trees in `predicate.h` and `result.h`, and are spelled out in terms of
+// the lowercase builders, which may be used directly as well
+namespace engine::table
+{
+    // predicates lower into the bytecode of `bytecode.h` as they are built. each call places the entry points of
+    // its own arguments first in the argument table, followed by the tables of the arguments in order
+    namespace predicate
+    {
+        template<std::size_t C, std::size_t A>
+        struct Predicate
+        {
+            std::array<bytecode::Instruction, C> code{};
+            std::array<std::uint32_t, A> args{};
+
+            // binds the expression matched by the predicate to a tag. repeated tags are told apart from unique
+            // ones once the whole predicate is known, see `compile`
+            consteval Predicate<C + 1, A> operator[](std::uint8_t tag) const
+            {
+                Predicate<C + 1, A> out;
+                out.code[0] = { .op = bytecode::Op::BIND_TAG, .tag = tag };
+
+                for (std::size_t i = 0; i < C; i++)
+                    out.code[i + 1] = code[i];
+                for (std::size_t i = 0; i < A; i++)
+                    out.args[i] = args[i] + 1;
+                return out;
+            }
+        };
+
+        consteval Predicate<1, 0> any()
+        {
+            Predicate<1, 0> out;
+            out.code[0] = { .op = bytecode::Op::ANY };
+            return out;
+        }
+
+        consteval Predicate<1, 0> literal()
+        {
+            Predicate<1, 0> out;
+            out.code[0] = { .op = bytecode::Op::CHECK_LITERAL };
+            return out;
+        }
+
+        consteval Predicate<1, 0> literal(double value)
+        {
+            Predicate<1, 0> out;
+            out.code[0] = { .op = bytecode::Op::CHECK_LITERAL, .has_value = true, .value = value };
+            return out;
+        }
+
+        consteval Predicate<1, 0> variable()
+        {
+            Predicate<1, 0> out;
+            out.code[0] = { .op = bytecode::Op::CHECK_VARIABLE };
+            return out;
+        }
+
+        consteval Predicate<1, 0> lift(double value)
+        {
+            return literal(value);
+        }
+
+        template<std::size_t C, std::size_t A>
+        consteval const Predicate<C, A>& lift(const Predicate<C, A>& predicate)
+        {
+            return predicate;
+        }
+
+        // copies a predicate into a larger one, relocating its entry points and argument offsets
+        template<std::size_t C0, std::size_t A0, std::size_t C, std::size_t A>
+        consteval void append(Predicate<C0, A0>& out, std::size_t& code, std::size_t& args, const Predicate<C, A>& in)
+        {
+            for (std::size_t i = 0; i < C; i++)
+            {
+                out.code[code + i] = in.code[i];
+
+                if (in.code[i].op == bytecode::Op::CHECK_HEAD)
+                    out.code[code + i].operand += static_cast<std::uint32_t>(args);
+            }
+            for (std::size_t i = 0; i < A; i++)
+                out.args[args + i] = in.args[i] + static_cast<std::uint32_t>(code);
+
+            code += C;
+            args += A;
+        }
+
+        template<std::size_t... C, std::size_t... A>
+        consteval auto compose(std::string_view identifier, const Predicate<C, A>&... args)
+        {
+            constexpr auto arity = static_cast<std::uint32_t>(sizeof...(args));
+            const ast::function::Function* fn = ast::function::get(identifier, arity);
+
+            if (!fn)
+                throw "no function with this identifier accepts this number of arguments";
+
+            Predicate<1 + (C + ... + 0), arity + (A + ... + 0)> out;
+            out.code[0] =
+            {
+                .op = bytecode::Op::CHECK_HEAD,
+                .extensible = match::extensible(fn),
+                .arity = arity,
+                .operand = 0,
+                .function = ast::function::index(fn),
+            };
+
+            std::size_t code = 1;
+            std::size_t next = arity;
+            std::uint32_t i = 0;
+            ((out.args[i++] = static_cast<std::uint32_t>(code), append(out, code, next, args)), ...);
+            return out;
+        }
+
+        // a call of the function with the identifier, whose arguments are predicates or literal constants
+        template<class... Args>
+        consteval auto call(std::string_view identifier, const Args&... args)
+        {
+            return compose(identifier, lift(args)...);
+        }
+
+        // the predicate a call with arguments of the given types lowers into
+        template<class... Args>
+        using Lowered = decltype(compose(std::string_view(), lift(std::declval<const Args&>())...));
+
+        struct Any : Predicate<1, 0>
+        {
+            consteval Any() : Predicate<1, 0>(any()) {}
+        };
+
+        struct Literal : Predicate<1, 0>
+        {
+            consteval Literal() : Predicate<1, 0>(literal()) {}
+            consteval Literal(double value) : Predicate<1, 0>(literal(value)) {}
+        };
+
+        struct Variable : Predicate<1, 0>
+        {
+            consteval Variable() : Predicate<1, 0>(variable()) {}
+        };
+
+        template<class Lowered>
+        struct Call : Lowered
+        {
+            template<class... Args>
+            consteval Call(std::string_view identifier, const Args&... args) : Lowered(call(identifier, args...)) {}
+        };
+
+        template<class... Args>
+        Call(std::string_view, const Args&...) -> Call<Lowered<Args...>>;
+    }
+
+    // results are stored as their nodes in pre-order. like instructions, nodes hold no pointers; functions are
+    // referred to by index and variables by the index of their name in a separate table
+    namespace result
+    {
+        enum struct Kind : std::uint8_t
+        {
+            TAG,
+            LITERAL,
+            VARIABLE,
+            CALL,
+        };
+
+        struct Node
+        {
+            Kind kind = Kind::LITERAL;
+            std::uint8_t tag = 0;
+            std::uint32_t arity = 0;
+            std::uint32_t function = 0;
+            std::uint32_t name = 0;
+            double value = 0.0;
+        };
+
+        template<std::size_t N>
+        struct Result
+        {
+            std::array<Node, N> nodes{};
+            // identifier of each variable node, which is given its index in the table of names by `compile`
+            std::array<std::string_view, N> names{};
+        };
+
+        // the expression bound to a tag by the predicate
+        consteval Result<1> tag(std::uint8_t tag)
+        {
+            return { { Node{ .kind = Kind::TAG, .tag = tag } }, {} };
+        }
+
+        consteval Result<1> literal(double value)
+        {
+            return { { Node{ .kind = Kind::LITERAL, .value = value } }, {} };
+        }
+
+        consteval Result<1> variable(std::string_view identifier)
+        {
+            return { { Node{ .kind = Kind::VARIABLE } }, { identifier } };
+        }
+
+        consteval Result<1> lift(double value)
+        {
+            return literal(value);
+        }
+
+        template<std::size_t N>
+        consteval const Result<N>& lift(const Result<N>& result)
+        {
+            return result;
+        }
+
+        template<std::size_t... N>
+        consteval auto compose(std::string_view identifier, const Result<N>&... args)
+        {
+            constexpr auto arity = static_cast<std::uint32_t>(sizeof...(args));
+            const ast::function::Function* fn = ast::function::get(identifier, arity);
+
+            if (!fn)
+                throw "no function with this identifier accepts this number of arguments";
+
+            Result<1 + (N + ... + 0)> out;
+            out.nodes[0] = { .kind = Kind::CALL, .arity = arity, .function = ast::function::index(fn) };
+            std::size_t next = 1;
+
+            const auto append = [&](const auto& arg)
+            {
+                for (std::size_t i = 0; i < arg.nodes.size(); i++, next++)
+                {
+                    out.nodes[next] = arg.nodes[i];
+                    out.names[next] = arg.names[i];
+                }
+            };
+            (append(args), ...);
+            return out;
+        }
+
+        // a call of the function with the identifier, whose arguments are results or literal constants
+        template<class... Args>
+        consteval auto call(std::string_view identifier, const Args&... args)
+        {
+            return compose(identifier, lift(args)...);
+        }
+
+        // the result a call with arguments of the given types lowers into
+        template<class... Args>
+        using Lowered = decltype(compose(std::string_view(), lift(std::declval<const Args&>())...));
+
+        struct Tag : Result<1>
+        {
+            consteval Tag(std::uint8_t index) : Result<1>(tag(index)) {}
+        };
+
+        struct Literal : Result<1>
+        {
+            consteval Literal(double value) : Result<1>(literal(value)) {}
+        };
+
+        struct Variable : Result<1>
+        {
+            consteval Variable(std::string_view identifier) : Result<1>(variable(identifier)) {}
+        };
+
+        template<class Lowered>
+        struct Call : Lowered
+        {
+            template<class... Args>
+            consteval Call(std::string_view identifier, const Args&... args) : Lowered(call(identifier, args...)) {}
+        };
+
+        template<class... Args>
+        Call(std::string_view, const Args&...) -> Call<Lowered<Args...>>;
+    }
+
+    template<std::size_t C, std::size_t A, std::size_t N>
+    struct Rule
+    {
+        predicate::Predicate<C, A> predicate;
+        result::Result<N> result;
+    };
+
+    namespace predicate
+    {
+        template<std::size_t C, std::size_t A, std::size_t N>
+        consteval Rule<C, A, N> operator>(const Predicate<C, A>& predicate, const result::Result<N>& result)
+        {
+            return { predicate, result };
+        }
+
+        template<std::size_t C, std::size_t A>
+        consteval Rule<C, A, 1> operator>(const Predicate<C, A>& predicate, double value)
+        {
+            return { predicate, result::literal(value) };
+        }
+    }
+
+    // the rules of a table are bucketed by the discrimination net of `index.h`, whose arrays are stored in the
+    // table itself
+    using index::Group;
+    using enum index::Group;
+    using index::quantize;
+    using index::Key;
+    using index::Bucket;
+
+    // location of a rule within the arrays of a table
+    struct Entry
+    {
+        std::uint32_t code = 0;
+        std::uint32_t code_size = 0;
+        std::uint32_t args = 0;
+        std::uint32_t args_size = 0;
+        std::uint32_t pivots = 0;
+        std::uint32_t pivot_count = 0;
+        std::uint32_t result = 0;
+        std::uint32_t result_size = 0;
+    };
+
+    // non-owning view of a table, independent of its sizes. earlier rules take priority over later ones
+    struct View
+    {
+        std::span<const bytecode::Instruction> code;
+        std::span<const std::uint32_t> args;
+        std::span<const std::size_t> pivots;
+        std::span<const result::Node> results;
+        // identifiers of the variables in results, see `result::Node::name`
+        std::span<const std::string_view> names;
+        std::span<const Entry> rules;
+        // indices of the rules of each bucket
+        std::span<const std::uint32_t> order;
+        // sorted by key. the buckets of group `g` are `buckets[groups[g]..groups[g + 1])`
+        std::span<const Bucket> buckets;
+        std::span<const std::uint32_t> groups;
+
+        std::size_t size() const;
+
+        // the compiled predicate of a rule
+        bytecode::View program(std::size_t rule) const;
+
+        // the net over the rules, see `index::Net::candidates`
+        index::Net net() const;
+
+        // order in which the top-level arguments of the predicate of a rule are matched
+        std::span<const std::size_t> pivot_order(std::size_t rule) const;
+
+        // appends the indices of all rules which may match an expression of the group with `arity` arguments to
+        // `out`, in ascending order, along with the rules matching any expression
+        void candidates
+        (
+            std::uint32_t group,
+            std::size_t arity,
+            std::span<const double> literals,
+            std::vector<std::uint32_t>& out
+        ) const;
+
+        // appends the indices of all rules which may match the expression to `out`, in ascending order
+        void candidates(const ast::Ast& expr, std::vector<std::uint32_t>& out) const;
+
+        // applies the first rule that matches the expression, if any. a rule matching some of the arguments of a
+        // flattened call is applied to every disjoint subset of them it matches. returns the number of matches
+        // applied
+        std::size_t apply(ast::Ast& expr) const;
+    };
+
+    template<std::size_t R, std::size_t C, std::size_t A, std::size_t N>
+    struct Table
+    {
+        std::array<bytecode::Instruction, C> code{};
+        std::array<std::uint32_t, A> args{};
+        // order in which the top-level arguments of each predicate are matched, see `rule::Rule::pivot_order`.
+        // a predicate has at most as many top-level arguments as entries in its argument table
+        std::array<std::size_t, A> pivots{};
+        std::array<result::Node, N> results{};
+        std::array<std::string_view, N> names{};
+        std::array<Entry, R> rules{};
+        std::array<std::uint32_t, R> order{};
+        // at most one bucket per rule, of which the first `bucket_count` are used
+        std::array<Bucket, R> buckets{};
+        std::uint32_t bucket_count = 0;
+        std::array<std::uint32_t, GROUP_COUNT + 1> groups{};
+
+        constexpr View view() const
+        {
+            return { code, args, pivots, results, names, rules, order, { buckets.data(), bucket_count }, groups };
+        }
+    };
+
+    // helpers for `compile`, which operate on the lowered instructions
+    struct Lowering
+    {
+        // first instruction of the predicate which is not a tag
+        static constexpr std::size_t untag(std::span<const bytecode::Instruction> code, std::size_t pc)
+        {
+            while (code[pc].op == bytecode::Op::BIND_TAG || code[pc].op == bytecode::Op::COMPARE_TAG)
+                pc++;
+            return pc;
+        }
+
+        // ranks how many expressions a predicate may match, lower is more selective. mirrors the ranking
+        // `rule::Rule` uses for predicate trees
+        static constexpr int selectivity(const bytecode::Instruction& in)
+        {
+            switch (in.op)
+            {
+            case bytecode::Op::CHECK_LITERAL:  return in.has_value ? 0 : 3;
+            case bytecode::Op::CHECK_HEAD:     return 1;
+            case bytecode::Op::CHECK_VARIABLE: return 2;
+            default:                           return 4;
+            }
+        }
+
+        // the key of the expressions a compiled predicate may match. a call is keyed by its first literal argument
+        static constexpr Key key(bytecode::View program)
+        {
+            const std::span<const bytecode::Instruction> code = program.code;
+            const std::size_t pc = untag(code, 0);
+            const bytecode::Instruction& root = code[pc];
+
+            switch (root.op)
+            {
+            case bytecode::Op::CHECK_HEAD:
+            {
+                Key out{ .group = root.function, .extensible = root.extensible, .arity = root.arity };
+
+                for (std::uint32_t i = 0; i < root.arity && !out.keyed; i++)
+                {
+                    const bytecode::Instruction& arg = code[untag(code, program.args[root.operand + i])];
+
+                    if (arg.op == bytecode::Op::CHECK_LITERAL && arg.has_value)
+                    {
+                        out.keyed = true;
+                        out.literal = quantize(arg.value);
+                    }
+                }
+                return out;
+            }
+            case bytecode::Op::CHECK_LITERAL:
+                return { .group = LITERALS, .keyed = root.has_value, .literal = root.has_value ? quantize(root.value) : 0 };
+            case bytecode::Op::CHECK_VARIABLE:
+                return { .group = VARIABLES };
+            default:
+                return { .group = WILDCARDS };
+            }
+        }
+    };
+
+    // lowers rules into a table. tags occurring more than once in a predicate are compared rather than bound,
+    // and the pivot order and key of each rule are computed
+    template<std::size_t... C, std::size_t... A, std::size_t... N>
+    consteval auto compile(const Rule<C, A, N>&... rules)
+    {
+        Table<sizeof...(rules), (C + ... + 0), (A + ... + 0), (N + ... + 0)> out;
+        Entry next;
+        std::uint32_t index = 0;
+        std::uint32_t names = 0;
+
+        const auto add = [&](const auto& rule)
+        {
+            Entry& entry = out.rules[index++];
+            entry = next;
+            entry.code_size = static_cast<std::uint32_t>(rule.predicate.code.size());
+            entry.args_size = static_cast<std::uint32_t>(rule.predicate.args.size());
+            entry.result_size = static_cast<std::uint32_t>(rule.result.nodes.size());
+
+            std::array<std::uint8_t, 256> counts{};
+
+            for (const bytecode::Instruction& in : rule.predicate.code)
+            {
+                if (in.op == bytecode::Op::BIND_TAG)
+                    counts[in.tag]++;
+            }
+            for (std::size_t i = 0; i < entry.code_size; i++)
+            {
+                bytecode::Instruction in = rule.predicate.code[i];
+
+                if (in.op == bytecode::Op::BIND_TAG && counts[in.tag] > 1)
+                    in.op = bytecode::Op::COMPARE_TAG;
+                out.code[entry.code + i] = in;
+            }
+            for (std::size_t i = 0; i < entry.args_size; i++)
+                out.args[entry.args + i] = rule.predicate.args[i];
+            for (std::size_t i = 0; i < entry.result_size; i++)
+            {
+                result::Node node = rule.result.nodes[i];
+
+                if (node.kind == result::Kind::VARIABLE)
+                {
+                    node.name = names;
+                    out.names[names++] = rule.result.names[i];
+                }
+                out.results[entry.result + i] = node;
+            }
+
+            // only a call at the root has its arguments pivoted, which are stably sorted by selectivity
+            const auto& code = rule.predicate.code;
+
+            if (code[0].op == bytecode::Op::CHECK_HEAD)
+            {
+                entry.pivot_count = code[0].arity;
+                std::size_t* pivots = out.pivots.data() + entry.pivots;
+
+                const auto rank = [&](std::size_t arg)
+                {
+                    return Lowering::selectivity(code[Lowering::untag(code, rule.predicate.args[code[0].operand + arg])]);
+                };
+
+                for (std::size_t i = 0; i < entry.pivot_count; i++)
+                {
+                    std::size_t j = i;
+
+                    for (; j > 0 && rank(pivots[j - 1]) > rank(i); j--)
+                        pivots[j] = pivots[j - 1];
+                    pivots[j] = i;
+                }
+            }
+
+            next.code += entry.code_size;
+            next.args += entry.args_size;
+            next.pivots += entry.args_size;
+            next.result += entry.result_size;
+        };
+        (add(rules), ...);
+
+        std::array<Key, sizeof...(rules)> keys{};
+
+        for (std::size_t i = 0; i < keys.size(); i++)
+        {
+            const Entry& entry = out.rules[i];
+            keys[i] = Lowering::key({ std::span(out.code).subspan(entry.code, entry.code_size), std::span(out.args).subspan(entry.args, entry.args_size) });
+        }
+        out.bucket_count = index::build(keys, out.order, out.buckets, out.groups);
+        return out;
+    }
+}
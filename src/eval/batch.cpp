@@ -0,0 +1,149 @@
+#include "batch.h"
+#include "kernel.h"
+
+#include <algorithm>
+#include <format>
+#include <vector>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+using namespace eval;
+using namespace eval::batch;
+
+namespace impl
+{
+    // rows per block. large enough to amortize dispatching each instruction, small enough for the registers of
+    // a typical program to stay in the l1/l2 cache
+    constexpr std::size_t BLOCK = 512;
+    static_assert(BLOCK % kernel::ALIGNMENT == 0);
+
+    static bool cpu_supports_avx2()
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && defined(_M_X64)
+        // avx2 requires the os to save the ymm registers, see the intel software developer's manual 14.3
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = info[2] & (1 << 27);
+        const bool avx = info[2] & (1 << 28);
+
+        if (!osxsave || !avx || (_xgetbv(0) & 0b110) != 0b110)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return info[1] & (1 << 5);
+#else
+        return false;
+#endif
+    }
+
+    static kernel::Function* kernel_for(Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::SCALAR: return kernel::scalar;
+        case Isa::SSE2:   return kernel::SSE2;
+        case Isa::AVX2:   return cpu_supports_avx2() ? kernel::AVX2 : nullptr;
+        }
+        return nullptr;
+    }
+}
+
+std::string_view batch::to_string(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::SCALAR: return "scalar";
+    case Isa::SSE2:   return "sse2";
+    case Isa::AVX2:   return "avx2";
+    }
+    return "?";
+}
+
+batch::Isa batch::detect()
+{
+    static const Isa isa = []()
+    {
+        for (const Isa candidate : { Isa::AVX2, Isa::SSE2 })
+        {
+            if (supported(candidate))
+                return candidate;
+        }
+        return Isa::SCALAR;
+    }();
+    return isa;
+}
+
+bool batch::supported(Isa isa)
+{
+    return impl::kernel_for(isa) != nullptr;
+}
+
+void batch::run(const Program& program, std::span<const std::span<const double>> columns, std::span<double> out)
+{
+    run(program, columns, out, detect());
+}
+
+void batch::run(const Program& program, std::span<const std::span<const double>> columns, std::span<double> out, Isa isa)
+{
+    using impl::BLOCK;
+
+    kernel::Function* const kernel = impl::kernel_for(isa);
+
+    if (!kernel)
+        throw Error(std::format("instruction set '{}' is not supported", to_string(isa)));
+
+    const std::size_t variable_count = program.variables().size();
+
+    if (columns.size() != variable_count)
+        throw Error(std::format("expected {} columns, got {}", variable_count, columns.size()));
+
+    for (std::size_t i = 0; i < variable_count; i++)
+    {
+        if (columns[i].size() < out.size())
+            throw Error(std::format("column of variable '{}' has fewer rows than the output", program.variables()[i]));
+    }
+
+    // every register is a block of rows. constants are broadcast once, and variables are read directly from
+    // their columns, except in the last block where they are copied over to be padded to whole vectors
+    const std::span<const double> constants = program.constants();
+    const std::size_t register_count = program.register_count();
+    std::vector<double> registers(register_count * BLOCK);
+    std::vector<const double*> operands(register_count);
+
+    for (std::size_t r = 0; r < register_count; r++)
+        operands[r] = registers.data() + r * BLOCK;
+
+    for (std::size_t i = 0; i < constants.size(); i++)
+        std::fill_n(registers.data() + i * BLOCK, BLOCK, constants[i]);
+
+    for (std::size_t row = 0; row < out.size(); row += BLOCK)
+    {
+        const std::size_t n = std::min(BLOCK, out.size() - row);
+        const std::size_t padded = (n + kernel::ALIGNMENT - 1) / kernel::ALIGNMENT * kernel::ALIGNMENT;
+
+        for (std::size_t i = 0; i < variable_count; i++)
+        {
+            const std::size_t r = constants.size() + i;
+
+            if (n == BLOCK)
+            {
+                operands[r] = columns[i].data() + row;
+                continue;
+            }
+            double* const block = registers.data() + r * BLOCK;
+            std::copy_n(columns[i].data() + row, n, block);
+            std::fill(block + n, block + padded, 0.0);
+            operands[r] = block;
+        }
+
+        for (const Instruction& in : program.code())
+            kernel(in.op, registers.data() + in.dst * BLOCK, operands[in.a], operands[in.b], padded);
+
+        std::copy_n(operands[program.result()], n, out.data() + row);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "eval/program.h"
+
+#include <span>
+#include <string_view>
+
+// evaluation of a program over many rows at once. the bindings are given as one contiguous column per variable,
+// and the program is executed one instruction at a time over blocks of rows using vector instructions, rather
+// than once per row
+namespace eval::batch
+{
+    enum struct Isa
+    {
+        SCALAR,
+        SSE2,
+        AVX2,
+    };
+
+    std::string_view to_string(Isa isa);
+
+    // the most capable instruction set supported by both the build and the running cpu. checked once
+    Isa detect();
+
+    // whether kernels for the instruction set are available on this machine
+    bool supported(Isa isa);
+
+    // evaluates the program for each row, writing the result of row `i` to `out[i]`. `columns[j]` holds the
+    // values of the variable `program.variables()[j]` and must have at least `out.size()` rows. the results are
+    // identical to those of `Program::run`
+    void run(const Program& program, std::span<const std::span<const double>> columns, std::span<double> out);
+
+    // same as above, but with an explicitly chosen instruction set. throws if it is not supported
+    void run(const Program& program, std::span<const std::span<const double>> columns, std::span<double> out, Isa isa);
+}
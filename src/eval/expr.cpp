@@ -0,0 +1,22 @@
+#include "expr.h"
+
+namespace impl
+{
+    // expressions checked during compilation, evaluated the way the cli prints them; juxtaposition, precedence
+    // of prefix operators, right-associative powers, left-associative comparisons and variadic routines, with
+    // the variables bound in the order they first appear
+    static_assert(eval::expr<"2*x + sqrt(y)">{}(3, 16) == 10);
+    static_assert(eval::expr<"2x + 3y">{}(1, 2) == 8);
+    static_assert(eval::expr<"2 ** 3 ** 2">{}() == 512);
+    static_assert(eval::expr<"-x ** 2">{}(3) == 9);
+    static_assert(eval::expr<"1 < x < 3">{}(2) == 1 && eval::expr<"1 < x < 3">{}(4) == 1);
+    static_assert(eval::expr<"min(x, y, 1) + max(y, x)">{}(4, -2) == 2);
+    static_assert(eval::expr<"x && !y || y % 2 == 1">{}(0, 3) == 1);
+    static_assert(eval::expr<"b - a">::VARIABLES[0] == "b" && eval::expr<"b - a">{}(5, 2) == 3);
+
+    // literals with more digits than fit in 64 bits, or a fraction beyond the exactly representable powers of
+    // ten, round like the ones parsed at runtime
+    static_assert(eval::expr<"0.1000000000000000000001">{}() == 0.1000000000000000000001);
+    static_assert(eval::expr<"123456789012345678901234">{}() == 123456789012345678901234.0);
+    static_assert(eval::expr<"x * 0.000000000000000000000000000001">{}(3) == 3 * 0.000000000000000000000000000001);
+}
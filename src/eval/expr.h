@@ -0,0 +1,206 @@
+#pragma once
+#include "eval/op.h"
+#include "parser/grammar.h"
+#include "parser/lexer.h"
+#include "utility.h"
+
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// expressions parsed during compilation. the tree is stored flat in a constant, and the evaluator is generated
+// from it by template recursion, so the shape of the tree is inlined into the code and evaluating involves no
+// parsing, no allocation and no dispatch on node kinds
+namespace eval
+{
+    namespace flat
+    {
+        enum struct Kind : std::uint8_t
+        {
+            LITERAL,
+            VARIABLE,
+            CALL,
+        };
+
+        struct Node
+        {
+            Kind kind = Kind::LITERAL;
+            Lowering lowering = {};
+            double value = 0.0;
+            std::uint32_t variable = 0;
+
+            // arguments of a call are `children[first..first + arity)`
+            std::uint32_t first = 0;
+            std::uint32_t arity = 0;
+        };
+
+        // expression tree parsed from a string of `N` chars. each node consumes at least one char of the input,
+        // except the multiplications implied by juxtaposition (`2x`), which are bounded by the other nodes
+        template<std::size_t N>
+        struct Tree
+        {
+            static constexpr std::size_t CAPACITY = 2 * N;
+
+            std::array<Node, CAPACITY> nodes{};
+            std::array<std::uint32_t, CAPACITY> children{};
+            std::array<std::string_view, CAPACITY> variables{};
+            std::uint32_t node_count = 0;
+            std::uint32_t child_count = 0;
+            std::uint32_t variable_count = 0;
+            std::uint32_t root = 0;
+        };
+
+        // builds a tree from the grammar, see `parser::grammar::Parser`
+        template<std::size_t N>
+        struct Builder
+        {
+            using Node = std::uint32_t;
+
+            Tree<N>& tree;
+
+            constexpr Node literal(double value)
+            {
+                return push({ .kind = Kind::LITERAL, .value = value });
+            }
+
+            constexpr Node variable(std::string_view identifier)
+            {
+                std::uint32_t slot = 0;
+
+                while (slot < tree.variable_count && tree.variables[slot] != identifier)
+                    slot++;
+
+                if (slot == tree.variable_count)
+                    tree.variables[tree.variable_count++] = identifier;
+                return push({ .kind = Kind::VARIABLE, .variable = slot });
+            }
+
+            constexpr Node call(const ast::function::Function* fn, std::vector<Node> args)
+            {
+                const std::uint32_t first = tree.child_count;
+
+                for (const Node arg : args)
+                    tree.children[tree.child_count++] = arg;
+                return push
+                ({
+                    .kind = Kind::CALL,
+                    .lowering = lower(fn),
+                    .first = first,
+                    .arity = static_cast<std::uint32_t>(args.size()),
+                });
+            }
+
+        private:
+            constexpr Node push(flat::Node node)
+            {
+                tree.nodes[tree.node_count] = node;
+                return tree.node_count++;
+            }
+        };
+
+        template<FixedString SOURCE>
+        constexpr auto parse()
+        {
+            Tree<sizeof(SOURCE.data)> tree;
+            Builder<sizeof(SOURCE.data)> builder{ tree };
+            parser::Lexer lexer{ SOURCE.view() };
+            tree.root = parser::grammar::Parser{ lexer, builder }.parse_input();
+            return tree;
+        }
+
+        // reduces the arguments of a call the same way `eval::compile` lowers it
+        template<Op OP, Fold FOLD, std::size_t N>
+        constexpr double fold(const std::array<double, N>& args)
+        {
+            if constexpr (FOLD == Fold::UNARY)
+            {
+                return apply<OP>(args[0], args[0]);
+            }
+            else if constexpr (FOLD == Fold::LEFT)
+            {
+                double acc = args[0];
+
+                for (std::size_t i = 1; i < N; i++)
+                    acc = apply<OP>(acc, args[i]);
+                return acc;
+            }
+            else if constexpr (FOLD == Fold::RIGHT)
+            {
+                double acc = args[N - 1];
+
+                for (std::size_t i = N - 1; i-- > 0;)
+                    acc = apply<OP>(args[i], acc);
+                return acc;
+            }
+            else
+            {
+                double acc = apply<OP>(args[0], args[1]);
+
+                for (std::size_t i = 1; i + 1 < N; i++)
+                    acc = apply<Op::AND>(acc, apply<OP>(args[i], args[i + 1]));
+                return acc;
+            }
+        }
+    }
+
+    // an expression parsed at compile time, e.g. `eval::expr<"2x + sqrt(y)">{}(3, 4)`. variables are bound in
+    // the order they first appear in the expression, like `eval::compile`, and the results are identical to
+    // those of `Program::run`, literals included (see `parser/decimal.h`). a syntax error, or a literal out of
+    // the range of a double, fails the compilation at the offending call in `parser/grammar.h`.
+    // evaluation is constexpr, see the checks in `expr.cpp`
+    template<FixedString SOURCE>
+    struct expr
+    {
+        static constexpr auto TREE = flat::parse<SOURCE>();
+        static constexpr std::size_t ARITY = TREE.variable_count;
+
+        // names of the variables in the order their values are expected
+        static constexpr std::array<std::string_view, ARITY> VARIABLES = []()
+        {
+            std::array<std::string_view, ARITY> out;
+
+            for (std::size_t i = 0; i < ARITY; i++)
+                out[i] = TREE.variables[i];
+            return out;
+        }();
+
+        static constexpr double evaluate(std::span<const double, ARITY> values)
+        {
+            return node<TREE.root>(values.data());
+        }
+
+        template<class... Values>
+            requires (sizeof...(Values) == ARITY && (std::convertible_to<Values, double> && ...))
+        constexpr double operator()(Values... values) const
+        {
+            const std::array<double, ARITY> bound{ static_cast<double>(values)... };
+            return evaluate(bound);
+        }
+
+    private:
+        template<std::uint32_t I>
+        static constexpr double node(const double* values)
+        {
+            constexpr flat::Node NODE = TREE.nodes[I];
+
+            if constexpr (NODE.kind == flat::Kind::LITERAL)
+                return NODE.value;
+            else if constexpr (NODE.kind == flat::Kind::VARIABLE)
+                return values[NODE.variable];
+            else
+                return call<I>(values, std::make_index_sequence<NODE.arity>{});
+        }
+
+        template<std::uint32_t I, std::size_t... ARGS>
+        static constexpr double call(const double* values, std::index_sequence<ARGS...>)
+        {
+            constexpr flat::Node NODE = TREE.nodes[I];
+            const std::array<double, sizeof...(ARGS)> args{ node<TREE.children[NODE.first + ARGS]>(values)... };
+            return flat::fold<NODE.lowering.op, NODE.lowering.fold>(args);
+        }
+    };
+}
@@ -0,0 +1,178 @@
+#include "fold.h"
+#include "op.h"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+using namespace ast::prelude;
+using namespace function::prelude;
+
+namespace impl
+{
+    static double value(const Ast& ast)
+    {
+        return ast.get<Literal>().value;
+    }
+
+    // folds a sequence of literals like `Program::run` evaluates a call of them
+    static double evaluate(eval::Lowering lowering, std::span<const Ast> args)
+    {
+        const std::size_t n = args.size();
+
+        switch (lowering.fold)
+        {
+        case eval::Fold::UNARY:
+            return eval::apply(lowering.op, value(args[0]), 0.0);
+        case eval::Fold::LEFT:
+        {
+            double acc = value(args[0]);
+
+            for (std::size_t i = 1; i < n; i++)
+                acc = eval::apply(lowering.op, acc, value(args[i]));
+            return acc;
+        }
+        case eval::Fold::RIGHT:
+        {
+            double acc = value(args[n - 1]);
+
+            for (std::size_t i = n - 1; i-- > 0;)
+                acc = eval::apply(lowering.op, value(args[i]), acc);
+            return acc;
+        }
+        case eval::Fold::CHAIN:
+        {
+            bool out = true;
+
+            for (std::size_t i = 0; i + 1 < n; i++)
+                out = out && eval::apply(lowering.op, value(args[i]), value(args[i + 1])) != 0.0;
+            return out ? 1.0 : 0.0;
+        }
+        }
+        return 0.0;
+    }
+
+    // replaces each run of at least two adjacent literals in `[first, last)` with its value
+    static bool merge_runs(std::vector<Ast>& args, std::size_t first, std::size_t last, eval::Lowering lowering)
+    {
+        bool changed = false;
+        std::size_t out = first;
+
+        for (std::size_t i = first; i < last;)
+        {
+            std::size_t end = i;
+
+            while (end < last && args[end].has<Literal>())
+                end++;
+
+            if (end - i >= 2)
+            {
+                args[out++] = Literal{ evaluate(lowering, std::span(args).subspan(i, end - i)) };
+                changed = true;
+                i = end;
+            }
+            else
+            {
+                if (out != i)
+                    args[out] = std::move(args[i]);
+                out++;
+                i++;
+            }
+        }
+
+        if (changed)
+        {
+            const auto begin = args.begin();
+            args.erase(begin + static_cast<std::ptrdiff_t>(out), begin + static_cast<std::ptrdiff_t>(last));
+        }
+        return changed;
+    }
+}
+
+bool eval::fold(Ast& ast)
+{
+    if (!ast.has<Call>())
+        return false;
+
+    Call& call = ast.get<Call>();
+    std::vector<Ast>& args = call.args;
+    const auto literal = [](const Ast& arg) { return arg.has<Literal>(); };
+    const std::size_t literals = static_cast<std::size_t>(std::ranges::count_if(args, literal));
+
+    if (!literals)
+        return false;
+
+    const Lowering lowering = lower(call.fn);
+
+    if (literals == args.size())
+    {
+        ast = Literal{ impl::evaluate(lowering, args) };
+        return true;
+    }
+    if (args.size() < 3 || literals < 2)
+        return false;
+
+    switch (call.fn->commutativity)
+    {
+    case Commutativity::ALL:
+    {
+        // only the functions folded left are associative as well, the others compare their arguments
+        if (lowering.fold != Fold::LEFT)
+            return false;
+
+        // the literals are gathered at the front, where the canonical order puts them anyway
+        std::stable_partition(args.begin(), args.end(), literal);
+        return impl::merge_runs(args, 0, literals, lowering);
+    }
+    case Commutativity::TAIL:
+    {
+        // `a - b - c` is `a - (b + c)`, and `a / b / c` is `a / (b * c)`
+        const Lowering inverse{ lowering.op == Op::SUB ? Op::ADD : Op::MUL, Fold::LEFT };
+        const bool head = args[0].has<Literal>();
+        const std::size_t tail = literals - head;
+
+        if (lowering.op != Op::SUB && lowering.op != Op::DIV)
+            return false;
+        if (!(head ? tail >= 1 : tail >= 2))
+            return false;
+
+        std::stable_partition(args.begin() + 1, args.end(), literal);
+
+        if (tail >= 2)
+            impl::merge_runs(args, 1, 1 + tail, inverse);
+
+        if (head)
+        {
+            args[0] = Literal{ apply(lowering.op, impl::value(args[0]), impl::value(args[1])) };
+            args.erase(args.begin() + 1);
+        }
+        return true;
+    }
+    case Commutativity::NONE:
+        break;
+    }
+
+    switch (call.fn->associativity)
+    {
+    case Associativity::ALL:
+        return impl::merge_runs(args, 0, args.size(), lowering);
+    case Associativity::LEFT:
+    {
+        std::size_t end = 0;
+
+        while (args[end].has<Literal>())
+            end++;
+        return end >= 2 && impl::merge_runs(args, 0, end, lowering);
+    }
+    case Associativity::RIGHT:
+    {
+        std::size_t begin = args.size();
+
+        while (args[begin - 1].has<Literal>())
+            begin--;
+        return args.size() - begin >= 2 && impl::merge_runs(args, begin, args.size(), lowering);
+    }
+    case Associativity::NONE:
+        break;
+    }
+    return false;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "ast/ast.h"
+
+// constant folding, with the numeric semantics of `eval::apply` and the folds of `eval::Lowering`, such that
+// a folded expression evaluates like the original one, up to rounding where literals are regrouped
+namespace eval
+{
+    // folds a call whose arguments are folded already, and returns whether the expression changed. a call of
+    // literals only is replaced by its value. otherwise, the literal arguments of a flattened call are merged
+    // where the function allows it:
+    //
+    //   commutative      all of them, e.g. `+(1, x, 2, y, 3)` into `+(6, x, y)`
+    //   tail-commutative those in the tail, merged with the inverse function, and into the head if it is a
+    //                    literal as well, e.g. `-(x, 1, 2)` into `-(x, 3)` and `/(12, x, 2)` into `/(6, x)`
+    //   associative      each run of adjacent ones, e.g. `max(x, 1, 2)` into `max(x, 2)`
+    //   left-folded      a run at the start, e.g. `%(7, 4, x)` into `%(3, x)`
+    //   right-folded     a run at the end, e.g. `**(x, 3, 2)` into `**(x, 9)`
+    bool fold(ast::Ast& ast);
+}
@@ -0,0 +1,109 @@
+#include "kernel.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+using namespace eval;
+
+namespace
+{
+    // lanes of a single double. masks are represented by the bit pattern of all ones
+    struct Scalar
+    {
+        using V = double;
+        static constexpr std::size_t WIDTH = 1;
+
+        static V load(const double* p)  { return *p; }
+        static void store(double* p, V v) { *p = v; }
+        static V set(double x)          { return x; }
+
+        static V add(V a, V b)  { return a + b; }
+        static V sub(V a, V b)  { return a - b; }
+        static V mul(V a, V b)  { return a * b; }
+        static V div(V a, V b)  { return a / b; }
+        static V sqrt(V a)      { return std::sqrt(a); }
+        static V min(V a, V b)  { return a < b ? a : b; }
+        static V max(V a, V b)  { return a > b ? a : b; }
+
+        static V bit_and(V a, V b)    { return bits(bits(a) & bits(b)); }
+        static V bit_or(V a, V b)     { return bits(bits(a) | bits(b)); }
+        static V bit_xor(V a, V b)    { return bits(bits(a) ^ bits(b)); }
+        static V bit_andnot(V a, V b) { return bits(~bits(a) & bits(b)); }
+
+        static V eq(V a, V b) { return mask(a == b); }
+        static V ne(V a, V b) { return mask(a != b); }
+        static V lt(V a, V b) { return mask(a < b); }
+        static V le(V a, V b) { return mask(a <= b); }
+
+    private:
+        static std::uint64_t bits(double x)
+        {
+            return std::bit_cast<std::uint64_t>(x);
+        }
+
+        static double bits(std::uint64_t x)
+        {
+            return std::bit_cast<double>(x);
+        }
+
+        static V mask(bool x)
+        {
+            return bits(x ? ~std::uint64_t(0) : std::uint64_t(0));
+        }
+    };
+
+#if defined(__SSE2__) || defined(_M_X64)
+    struct Sse2
+    {
+        using V = __m128d;
+        static constexpr std::size_t WIDTH = 2;
+
+        static V load(const double* p)  { return _mm_loadu_pd(p); }
+        static void store(double* p, V v) { _mm_storeu_pd(p, v); }
+        static V set(double x)          { return _mm_set1_pd(x); }
+
+        static V add(V a, V b)  { return _mm_add_pd(a, b); }
+        static V sub(V a, V b)  { return _mm_sub_pd(a, b); }
+        static V mul(V a, V b)  { return _mm_mul_pd(a, b); }
+        static V div(V a, V b)  { return _mm_div_pd(a, b); }
+        static V sqrt(V a)      { return _mm_sqrt_pd(a); }
+        static V min(V a, V b)  { return _mm_min_pd(a, b); }
+        static V max(V a, V b)  { return _mm_max_pd(a, b); }
+
+        static V bit_and(V a, V b)    { return _mm_and_pd(a, b); }
+        static V bit_or(V a, V b)     { return _mm_or_pd(a, b); }
+        static V bit_xor(V a, V b)    { return _mm_xor_pd(a, b); }
+        static V bit_andnot(V a, V b) { return _mm_andnot_pd(a, b); }
+
+        static V eq(V a, V b) { return _mm_cmpeq_pd(a, b); }
+        static V ne(V a, V b) { return _mm_cmpneq_pd(a, b); }
+        static V lt(V a, V b) { return _mm_cmplt_pd(a, b); }
+        static V le(V a, V b) { return _mm_cmple_pd(a, b); }
+    };
+#endif
+}
+
+void kernel::scalar(Op op, double* dst, const double* a, const double* b, std::size_t n)
+{
+    generic<Scalar>(op, dst, a, b, n);
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+kernel::Function* const kernel::SSE2 = generic<Sse2>;
+#else
+kernel::Function* const kernel::SSE2 = nullptr;
+#endif
+
+double kernel::pow(double a, double b)
+{
+    return std::pow(a, b);
+}
+
+double kernel::mod(double a, double b)
+{
+    return std::fmod(a, b);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "eval/program.h"
+
+#include <cstddef>
+
+// element-wise kernels executing a single instruction of a program over a block of rows. each instruction set
+// has its own translation unit so that it can be compiled with the flags it needs, while the running cpu is
+// only checked once at runtime. that translation unit must not instantiate any inline function shared with
+// other translation units, since the linker may otherwise pick the copy using instructions not available
+namespace eval::kernel
+{
+    // number of doubles `n` passed to a kernel is always a multiple of this
+    constexpr std::size_t ALIGNMENT = 8;
+
+    using Function = void(Op op, double* dst, const double* a, const double* b, std::size_t n);
+
+    // fallback using the compiler's code generation for the target
+    void scalar(Op op, double* dst, const double* a, const double* b, std::size_t n);
+
+    // the kernels below are null if the build does not target the instruction set
+    extern Function* const SSE2;
+    extern Function* const AVX2;
+
+    // operations without a vector instruction, evaluated one lane at a time by every kernel
+    double pow(double a, double b);
+    double mod(double a, double b);
+
+    // generic kernel parameterized over the vector operations of an instruction set. `Simd` provides a vector
+    // type `V` of `WIDTH` lanes along with loads, stores, arithmetic and comparisons producing lane masks.
+    // booleans are produced by masking the bit pattern of `1.0`, so every lane is exactly `1` or `0`
+    template<class Simd>
+    void generic(Op op, double* dst, const double* a, const double* b, std::size_t n)
+    {
+        using V = typename Simd::V;
+        constexpr std::size_t W = Simd::WIDTH;
+        static_assert(ALIGNMENT % W == 0);
+
+        const V zero = Simd::set(0.0);
+        const V one = Simd::set(1.0);
+        const V sign = Simd::set(-0.0);
+        const V epsilon = Simd::set(1e-10);
+
+        // applies `f` to `W` lanes at a time
+        const auto each = [&](auto f)
+        {
+            for (std::size_t i = 0; i < n; i += W)
+                Simd::store(dst + i, f(Simd::load(a + i), Simd::load(b + i)));
+        };
+        const auto boolean = [&](V mask) { return Simd::bit_and(mask, one); };
+        const auto truth = [&](V x) { return Simd::ne(x, zero); };
+        const auto abs = [&](V x) { return Simd::bit_andnot(sign, x); };
+
+        // see `double_equality`
+        const auto equal = [&](V x, V y)
+        {
+            const V difference = abs(Simd::sub(x, y));
+            const V magnitude = Simd::max(abs(x), abs(y));
+            return Simd::le(difference, Simd::mul(epsilon, magnitude));
+        };
+
+        switch (op)
+        {
+        case Op::NEG:  each([&](V x, V)   { return Simd::bit_xor(sign, x);                          }); break;
+        case Op::NOT:  each([&](V x, V)   { return boolean(Simd::eq(x, zero));                      }); break;
+        case Op::SQRT: each([&](V x, V)   { return Simd::sqrt(x);                                   }); break;
+        case Op::ABS:  each([&](V x, V)   { return abs(x);                                          }); break;
+        case Op::ADD:  each([&](V x, V y) { return Simd::add(x, y);                                 }); break;
+        case Op::SUB:  each([&](V x, V y) { return Simd::sub(x, y);                                 }); break;
+        case Op::MUL:  each([&](V x, V y) { return Simd::mul(x, y);                                 }); break;
+        case Op::DIV:  each([&](V x, V y) { return Simd::div(x, y);                                 }); break;
+        case Op::EQ:   each([&](V x, V y) { return boolean(equal(x, y));                            }); break;
+        case Op::NE:   each([&](V x, V y) { return Simd::bit_andnot(equal(x, y), one);             }); break;
+        case Op::LT:   each([&](V x, V y) { return boolean(Simd::lt(x, y));                         }); break;
+        case Op::LE:   each([&](V x, V y) { return boolean(Simd::le(x, y));                         }); break;
+        case Op::GT:   each([&](V x, V y) { return boolean(Simd::lt(y, x));                         }); break;
+        case Op::GE:   each([&](V x, V y) { return boolean(Simd::le(y, x));                         }); break;
+        case Op::AND:  each([&](V x, V y) { return boolean(Simd::bit_and(truth(x), truth(y)));      }); break;
+        case Op::OR:   each([&](V x, V y) { return boolean(Simd::bit_or(truth(x), truth(y)));       }); break;
+        case Op::XOR:  each([&](V x, V y) { return boolean(Simd::bit_xor(truth(x), truth(y)));      }); break;
+        // the operands are swapped to match `std::min` and `std::max` when either is nan
+        case Op::MIN:  each([&](V x, V y) { return Simd::min(y, x);                                 }); break;
+        case Op::MAX:  each([&](V x, V y) { return Simd::max(y, x);                                 }); break;
+        case Op::MOD:
+            for (std::size_t i = 0; i < n; i++)
+                dst[i] = mod(a[i], b[i]);
+            break;
+        case Op::POW:
+            for (std::size_t i = 0; i < n; i++)
+                dst[i] = pow(a[i], b[i]);
+            break;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#include "kernel.h"
+
+// compiled with avx2 enabled when targeting x86, see `CMakeLists.txt`. only reached once the running cpu has
+// been checked to support it
+#if defined(__AVX2__)
+#include <immintrin.h>
+using namespace eval;
+
+namespace
+{
+    struct Avx2
+    {
+        using V = __m256d;
+        static constexpr std::size_t WIDTH = 4;
+
+        static V load(const double* p)  { return _mm256_loadu_pd(p); }
+        static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+        static V set(double x)          { return _mm256_set1_pd(x); }
+
+        static V add(V a, V b)  { return _mm256_add_pd(a, b); }
+        static V sub(V a, V b)  { return _mm256_sub_pd(a, b); }
+        static V mul(V a, V b)  { return _mm256_mul_pd(a, b); }
+        static V div(V a, V b)  { return _mm256_div_pd(a, b); }
+        static V sqrt(V a)      { return _mm256_sqrt_pd(a); }
+        static V min(V a, V b)  { return _mm256_min_pd(a, b); }
+        static V max(V a, V b)  { return _mm256_max_pd(a, b); }
+
+        static V bit_and(V a, V b)    { return _mm256_and_pd(a, b); }
+        static V bit_or(V a, V b)     { return _mm256_or_pd(a, b); }
+        static V bit_xor(V a, V b)    { return _mm256_xor_pd(a, b); }
+        static V bit_andnot(V a, V b) { return _mm256_andnot_pd(a, b); }
+
+        // ordered comparisons except for `ne`, matching the scalar operators on nan
+        static V eq(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+        static V ne(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+        static V lt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+        static V le(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    };
+}
+
+eval::kernel::Function* const eval::kernel::AVX2 = generic<Avx2>;
+#else
+eval::kernel::Function* const eval::kernel::AVX2 = nullptr;
+#endif
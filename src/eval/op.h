@@ -0,0 +1,165 @@
+#pragma once
+#include "ast/function.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+// numeric semantics of the functions in `ast::function::ARRAY`, shared by every evaluator
+namespace eval
+{
+    struct Error : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    enum struct Op : std::uint8_t
+    {
+        // unary: `dst = op(a)`
+        NEG,
+        NOT,
+        SQRT,
+        ABS,
+
+        // binary: `dst = op(a, b)`
+        ADD,
+        SUB,
+        MUL,
+        DIV,
+        MOD,
+        POW,
+        EQ,
+        NE,
+        LT,
+        LE,
+        GT,
+        GE,
+        AND,
+        OR,
+        XOR,
+        MIN,
+        MAX,
+    };
+
+    // determines how a call with any number of arguments is reduced to operations on one or two values
+    enum struct Fold : std::uint8_t
+    {
+        // `op(a)`
+        UNARY,
+        // `op(op(a, b), c)`
+        LEFT,
+        // `op(a, op(b, c))`
+        RIGHT,
+        // `op(a, b) && op(b, c)`
+        CHAIN,
+    };
+
+    struct Lowering
+    {
+        Op op;
+        Fold fold;
+    };
+
+    // lowering of every function, keyed by function object
+    inline constexpr std::pair<const ast::function::Function*, Lowering> LOWERINGS[] =
+    {
+        { ast::function::get("-",    1), { Op::NEG,  Fold::UNARY } },
+        { ast::function::get("**",   2), { Op::POW,  Fold::RIGHT } },
+        { ast::function::get("*",    2), { Op::MUL,  Fold::LEFT  } },
+        { ast::function::get("/",    2), { Op::DIV,  Fold::LEFT  } },
+        { ast::function::get("%",    2), { Op::MOD,  Fold::LEFT  } },
+        { ast::function::get("+",    2), { Op::ADD,  Fold::LEFT  } },
+        { ast::function::get("-",    2), { Op::SUB,  Fold::LEFT  } },
+        { ast::function::get("==",   2), { Op::EQ,   Fold::CHAIN } },
+        { ast::function::get("!=",   2), { Op::NE,   Fold::CHAIN } },
+        { ast::function::get("<",    2), { Op::LT,   Fold::CHAIN } },
+        { ast::function::get("<=",   2), { Op::LE,   Fold::CHAIN } },
+        { ast::function::get(">",    2), { Op::GT,   Fold::CHAIN } },
+        { ast::function::get(">=",   2), { Op::GE,   Fold::CHAIN } },
+        { ast::function::get("!",    1), { Op::NOT,  Fold::UNARY } },
+        { ast::function::get("&&",   2), { Op::AND,  Fold::LEFT  } },
+        { ast::function::get("^^",   2), { Op::XOR,  Fold::LEFT  } },
+        { ast::function::get("||",   2), { Op::OR,   Fold::LEFT  } },
+        { ast::function::get("sqrt", 1), { Op::SQRT, Fold::UNARY } },
+        { ast::function::get("abs",  1), { Op::ABS,  Fold::UNARY } },
+        { ast::function::get("min",  2), { Op::MIN,  Fold::LEFT  } },
+        { ast::function::get("max",  2), { Op::MAX,  Fold::LEFT  } },
+    };
+    static_assert(std::size(LOWERINGS) == ast::function::ARRAY.size(), "every function must be lowered");
+
+    // the operation a call of the function is evaluated with, and how its arguments are folded
+    constexpr Lowering lower(const ast::function::Function* fn)
+    {
+        for (const auto& [candidate, lowering] : LOWERINGS)
+        {
+            if (candidate == fn)
+                return lowering;
+        }
+        throw Error("function cannot be evaluated numerically");
+    }
+
+    // applies an operation. unary operations ignore `b`. booleans are represented as `1` and `0`, and any
+    // non-zero value is considered true
+    template<Op OP>
+    constexpr double apply(double a, double b)
+    {
+        const auto truth = [](double value) { return value != 0.0; };
+        const auto boolean = [](bool value) { return value ? 1.0 : 0.0; };
+
+        if constexpr (OP == Op::NEG)  return -a;
+        if constexpr (OP == Op::NOT)  return boolean(!truth(a));
+        if constexpr (OP == Op::SQRT) return std::sqrt(a);
+        if constexpr (OP == Op::ABS)  return std::abs(a);
+        if constexpr (OP == Op::ADD)  return a + b;
+        if constexpr (OP == Op::SUB)  return a - b;
+        if constexpr (OP == Op::MUL)  return a * b;
+        if constexpr (OP == Op::DIV)  return a / b;
+        if constexpr (OP == Op::MOD)  return std::fmod(a, b);
+        if constexpr (OP == Op::POW)  return std::pow(a, b);
+        if constexpr (OP == Op::EQ)   return boolean(double_equality(a, b));
+        if constexpr (OP == Op::NE)   return boolean(!double_equality(a, b));
+        if constexpr (OP == Op::LT)   return boolean(a < b);
+        if constexpr (OP == Op::LE)   return boolean(a <= b);
+        if constexpr (OP == Op::GT)   return boolean(a > b);
+        if constexpr (OP == Op::GE)   return boolean(a >= b);
+        if constexpr (OP == Op::AND)  return boolean(truth(a) && truth(b));
+        if constexpr (OP == Op::OR)   return boolean(truth(a) || truth(b));
+        if constexpr (OP == Op::XOR)  return boolean(truth(a) != truth(b));
+        if constexpr (OP == Op::MIN)  return std::min(a, b);
+        if constexpr (OP == Op::MAX)  return std::max(a, b);
+    }
+
+    // same as above, with the operation only known at runtime
+    inline double apply(Op op, double a, double b)
+    {
+        switch (op)
+        {
+        case Op::NEG:  return apply<Op::NEG>(a, b);
+        case Op::NOT:  return apply<Op::NOT>(a, b);
+        case Op::SQRT: return apply<Op::SQRT>(a, b);
+        case Op::ABS:  return apply<Op::ABS>(a, b);
+        case Op::ADD:  return apply<Op::ADD>(a, b);
+        case Op::SUB:  return apply<Op::SUB>(a, b);
+        case Op::MUL:  return apply<Op::MUL>(a, b);
+        case Op::DIV:  return apply<Op::DIV>(a, b);
+        case Op::MOD:  return apply<Op::MOD>(a, b);
+        case Op::POW:  return apply<Op::POW>(a, b);
+        case Op::EQ:   return apply<Op::EQ>(a, b);
+        case Op::NE:   return apply<Op::NE>(a, b);
+        case Op::LT:   return apply<Op::LT>(a, b);
+        case Op::LE:   return apply<Op::LE>(a, b);
+        case Op::GT:   return apply<Op::GT>(a, b);
+        case Op::GE:   return apply<Op::GE>(a, b);
+        case Op::AND:  return apply<Op::AND>(a, b);
+        case Op::OR:   return apply<Op::OR>(a, b);
+        case Op::XOR:  return apply<Op::XOR>(a, b);
+        case Op::MIN:  return apply<Op::MIN>(a, b);
+        case Op::MAX:  return apply<Op::MAX>(a, b);
+        }
+        return a;
+    }
+}
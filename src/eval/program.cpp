@@ -0,0 +1,300 @@
+#include "program.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <unordered_map>
+using namespace eval;
+using namespace ast::prelude;
+using namespace function::prelude;
+
+namespace impl
+{
+    // registers are referred to symbolically during compilation, since the number of constants and variables
+    // is only known once the whole expression has been visited. the two top bits determine the kind
+    enum struct Bank : std::uint32_t
+    {
+        CONSTANT  = 0u << 30,
+        VARIABLE  = 1u << 30,
+        TEMPORARY = 2u << 30,
+    };
+
+    constexpr std::uint32_t BANK_MASK = 3u << 30;
+
+    constexpr std::uint32_t reg(Bank bank, std::uint32_t index)
+    {
+        return static_cast<std::uint32_t>(bank) | index;
+    }
+
+    struct Compiler
+    {
+        std::vector<Instruction>& code;
+        std::vector<double>& constants;
+        std::vector<std::string>& variables;
+        const bool fixed_variables;
+
+        std::unordered_map<std::uint64_t, std::uint32_t> constant_slots = {};
+        std::unordered_map<std::string, std::uint32_t> variable_slots = {};
+        std::uint32_t next_temporary = 0;
+        std::uint32_t temporary_count = 0;
+
+        std::uint32_t temporary()
+        {
+            const std::uint32_t index = next_temporary++;
+            temporary_count = std::max(temporary_count, next_temporary);
+            return reg(Bank::TEMPORARY, index);
+        }
+
+        void emit(Op op, std::uint32_t dst, std::uint32_t a, std::uint32_t b)
+        {
+            code.push_back({ op, dst, a, b });
+        }
+
+        std::uint32_t constant(double value)
+        {
+            const auto [it, inserted] = constant_slots.try_emplace(std::bit_cast<std::uint64_t>(value), 0);
+
+            if (inserted)
+            {
+                it->second = static_cast<std::uint32_t>(constants.size());
+                constants.push_back(value);
+            }
+            return reg(Bank::CONSTANT, it->second);
+        }
+
+        std::uint32_t variable(const std::string& identifier)
+        {
+            auto it = variable_slots.find(identifier);
+
+            if (it == variable_slots.end())
+            {
+                if (fixed_variables)
+                    throw Error(std::format("unknown variable '{}'", identifier));
+
+                variables.push_back(identifier);
+                it = variable_slots.emplace(identifier, static_cast<std::uint32_t>(variables.size() - 1)).first;
+            }
+            return reg(Bank::VARIABLE, it->second);
+        }
+
+        // compiles an expression and returns the register holding its result. temporaries allocated by the
+        // arguments of a call are released once the call has consumed them. the calls being compiled are kept
+        // on an explicit stack along with the first temporary they may use, such that arbitrarily deep
+        // expressions cannot exhaust the native stack
+        std::uint32_t compile(const Ast& ast)
+        {
+            struct Frame
+            {
+                const Call* call;
+                std::uint32_t mark;
+                std::size_t next = 0;
+            };
+
+            std::vector<Frame> stack;
+            std::vector<std::uint32_t> results;
+
+            const auto visit = [&](const Ast& expr)
+            {
+                expr.visit
+                (
+                    [&](const Literal& e)  { results.push_back(constant(e.value));       },
+                    [&](const Variable& e) { results.push_back(variable(e.identifier));  },
+                    [&](const Call& e)     { stack.push_back({ &e, next_temporary });    }
+                );
+            };
+            visit(ast);
+
+            while (!stack.empty())
+            {
+                Frame& frame = stack.back();
+
+                if (frame.next < frame.call->args.size())
+                {
+                    visit(frame.call->args[frame.next++]);
+                    continue;
+                }
+
+                const std::size_t arity = frame.call->args.size();
+                const std::uint32_t dst = compile_call(*frame.call, frame.mark, std::span(results).last(arity));
+                results.resize(results.size() - arity);
+                results.push_back(dst);
+                stack.pop_back();
+            }
+            return results.back();
+        }
+
+        // emits a call whose arguments have been compiled into `args`, given the first temporary that was free
+        // before they were
+        std::uint32_t compile_call(const Call& call, std::uint32_t mark, std::span<const std::uint32_t> args)
+        {
+            const Lowering lowering = lower(call.fn);
+
+            // the temporaries of the arguments are released before the result is allocated, so the result of
+            // every call lands in the lowest temporary free before it, and a chain of nested calls needs as many
+            // temporaries as the widest call rather than the deepest. the result may therefore share a register
+            // with any argument, so it is only written once every argument it may hold has been read; scratch
+            // temporaries are allocated above the arguments
+            const std::uint32_t dst = reg(Bank::TEMPORARY, mark);
+            const std::size_t n = args.size();
+
+            switch (lowering.fold)
+            {
+            case Fold::UNARY:
+                emit(lowering.op, dst, args[0], args[0]);
+                break;
+            case Fold::LEFT:
+            {
+                // the first step reads the first two arguments, and every later step one more
+                const bool held = std::find(args.begin() + 2, args.end(), dst) != args.end();
+                const std::uint32_t acc = held ? temporary() : dst;
+                emit(lowering.op, n == 2 ? dst : acc, args[0], args[1]);
+
+                for (std::size_t i = 2; i < n; i++)
+                    emit(lowering.op, i + 1 == n ? dst : acc, acc, args[i]);
+                break;
+            }
+            case Fold::RIGHT:
+            {
+                std::uint32_t acc = args[n - 1];
+
+                if (n > 2)
+                {
+                    const std::uint32_t scratch = temporary();
+
+                    for (std::size_t i = n - 1; i-- > 1;)
+                    {
+                        emit(lowering.op, scratch, args[i], acc);
+                        acc = scratch;
+                    }
+                }
+                emit(lowering.op, dst, args[0], acc);
+                break;
+            }
+            case Fold::CHAIN:
+            {
+                if (n == 2)
+                {
+                    emit(lowering.op, dst, args[0], args[1]);
+                    break;
+                }
+
+                const std::uint32_t acc = temporary();
+                const std::uint32_t pair = temporary();
+                emit(lowering.op, acc, args[0], args[1]);
+
+                for (std::size_t i = 1; i + 1 < n; i++)
+                {
+                    emit(lowering.op, pair, args[i], args[i + 1]);
+                    emit(Op::AND, i + 2 == n ? dst : acc, acc, pair);
+                }
+                break;
+            }
+            }
+
+            next_temporary = mark + 1;
+            temporary_count = std::max(temporary_count, next_temporary);
+            return dst;
+        }
+    };
+}
+
+Program eval::compile(const ast::Ast& ast, std::span<const std::string_view> variables)
+{
+    Program program;
+    impl::Compiler compiler{ program._code, program._constants, program._variables, !variables.empty() };
+
+    for (const std::string_view variable : variables)
+    {
+        program._variables.emplace_back(variable);
+        compiler.variable_slots.emplace(variable, static_cast<std::uint32_t>(program._variables.size() - 1));
+    }
+
+    const std::uint32_t result = compiler.compile(ast);
+
+    // relocate the symbolic registers into the final layout
+    const auto constant_count = static_cast<std::uint32_t>(program._constants.size());
+    const auto variable_count = static_cast<std::uint32_t>(program._variables.size());
+
+    const auto relocate = [&](std::uint32_t r) -> std::uint32_t
+    {
+        const std::uint32_t index = r & ~impl::BANK_MASK;
+
+        switch (static_cast<impl::Bank>(r & impl::BANK_MASK))
+        {
+        case impl::Bank::CONSTANT:  return index;
+        case impl::Bank::VARIABLE:  return constant_count + index;
+        case impl::Bank::TEMPORARY: return constant_count + variable_count + index;
+        }
+        return index;
+    };
+
+    for (Instruction& in : program._code)
+    {
+        in.dst = relocate(in.dst);
+        in.a = relocate(in.a);
+        in.b = relocate(in.b);
+    }
+    program._result = relocate(result);
+    program._register_count = constant_count + variable_count + compiler.temporary_count;
+    program._registers.resize(program._register_count);
+    program.load_constants(program._registers);
+    return program;
+}
+
+const std::vector<std::string>& Program::variables() const
+{
+    return _variables;
+}
+
+std::optional<std::size_t> Program::slot(std::string_view variable) const
+{
+    const auto it = std::ranges::find(_variables, variable);
+
+    if (it == _variables.end())
+        return std::nullopt;
+    return static_cast<std::size_t>(it - _variables.begin());
+}
+
+std::span<const double> Program::constants() const
+{
+    return _constants;
+}
+
+std::span<const Instruction> Program::code() const
+{
+    return _code;
+}
+
+std::size_t Program::result() const
+{
+    return _result;
+}
+
+std::size_t Program::register_count() const
+{
+    return _register_count;
+}
+
+void Program::load_constants(std::span<double> registers) const
+{
+    std::ranges::copy(_constants, registers.begin());
+}
+
+double Program::run(std::span<const double> values) const
+{
+    return run(values, _registers);
+}
+
+double Program::run(std::span<const double> values, std::span<double> registers) const
+{
+    assert(values.size() >= _variables.size());
+    assert(registers.size() >= _register_count);
+
+    double* r = registers.data();
+    std::copy_n(values.data(), _variables.size(), r + _constants.size());
+
+    for (const Instruction& in : _code)
+        r[in.dst] = apply(in.op, r[in.a], r[in.b]);
+    return r[_result];
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "ast/ast.h"
+#include "eval/op.h"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace eval
+{
+    struct Instruction
+    {
+        Op op;
+        std::uint32_t dst;
+        std::uint32_t a;
+        std::uint32_t b;
+    };
+
+    // an expression compiled into a flat register-based program over doubles. the register file is laid out
+    // as `[constants | variables | temporaries]`; constants are loaded once at compile time and variables are
+    // loaded from the bindings on every run. booleans are represented as `1` and `0`, and any non-zero value
+    // is considered true
+    struct Program
+    {
+        // names of the variables in the order their values are expected by `run`
+        const std::vector<std::string>& variables() const;
+
+        // index of a variable in the bindings passed to `run`, if the expression refers to it
+        std::optional<std::size_t> slot(std::string_view variable) const;
+
+        // values of the constant registers, which precede the variable registers
+        std::span<const double> constants() const;
+
+        std::span<const Instruction> code() const;
+
+        // register holding the result once the program has run
+        std::size_t result() const;
+
+        // number of registers needed to run the program
+        std::size_t register_count() const;
+
+        // evaluates the program with the value of each variable given in the order of `variables()`. uses a
+        // register file owned by the program, so it performs no allocations but may not be called concurrently
+        double run(std::span<const double> values) const;
+
+        // same as above, but uses a register file supplied by the caller of at least `register_count()` size.
+        // the first `constants` registers must hold the constants of the program, see `load_constants`
+        double run(std::span<const double> values, std::span<double> registers) const;
+
+        // initializes a caller-supplied register file for use with `run`
+        void load_constants(std::span<double> registers) const;
+
+    private:
+        friend Program compile(const ast::Ast&, std::span<const std::string_view>);
+
+        std::vector<Instruction> _code;
+        std::vector<double> _constants;
+        std::vector<std::string> _variables;
+        std::uint32_t _register_count = 0;
+        std::uint32_t _result = 0;
+        mutable std::vector<double> _registers;
+    };
+
+    // compiles an expression. if `variables` is empty, the variables are assigned slots in the order they first
+    // appear in the expression. otherwise, they are assigned slots in the given order, and the expression may
+    // not refer to any other variable
+    Program compile(const ast::Ast& ast, std::span<const std::string_view> variables = {});
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdexcept>
+
+namespace io
+{
+    struct Error : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+}
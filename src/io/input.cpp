@@ -0,0 +1,266 @@
+#include "input.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <utility>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace io;
+
+namespace impl
+{
+    [[noreturn]]
+    static void fail(std::string_view path, std::string_view what)
+    {
+        throw Error(std::format("{}: {} ({})", path, what, std::strerror(errno)));
+    }
+
+    // reads up to `size` bytes, returns 0 at the end of the input
+    static std::size_t read_some(int fd, char* out, std::size_t size)
+    {
+        while (true)
+        {
+#if defined(_WIN32)
+            const int n = _read(fd, out, static_cast<unsigned>(std::min<std::size_t>(size, 1u << 30)));
+#else
+            const ssize_t n = ::read(fd, out, size);
+
+            if (n < 0 && errno == EINTR)
+                continue;
+#endif
+            if (n < 0)
+                fail("input", "cannot read");
+            return static_cast<std::size_t>(n);
+        }
+    }
+}
+
+#if defined(_WIN32)
+Input Input::open(const std::string& path)
+{
+    Input input;
+
+    if (path == "-")
+    {
+        input._fd = _fileno(stdin);
+        _setmode(input._fd, _O_BINARY);
+        return input;
+    }
+
+    const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+        throw Error(std::format("{}: cannot open", path));
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        throw Error(std::format("{}: cannot stat", path));
+    }
+
+    if (size.QuadPart > 0)
+    {
+        const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        input._mapping = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        input._size = static_cast<std::size_t>(size.QuadPart);
+
+        // the view keeps the mapping alive
+        if (mapping)
+            CloseHandle(mapping);
+    }
+    CloseHandle(file);
+
+    if (size.QuadPart > 0 && !input._mapping)
+        throw Error(std::format("{}: cannot map", path));
+    return input;
+}
+
+void Input::release()
+{
+    if (_mapping)
+        UnmapViewOfFile(_mapping);
+    if (_owned)
+        _close(_fd);
+    _mapping = nullptr;
+    _owned = false;
+}
+#else
+Input Input::open(const std::string& path)
+{
+    Input input;
+    const bool is_stdin = path == "-";
+    const int fd = is_stdin ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        impl::fail(path, "cannot open");
+
+    struct stat info;
+
+    if (::fstat(fd, &info) != 0)
+        impl::fail(path, "cannot stat");
+
+    // pipes and terminals cannot be mapped, and neither can an empty file
+    if (S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void* mapping = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapping == MAP_FAILED)
+            impl::fail(path, "cannot map");
+
+        ::madvise(mapping, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+        input._mapping = mapping;
+        input._size = static_cast<std::size_t>(info.st_size);
+
+        if (!is_stdin)
+            ::close(fd);
+    }
+    else
+    {
+        input._fd = fd;
+        input._owned = !is_stdin;
+    }
+    return input;
+}
+
+void Input::release()
+{
+    if (_mapping)
+        ::munmap(_mapping, _size);
+    if (_owned)
+        ::close(_fd);
+    _mapping = nullptr;
+    _owned = false;
+}
+#endif
+
+Input::Input(Input&& other) noexcept
+    : _mapping(std::exchange(other._mapping, nullptr))
+    , _size(other._size)
+    , _offset(other._offset)
+    , _fd(std::exchange(other._fd, -1))
+    , _owned(std::exchange(other._owned, false))
+    , _carry(std::move(other._carry)) {}
+
+Input& Input::operator=(Input&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        _mapping = std::exchange(other._mapping, nullptr);
+        _size = other._size;
+        _offset = other._offset;
+        _fd = std::exchange(other._fd, -1);
+        _owned = std::exchange(other._owned, false);
+        _carry = std::move(other._carry);
+    }
+    return *this;
+}
+
+Input::~Input()
+{
+    release();
+}
+
+bool Input::mapped() const
+{
+    return _mapping != nullptr;
+}
+
+std::optional<std::string_view> Input::read(std::string& storage, std::size_t size)
+{
+    if (_mapping)
+    {
+        const std::string_view rest = std::string_view(static_cast<const char*>(_mapping), _size).substr(_offset);
+
+        if (rest.empty())
+            return std::nullopt;
+
+        // extend the chunk to the end of the line it ends in
+        const std::size_t newline = size < rest.size() ? rest.find('\n', size - 1) : std::string_view::npos;
+        const std::size_t end = newline == std::string_view::npos ? rest.size() : newline + 1;
+        _offset += end;
+        return rest.substr(0, end);
+    }
+
+    if (_fd < 0)
+        return std::nullopt;
+
+    // start with the partial line left over from the previous chunk, which contains no newline, and read
+    // until the chunk contains one or the input ends. reads return what is available rather than waiting for
+    // `size` bytes, so that a slow stream is processed as it arrives
+    storage.swap(_carry);
+    _carry.clear();
+    std::size_t newline = std::string::npos;
+
+    while (newline == std::string::npos)
+    {
+        const std::size_t filled = storage.size();
+        storage.resize(filled + std::max<std::size_t>(size, 4096));
+        const std::size_t n = impl::read_some(_fd, storage.data() + filled, storage.size() - filled);
+        storage.resize(filled + n);
+
+        if (n == 0)
+        {
+            release();
+            _fd = -1;
+            newline = storage.size() - 1;
+            break;
+        }
+
+        const std::size_t found = std::string_view(storage).substr(filled).rfind('\n');
+
+        if (found != std::string_view::npos)
+            newline = filled + found;
+    }
+
+    if (storage.empty())
+        return std::nullopt;
+
+    _carry.assign(storage, newline + 1);
+    storage.resize(newline + 1);
+    return std::string_view(storage);
+}
+
+std::string_view Input::read_all(std::string& storage)
+{
+    if (_mapping)
+    {
+        const std::string_view rest = std::string_view(static_cast<const char*>(_mapping), _size).substr(_offset);
+        _offset = _size;
+        return rest;
+    }
+
+    storage.swap(_carry);
+    _carry.clear();
+
+    while (_fd >= 0)
+    {
+        const std::size_t filled = storage.size();
+        storage.resize(std::max<std::size_t>(2 * filled, filled + (1 << 16)));
+        const std::size_t n = impl::read_some(_fd, storage.data() + filled, storage.size() - filled);
+        storage.resize(filled + n);
+
+        if (n == 0)
+        {
+            release();
+            _fd = -1;
+        }
+    }
+    return storage;
+}
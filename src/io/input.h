@@ -0,0 +1,50 @@
+#pragma once
+#include "io/error.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace io
+{
+    // newline-delimited input read in chunks of whole lines. regular files are memory-mapped so that chunks
+    // are viewed in place; anything else (e.g. a pipe on stdin) is streamed, so an endless input is processed
+    // in bounded memory
+    struct Input
+    {
+        // opens a file, or stdin if the path is "-"
+        static Input open(const std::string& path);
+
+        Input(Input&&) noexcept;
+        Input& operator=(Input&&) noexcept;
+        ~Input();
+
+        // whether the contents are memory-mapped rather than streamed
+        bool mapped() const;
+
+        // reads the next chunk of whole lines of roughly `size` bytes, or more if a single line is longer. the
+        // last line of the input need not end with a newline. a streamed chunk is stored in `storage`, which
+        // the returned view then refers to. returns nothing at the end of the input
+        std::optional<std::string_view> read(std::string& storage, std::size_t size);
+
+        // reads the rest of the input at once, e.g. for binary contents which are not split into lines. mapped
+        // contents are viewed in place, and streamed contents are stored in `storage`
+        std::string_view read_all(std::string& storage);
+
+    private:
+        Input() = default;
+
+        void release();
+
+        // mapped contents and how much of it has been read
+        void* _mapping = nullptr;
+        std::size_t _size = 0;
+        std::size_t _offset = 0;
+
+        // streamed contents, and the start of a line carried over from the previous chunk
+        int _fd = -1;
+        bool _owned = false;
+        std::string _carry;
+    };
+}
@@ -0,0 +1,51 @@
+#include "output.h"
+#include "error.h"
+
+#include <cstring>
+#include <utility>
+using namespace io;
+
+Output::Output(std::FILE* file, std::size_t capacity) : _file(file), _buffer(capacity) {}
+
+Output::~Output()
+{
+    try
+    {
+        flush();
+    }
+    catch (const Error&) {}
+}
+
+void Output::write(std::string_view str)
+{
+    if (str.size() > _buffer.size() - _size)
+    {
+        flush();
+
+        // too large to be worth buffering
+        if (str.size() >= _buffer.size())
+        {
+            if (std::fwrite(str.data(), 1, str.size(), _file) != str.size())
+                throw Error("cannot write output");
+            return;
+        }
+    }
+    std::memcpy(_buffer.data() + _size, str.data(), str.size());
+    _size += str.size();
+}
+
+void Output::put(char c)
+{
+    if (_size == _buffer.size())
+        flush();
+    _buffer[_size++] = c;
+}
+
+void Output::flush()
+{
+    const std::size_t size = std::exchange(_size, 0);
+
+    if (size && std::fwrite(_buffer.data(), 1, size, _file) != size)
+        throw Error("cannot write output");
+    std::fflush(_file);
+}
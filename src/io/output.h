@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+namespace io
+{
+    // accumulates output in one large buffer, which is written to the file with a single call once full
+    struct Output
+    {
+        explicit Output(std::FILE* file, std::size_t capacity = std::size_t(1) << 20);
+        ~Output();
+
+        Output(const Output&) = delete;
+        Output& operator=(const Output&) = delete;
+
+        void write(std::string_view str);
+        void put(char c);
+
+        // writes the buffered output to the file
+        void flush();
+
+    private:
+        std::FILE* _file;
+        std::vector<char> _buffer;
+        std::size_t _size = 0;
+    };
+}
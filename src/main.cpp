@@ -1,32 +1,228 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <iterator>
+#include <optional>
+#include <string_view>
+#include <thread>
 #include <utility>
 #include <variant>
 
+#include "ast/binary.h"
+#include "cli/batch.h"
+#include "cli/convert.h"
+#include "cli/rules.h"
+#include "cli/stats.h"
+#include "io/input.h"
+#include "io/output.h"
 #include "parser/parser.h"
 #include "engine/engine.h"
+#include "engine/source.h"
 
-int main()
+namespace impl
 {
-    std::string input;
+    constexpr const char* USAGE =
+        "usage: biss [--rules <file> [--rules-cache <file>] [--saturate]]\n"
+        "                                            evaluate expressions interactively\n"
+        "       biss --batch <file> [--threads <n>] [--cache <n>] [--rules <file> [--rules-cache <file>] [--saturate]]\n"
+        "                                            evaluate each line of a file, or of stdin if the file is '-',\n"
+        "                                            using n threads (default: all cores), memoizing the results of\n"
+        "                                            up to n inputs and of up to n subexpressions (default: 0)\n"
+        "       biss --encode <file>                 parse each line of a file and write the expressions to stdout\n"
+        "                                            in binary\n"
+        "       biss --decode <file>                 write each expression of a binary file to stdout as text\n"
+        "\n"
+        "       --rules <file>                       rewrite expressions with the rules of a file, one per line,\n"
+        "                                            like `1 * $0 -> $0`\n"
+        "       --rules-cache <file>                 keep the compiled rules in a snapshot at the given path,\n"
+        "                                            which later runs load in place while the rules are unchanged\n"
+        "       --saturate                           apply the rules by equality saturation, extracting the\n"
+        "                                            smallest expression found\n"
+        "       --stats <text|json>                  write the time spent in each phase, and how often each rule\n"
+        "                                            was attempted and applied, along with the hits and misses of\n"
+        "                                            the cache, to stderr once done. heap allocations are\n"
+        "                                            included when built with BISS_COUNT_ALLOCATIONS\n";
 
-    while (true)
+    enum struct Mode
     {
-        std::cout << "> ";
-        std::getline(std::cin, input);
+        BATCH,
+        ENCODE,
+        DECODE,
+    };
 
-        const std::string out = [&]()
+    // parses a non-negative count given as the value of an option
+    static bool parse_count(std::string_view value, std::size_t& out)
+    {
+        const char* end = value.data() + value.size();
+        const auto [ptr, ec] = std::from_chars(value.data(), end, out);
+        return ec == std::errc() && ptr == end;
+    }
+
+    // loads a rule file, reporting errors to stderr
+    static std::optional<cli::RuleFile> load_rules(const std::string& path, const std::optional<std::string>& cache)
+    {
+        try
+        {
+            return cli::RuleFile::load(path, cache);
+        }
+        catch (const io::Error& e)
+        {
+            std::fprintf(stderr, "biss: %s\n", e.what());
+        }
+        catch (const engine::rule::SourceError& e)
         {
-            try
+            std::fprintf(stderr, "biss: %s:%zu:%zu: %s\n", path.c_str(), e.line, e.column + 1, e.what());
+        }
+        return std::nullopt;
+    }
+
+    static int interactive()
+    {
+        std::string input;
+
+        while (true)
+        {
+            std::cout << "> ";
+
+            if (!std::getline(std::cin, input))
+                return 0;
+
+            const std::string out = [&]()
             {
-                return engine::evaluate_str(input).to_string();
-            }
-            catch (const parser::Error& e)
+                try
+                {
+                    return engine::evaluate_str(input).to_string();
+                }
+                catch (const parser::Error& e)
+                {
+                    const std::string column_indicator = std::string(e.column, ' ');
+                    return std::format("{}  ^ {}", column_indicator, e.what());
+                }
+            }();
+            std::cout << out << '\n';
+        }
+    }
+
+    static int run(Mode mode, const std::string& path, const cli::Options& options)
+    {
+        try
+        {
+            io::Input input = io::Input::open(path);
+            io::Output out(stdout);
+            std::size_t failed = 0;
+
+            switch (mode)
             {
-                const std::string column_indicator = std::string(e.column, ' ');
-                return std::format("{}  ^ {}", column_indicator, e.what());
+            case Mode::BATCH:
+                failed = cli::batch(input, out, options);
+                break;
+            case Mode::ENCODE:
+                failed = cli::encode(input, out);
+                break;
+            case Mode::DECODE:
+                cli::decode(input, out);
+                break;
             }
-        }();
-        std::cout << out << '\n';
+            out.flush();
+            return failed ? 1 : 0;
+        }
+        catch (const io::Error& e)
+        {
+            std::fprintf(stderr, "biss: %s\n", e.what());
+            return 2;
+        }
+        catch (const ast::binary::Error& e)
+        {
+            std::fprintf(stderr, "biss: %s: %s\n", path.c_str(), e.what());
+            return 2;
+        }
     }
 }
+
+int main(int argc, char** argv)
+{
+    std::optional<std::string> path;
+    std::optional<std::string> rules_path;
+    std::optional<std::string> rules_cache;
+    engine::RuleOptions rule_options;
+    std::optional<cli::StatsFormat> stats_format;
+    impl::Mode mode = impl::Mode::BATCH;
+    cli::Options options;
+    options.threads = std::max(std::thread::hardware_concurrency(), 1u);
+    bool valid = true;
+
+    for (int i = 1; valid && i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if ((arg == "--batch" || arg == "--encode" || arg == "--decode") && has_value && !path)
+        {
+            mode = arg == "--batch" ? impl::Mode::BATCH : arg == "--encode" ? impl::Mode::ENCODE : impl::Mode::DECODE;
+            path = argv[++i];
+        }
+        else if (arg == "--rules" && has_value && !rules_path)
+        {
+            rules_path = argv[++i];
+        }
+        else if (arg == "--rules-cache" && has_value && !rules_cache)
+        {
+            rules_cache = argv[++i];
+        }
+        else if (arg == "--stats" && has_value && !stats_format)
+        {
+            const std::string_view format = argv[++i];
+            valid = format == "text" || format == "json";
+            stats_format = format == "json" ? cli::StatsFormat::JSON : cli::StatsFormat::TEXT;
+        }
+        else if (arg == "--saturate")
+        {
+            rule_options.strategy = engine::Strategy::SATURATE;
+        }
+        else if (arg == "--threads" && has_value)
+        {
+            valid = impl::parse_count(argv[++i], options.threads) && options.threads > 0;
+        }
+        else if (arg == "--cache" && has_value)
+        {
+            std::size_t capacity = 0;
+            valid = impl::parse_count(argv[++i], capacity);
+            engine::configure_cache({ .strings = capacity, .subtrees = capacity });
+        }
+        else
+        {
+            valid = false;
+        }
+    }
+
+    // the options of a batch are meaningless without one
+    const bool saturate = rule_options.strategy == engine::Strategy::SATURATE;
+    const bool interactive = !path && argc == 1 + (rules_path ? 2 : 0) + (rules_cache ? 2 : 0) + saturate + (stats_format ? 2 : 0);
+
+    if (!valid || (!path && !interactive) || ((saturate || rules_cache) && !rules_path))
+    {
+        std::fputs(impl::USAGE, stderr);
+        return 2;
+    }
+
+    // the rules are referred to by the engine until it exits
+    std::optional<cli::RuleFile> rules;
+
+    if (rules_path)
+    {
+        if (!(rules = impl::load_rules(*rules_path, rules_cache)))
+            return 2;
+        engine::configure_rules(&rules->view(), rule_options);
+    }
+
+    if (stats_format)
+        engine::stats::enable(true);
+
+    const int status = path ? impl::run(mode, *path, options) : impl::interactive();
+
+    if (stats_format)
+        cli::write_stats(stderr, engine::stats::read(), engine::cache_stats(), *stats_format, rules ? rules->sources() : std::span<const std::string>{});
+    return status;
+}
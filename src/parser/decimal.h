@@ -0,0 +1,273 @@
+#pragma once
+#include <bit>
+#include <compare>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// conversion of decimal literals to the nearest double during constant evaluation, where `std::from_chars`
+// isn't usable. rounds the way `std::from_chars` does at runtime, such that compile-time evaluators give the
+// same results as the ones parsed at runtime
+namespace parser::decimal
+{
+    // unsigned integer of arbitrary size, as 32-bit limbs in little-endian order without leading zero limbs
+    struct Big
+    {
+        std::vector<std::uint32_t> limbs;
+
+        constexpr bool zero() const
+        {
+            return limbs.empty();
+        }
+
+        constexpr std::size_t bit_width() const
+        {
+            return zero() ? 0 : 32 * (limbs.size() - 1) + static_cast<std::size_t>(std::bit_width(limbs.back()));
+        }
+
+        constexpr bool bit(std::size_t i) const
+        {
+            return i / 32 < limbs.size() && (limbs[i / 32] >> (i % 32) & 1);
+        }
+
+        // whether any of the bits below `i` is set
+        constexpr bool any_below(std::size_t i) const
+        {
+            for (std::size_t j = 0; j < limbs.size() && 32 * j < i; j++)
+            {
+                const std::uint32_t mask = i - 32 * j >= 32 ? ~0u : (1u << (i - 32 * j)) - 1;
+
+                if (limbs[j] & mask)
+                    return true;
+            }
+            return false;
+        }
+
+        // the 64 bits starting at bit `i`
+        constexpr std::uint64_t bits_from(std::size_t i) const
+        {
+            std::uint64_t out = 0;
+
+            for (std::size_t j = 0; j < 64; j++)
+                out |= static_cast<std::uint64_t>(bit(i + j)) << j;
+            return out;
+        }
+
+        constexpr void multiply_add(std::uint32_t factor, std::uint32_t addend)
+        {
+            std::uint64_t carry = addend;
+
+            for (std::uint32_t& limb : limbs)
+            {
+                const std::uint64_t next = static_cast<std::uint64_t>(limb) * factor + carry;
+                limb = static_cast<std::uint32_t>(next);
+                carry = next >> 32;
+            }
+            if (carry)
+                limbs.push_back(static_cast<std::uint32_t>(carry));
+        }
+
+        constexpr void shift_left(std::size_t n)
+        {
+            if (zero())
+                return;
+
+            limbs.insert(limbs.begin(), n / 32, 0);
+
+            if (const std::size_t bits = n % 32)
+            {
+                std::uint32_t carry = 0;
+
+                for (std::uint32_t& limb : limbs)
+                {
+                    const std::uint32_t next = limb >> (32 - bits);
+                    limb = limb << bits | carry;
+                    carry = next;
+                }
+                if (carry)
+                    limbs.push_back(carry);
+            }
+        }
+
+        constexpr auto operator<=>(const Big& other) const
+        {
+            if (limbs.size() != other.limbs.size())
+                return limbs.size() <=> other.limbs.size();
+
+            for (std::size_t i = limbs.size(); i-- > 0;)
+            {
+                if (limbs[i] != other.limbs[i])
+                    return limbs[i] <=> other.limbs[i];
+            }
+            return std::strong_ordering::equal;
+        }
+
+        constexpr bool operator==(const Big&) const = default;
+
+        // subtracts a value no greater than this one
+        constexpr void subtract(const Big& other)
+        {
+            std::int64_t borrow = 0;
+
+            for (std::size_t i = 0; i < limbs.size(); i++)
+            {
+                std::int64_t next = static_cast<std::int64_t>(limbs[i]) - borrow - (i < other.limbs.size() ? other.limbs[i] : 0);
+                borrow = next < 0;
+                limbs[i] = static_cast<std::uint32_t>(next + (borrow << 32));
+            }
+            while (!limbs.empty() && !limbs.back())
+                limbs.pop_back();
+        }
+    };
+
+    // `value * 2^exponent`, rounded to the nearest double with ties to even. `sticky` is set if the exact value
+    // is slightly larger than that, by less than `2^exponent`
+    constexpr double round(std::uint64_t value, int exponent, bool sticky)
+    {
+        if (!value)
+            return 0.0;
+
+        // the exponent of the leading bit decides the precision; 53 bits for normal doubles, fewer below
+        const int width = std::bit_width(value);
+        const int leading = width - 1 + exponent;
+        const int precision = leading >= -1022 ? 53 : 53 - (-1022 - leading);
+        const int shift = width - precision;
+
+        std::uint64_t mantissa = value;
+
+        if (shift > 0)
+        {
+            mantissa = shift >= 64 ? 0 : value >> shift;
+            const bool half = shift <= 64 && (value >> (shift - 1) & 1);
+            const bool below = shift >= 64 ? value != (half ? 1ull << 63 : 0) : (value & ((1ull << (shift - 1)) - 1)) != 0;
+
+            if (half && (below || sticky || (mantissa & 1)))
+                mantissa++;
+            exponent += shift;
+        }
+        else
+        {
+            mantissa <<= -shift;
+            exponent += shift;
+        }
+
+        // exact, since the mantissa fits in 53 bits and the result is a multiple of the smallest subnormal
+        double out = static_cast<double>(mantissa);
+
+        for (; exponent > 0; exponent--)
+            out *= 2.0;
+        for (; exponent < 0; exponent++)
+            out *= 0.5;
+        return out;
+    }
+
+    // like `std::from_chars`, rejects a literal too large for a double, or too small to round to anything but zero
+    constexpr std::optional<double> finite(double value)
+    {
+        if (value == 0.0 || value == std::numeric_limits<double>::infinity())
+            return std::nullopt;
+        return value;
+    }
+
+    // parses a run of digits with at most one decimal point, like `std::chars_format::fixed`
+    constexpr std::optional<double> parse(std::string_view segment)
+    {
+        // the literal is `digits * 10^exponent`, where digits are read without leading zeros
+        Big digits;
+        std::size_t count = 0;
+        long exponent = 0;
+        bool fraction = false;
+
+        for (const char c : segment)
+        {
+            if (c == '.')
+            {
+                if (fraction)
+                    return std::nullopt;
+                fraction = true;
+                continue;
+            }
+            digits.multiply_add(10, static_cast<std::uint32_t>(c - '0'));
+            exponent -= fraction;
+            count++;
+        }
+
+        if (!count)
+            return std::nullopt;
+        if (digits.zero())
+            return 0.0;
+
+        // small integers and powers of ten are exact, so a single operation rounds correctly
+        constexpr double POWERS[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+        if (digits.bit_width() <= 53 && exponent >= -22)
+        {
+            const double mantissa = static_cast<double>(digits.bits_from(0));
+            return exponent < 0 ? mantissa / POWERS[-exponent] : mantissa;
+        }
+
+        // otherwise the quotient of the digits and the power of ten is computed to 64 significant bits, and
+        // whether anything remains decides the rounding of ties
+        if (exponent >= 0)
+        {
+            const std::size_t width = digits.bit_width();
+            const std::size_t low = width > 64 ? width - 64 : 0;
+            return finite(round(digits.bits_from(low), static_cast<int>(low), digits.any_below(low)));
+        }
+
+        Big power{ { 1 } };
+
+        for (long i = 0; i < -exponent; i++)
+            power.multiply_add(10, 0);
+
+        // scales the digits such that the quotient has 63 or 64 bits
+        const long scale = static_cast<long>(power.bit_width()) - static_cast<long>(digits.bit_width()) + 63;
+        bool sticky = false;
+
+        if (scale >= 0)
+        {
+            digits.shift_left(static_cast<std::size_t>(scale));
+        }
+        else
+        {
+            // dropped bits are only needed to break ties
+            const auto dropped = static_cast<std::size_t>(-scale);
+            sticky = digits.any_below(dropped);
+            Big shifted;
+
+            for (std::size_t i = dropped; i < digits.bit_width(); i += 32)
+                shifted.limbs.push_back(static_cast<std::uint32_t>(digits.bits_from(i)));
+            while (!shifted.limbs.empty() && !shifted.limbs.back())
+                shifted.limbs.pop_back();
+            digits = shifted;
+        }
+
+        // long division, one bit of the quotient at a time
+        Big remainder;
+        std::uint64_t quotient = 0;
+
+        for (std::size_t i = digits.bit_width(); i-- > 0;)
+        {
+            remainder.shift_left(1);
+
+            if (digits.bit(i))
+            {
+                if (remainder.zero())
+                    remainder.limbs.push_back(1);
+                else
+                    remainder.limbs[0] |= 1;
+            }
+
+            quotient <<= 1;
+
+            if (remainder >= power)
+            {
+                remainder.subtract(power);
+                quotient |= 1;
+            }
+        }
+        return finite(round(quotient, static_cast<int>(-scale), sticky || !remainder.zero()));
+    }
+}
@@ -0,0 +1,343 @@
+#pragma once
+#include "parser/lexer.h"
+#include "parser/parser.h"
+#include "ast/function.h"
+
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// the expression grammar, independent of what is built from it. `parser::parse` builds an `ast::Ast`, while
+// `eval::expr` builds a flat tree during constant evaluation. errors call a non-constexpr function, so a
+// syntax error in an expression parsed during constant evaluation is reported as a compile error
+namespace parser::grammar
+{
+    // the builder provides a `Node` type and the following:
+    //
+    //   Node literal(double value)
+    //   Node variable(std::string_view identifier)
+    //   Node call(const Function* fn, std::vector<Node> args)
+    //
+    // and optionally, to accept placeholders like `$0` as operands, e.g. in rules (see `engine::rule::parse`):
+    //
+    //   static constexpr std::string_view SIGILS     chars which may start a placeholder
+    //   Node placeholder(char sigil, std::uint8_t index)
+    //
+    // the parser keeps the operators and brackets it has yet to close on an explicit stack rather than
+    // recursing per level of nesting, so that arbitrarily deep inputs are parsed in linear time without
+    // exhausting the native stack. `max_depth` limits the size of that stack instead
+    template<class Builder>
+    struct Parser
+    {
+        using Node = typename Builder::Node;
+        using Function = ast::function::Function;
+
+        Lexer& lexer;
+        Builder& builder;
+        std::size_t max_depth = MAX_DEPTH;
+
+        // root of the parsing algorithm. based on the shunting yard algorithm:
+        // https://en.wikipedia.org/wiki/Shunting_yard_algorithm
+        //
+        // an operand is a literal, a variable, a parenthesized expression or a routine function call. operands
+        // may be preceded by unary operators, and may be juxtaposed to multiply them, e.g. `2(1 + 2)` and `5x`.
+        // both bind tighter than any infix operator, and juxtaposition binds tighter than unary operators
+        constexpr Node parse_expression()
+        {
+            State state;
+            auto& [operands, pending, depth] = state;
+            bool expect_operand = true;
+
+            while (true)
+            {
+                if (expect_operand)
+                {
+                    expect_operand = parse_operand(state);
+                    continue;
+                }
+
+                // an operand has just been completed
+                const Token& next = lexer.peek();
+
+                if (next.has<std::string_view>() || next.has<double>() || next.has('('))
+                {
+                    open(state, { .kind = Kind::JUXTAPOSITION });
+                    expect_operand = true;
+                    continue;
+                }
+                reduce_prefixes(state);
+
+                if (const Function* fn = peek_function(2))
+                {
+                    lexer.discard(); // op identifier
+                    reduce_infixes(state, fn);
+                    open(state, { .kind = Kind::INFIX, .fn = fn });
+                    expect_operand = true;
+                    continue;
+                }
+                reduce_infixes(state, nullptr);
+
+                // the expression ends unless a bracket is left open
+                if (pending.empty())
+                    break;
+
+                if (pending.back().kind == Kind::PARENTHESIS)
+                {
+                    if (!lexer.read().has(')'))
+                        error("expected ')'");
+                    close(state);
+                }
+                else if (lexer.peek().has(')'))
+                {
+                    lexer.discard(); // ')'
+                    close_routine(state);
+                }
+                else if (lexer.read().has(','))
+                {
+                    expect_operand = true;
+                }
+                else
+                {
+                    error("expected ',' or ')'");
+                }
+            }
+            return std::move(operands.back());
+        }
+
+        // parses a whole input, which may not have any trailing tokens
+        constexpr Node parse_input()
+        {
+            Node expr = parse_expression();
+
+            if (const Token trailing = lexer.read(); !trailing.has<EOL>())
+                error("unexpected '{}'", trailing);
+            return expr;
+        }
+
+    private:
+        enum struct Kind : std::uint8_t
+        {
+            // infix operator awaiting its right-hand side
+            INFIX,
+            // unary operator awaiting its operand
+            UNARY,
+            // multiplication implied by two adjacent operands, awaiting the right one
+            JUXTAPOSITION,
+            // parenthesized expression awaiting its ')'
+            PARENTHESIS,
+            // routine function call awaiting its arguments. these are the operands from `first` onwards
+            ROUTINE,
+        };
+
+        struct Pending
+        {
+            Kind kind;
+            const Function* fn = nullptr;
+            Identifier routine = {};
+            std::size_t first = 0;
+        };
+
+        // utility for throwing a syntax error at the column where the previous token started
+        template<class... Args>
+        [[noreturn]]
+        void error(std::format_string<Args&...> fmt, Args&&... args)
+        {
+            throw Error(lexer.last_token_start(), std::format(fmt, args...));
+        }
+
+        // attempts to parse the next token as a function identifier, and returns the function object
+        constexpr const Function* peek_function(std::uint8_t arity) const
+        {
+            const Token& token = lexer.peek();
+
+            if (token.has<Identifier>())
+                return token.get<Identifier>().overloads->get(arity);
+            return nullptr;
+        }
+
+        // the operands and operators of the expression being parsed
+        struct State
+        {
+            std::vector<Node> operands;
+            std::vector<Pending> pending;
+
+            // number of brackets and unary operators pending, which is the level of nesting in the input.
+            // infix operators and juxtapositions are pending as well, but are not nested in the input
+            std::size_t depth = 0;
+        };
+
+        static constexpr bool nests(Kind kind)
+        {
+            return kind == Kind::UNARY || kind == Kind::PARENTHESIS || kind == Kind::ROUTINE;
+        }
+
+        constexpr void open(State& state, Pending entry)
+        {
+            if (nests(entry.kind) && ++state.depth > max_depth)
+                error("expression is nested deeper than {} levels", max_depth);
+            state.pending.push_back(entry);
+        }
+
+        constexpr void close(State& state)
+        {
+            state.depth -= nests(state.pending.back().kind);
+            state.pending.pop_back();
+        }
+
+        // consumes the tokens preceding an operand up to and including the operand itself. returns whether
+        // another operand is expected, which is the case after unary operators and opening brackets
+        constexpr bool parse_operand(State& state)
+        {
+            std::vector<Node>& operands = state.operands;
+            const Token token = lexer.read();
+
+            if (token.has<EOL>())
+                error("expected an expression");
+
+            if (token.has('(')) // parse nested expression
+            {
+                open(state, { .kind = Kind::PARENTHESIS });
+                return true;
+            }
+            else if (token.has<std::string_view>()) // parse variable
+            {
+                operands.push_back(builder.variable(token.get<std::string_view>()));
+                return false;
+            }
+            else if (token.has<Identifier>()) // parse unary / routine function call
+            {
+                const Identifier identifier = token.get<Identifier>();
+
+                if (lexer.peek().has('('))
+                {
+                    lexer.discard(); // '('
+                    open(state, { .kind = Kind::ROUTINE, .routine = identifier, .first = operands.size() });
+
+                    if (!lexer.peek().has(')'))
+                        return true;
+
+                    lexer.discard(); // ')'
+                    close_routine(state);
+                    return false;
+                }
+                else
+                {
+                    const Function* fn = identifier.overloads->get(1);
+
+                    if (!fn)
+                        error("function is not a unary operator '{}'", identifier.value);
+                    open(state, { .kind = Kind::UNARY, .fn = fn });
+                    return true;
+                }
+            }
+            else if (token.has<double>()) // parse literal
+            {
+                operands.push_back(builder.literal(token.get<double>()));
+                return false;
+            }
+            else if (placeholder(token, operands)) // parse placeholder
+            {
+                return false;
+            }
+            else // invalid token
+            {
+                error("invalid token '{}'", token);
+            }
+        }
+
+        // parses a placeholder, which is a sigil followed by its index, if the builder accepts them. returns
+        // whether the token began one
+        constexpr bool placeholder(const Token& sigil, std::vector<Node>& operands)
+        {
+            if constexpr (requires { builder.placeholder(char{}, std::uint8_t{}); })
+            {
+                if (!sigil.has<char>() || Builder::SIGILS.find(sigil.get<char>()) == std::string_view::npos)
+                    return false;
+
+                const Token index = lexer.read();
+                const bool valid = index.has<double>()
+                    && index.get<double>() <= 255.0
+                    && index.get<double>() == static_cast<double>(static_cast<std::uint8_t>(index.get<double>()));
+
+                if (!valid)
+                    error("expected an index from 0 to 255 after '{}'", sigil);
+                operands.push_back(builder.placeholder(sigil.get<char>(), static_cast<std::uint8_t>(index.get<double>())));
+                return true;
+            }
+            return false;
+        }
+
+        constexpr void call(std::vector<Node>& operands, const Function* fn, std::size_t arity)
+        {
+            std::vector<Node> args;
+            args.reserve(arity);
+
+            const auto first = operands.end() - static_cast<std::ptrdiff_t>(arity);
+            args.insert(args.end(), std::make_move_iterator(first), std::make_move_iterator(operands.end()));
+            operands.erase(first, operands.end());
+            operands.push_back(builder.call(fn, std::move(args)));
+        }
+
+        // applies the unary operators and juxtapositions preceding the operand just completed
+        constexpr void reduce_prefixes(State& state)
+        {
+            auto& [operands, pending, depth] = state;
+            constexpr const Function* MULTIPLICATION = ast::function::get("*", 2);
+
+            while (!pending.empty())
+            {
+                const Pending top = pending.back();
+
+                if (top.kind == Kind::UNARY)
+                    call(operands, top.fn, 1);
+                else if (top.kind == Kind::JUXTAPOSITION)
+                    call(operands, MULTIPLICATION, 2);
+                else
+                    break;
+                close(state);
+            }
+        }
+
+        // applies the infix operators binding at least as tightly as `next`, the operator about to be pushed,
+        // or all of them down to the innermost open bracket if `next` is null
+        constexpr void reduce_infixes(State& state, const Function* next)
+        {
+            auto& [operands, pending, depth] = state;
+            while (!pending.empty() && pending.back().kind == Kind::INFIX)
+            {
+                const Function* fn = pending.back().fn;
+                const bool binds_tighter = !next ||
+                     fn->precedence  > next->precedence ||
+                    (fn->precedence == next->precedence && fn->associativity != ast::function::Associativity::RIGHT);
+
+                if (!binds_tighter)
+                    break;
+                call(operands, fn, 2);
+                close(state);
+            }
+        }
+
+        // completes the routine function call on top of the stack, after its ')' has been consumed
+        constexpr void close_routine(State& state)
+        {
+            const Pending routine = state.pending.back();
+            close(state);
+
+            const std::size_t arity = state.operands.size() - routine.first;
+            const Function* fn = routine.routine.overloads->get(arity);
+
+            if (!fn)
+                error("no overload found for '{}' taking {} arguments", routine.routine.value, arity);
+            call(state.operands, fn, arity);
+        }
+    };
+
+    template<class Builder>
+    Parser(Lexer&, Builder&) -> Parser<Builder>;
+
+    template<class Builder>
+    Parser(Lexer&, Builder&, std::size_t) -> Parser<Builder>;
+}
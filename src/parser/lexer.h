@@ -1,18 +1,25 @@
 #pragma once
+#include "parser/decimal.h"
+#include "parser/parser.h"
+#include "ast/function.h"
 #include "utility.h"
 
-#include <string_view>
-#include <vector>
-#include <unordered_set>
+#include <array>
+#include <charconv>
+#include <cstdint>
 #include <format>
+#include <optional>
+#include <string_view>
+#include <type_traits>
 
 namespace parser
 {
-    // token containing a function identifier. doesn't store a reference to the function object itself since
-    // that would require knowing the arity.
+    // token containing a function identifier. refers to all functions with the identifier rather than a
+    // single function object, since which one is meant depends on the arity, which is only known to the parser
     struct Identifier
     {
         std::string_view value;
+        const ast::function::Overloads* overloads;
     };
 
     // signals the end of the token stream
@@ -35,28 +42,170 @@ namespace parser
             );
         }
     };
-    
-    // tokenizes input string
+
+    // tokenizes an input string in a single pass, one token at a time as the parser consumes them. tokens
+    // refer to the input rather than copying it, so nothing is allocated. usable during constant evaluation,
+    // see `eval::expr`
     struct Lexer
     {
-        Lexer(std::string_view str, const std::unordered_set<std::string_view>& fn_identifiers);
+        constexpr explicit Lexer(std::string_view str) : _str(str)
+        {
+            advance();
+        }
 
-        // retrieves a token from the buffer without consuming it
-        const Token& peek() const;
-        
-        // consumes a token from the buffer
-        const Token& read();
+        // retrieves the next token without consuming it
+        constexpr const Token& peek() const
+        {
+            return _token;
+        }
 
-        // discards a token from the buffer
-        void discard();
+        // consumes the next token
+        constexpr Token read()
+        {
+            Token out = _token;
+            discard();
+            return out;
+        }
+
+        // discards the next token. the end of the input is never discarded
+        constexpr void discard()
+        {
+            if (_token.has<EOL>())
+                return;
+            _previous = _start;
+            advance();
+        }
 
         // returns the column of start of the previous token, used for error reporting
-        std::size_t last_token_start() const;
+        constexpr std::size_t last_token_start() const
+        {
+            return _previous;
+        }
 
     private:
-        std::vector<Token> _tokens;
-        std::vector<std::size_t> _offsets;
-        std::size_t _cursor;
+        // tokens are formed by runs of characters of the same category
+        enum struct Category : std::uint8_t
+        {
+            ALPHA,
+            DIGIT,
+            SYMBOL,
+            WHITESPACE,
+        };
+
+        // classification of every char independent of the locale
+        static constexpr std::array<Category, 256> CATEGORIES = []()
+        {
+            using enum Category;
+            std::array<Category, 256> out;
+
+            for (std::size_t i = 0; i < out.size(); i++)
+            {
+                const char c = static_cast<char>(i);
+
+                if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+                    out[i] = ALPHA;
+                else if ((c >= '0' && c <= '9') || c == '.')
+                    out[i] = DIGIT;
+                else if (c == ' ' || (c >= '\t' && c <= '\r'))
+                    out[i] = WHITESPACE;
+                else
+                    out[i] = SYMBOL;
+            }
+            return out;
+        }();
+
+        std::string_view _str;
+        std::size_t _cursor = 0;
+        std::size_t _start = 0;
+        std::size_t _previous = 0;
+        Token _token = EOL{};
+
+        static constexpr Category categorize(char c)
+        {
+            return CATEGORIES[static_cast<unsigned char>(c)];
+        }
+
+        // `std::from_chars` isn't usable during constant evaluation, where `decimal::parse` rounds the same way
+        static constexpr std::optional<double> parse_number(std::string_view segment)
+        {
+            if (std::is_constant_evaluated())
+                return decimal::parse(segment);
+
+            double value = 0.0;
+            const char* end = segment.data() + segment.size();
+            const auto [ptr, ec] = std::from_chars(segment.data(), end, value, std::chars_format::fixed);
+
+            if (ec != std::errc() || ptr != end)
+                return std::nullopt;
+            return value;
+        }
+
+        // length of the run of characters starting at the cursor sharing its category, up to `limit`
+        constexpr std::size_t run(Category category, std::size_t limit = SIZE_MAX) const
+        {
+            const std::size_t last = _str.size() - _cursor > limit ? _cursor + limit : _str.size();
+            std::size_t end = _cursor + 1;
+
+            while (end < last && categorize(_str[end]) == category)
+                end++;
+            return end - _cursor;
+        }
+
+        constexpr void advance()
+        {
+            using enum Category;
+
+            while (_cursor < _str.size() && categorize(_str[_cursor]) == WHITESPACE)
+                _cursor++;
+            _start = _cursor;
+
+            if (_cursor == _str.size())
+            {
+                _token = EOL{};
+                return;
+            }
+
+            // runs of symbols are split into operators of at most `MAX_OPERATOR_LENGTH` chars below, so they are
+            // not scanned any further. otherwise, a run like `((((...` would be rescanned for every token in it
+            const Category category = categorize(_str[_cursor]);
+            const std::size_t limit = category == SYMBOL ? ast::function::MAX_OPERATOR_LENGTH : SIZE_MAX;
+            std::string_view segment = _str.substr(_cursor, run(category, limit));
+
+            switch (category)
+            {
+            case ALPHA:
+            {
+                const ast::function::Overloads* overloads = ast::function::find(segment);
+                _token = overloads ? Token{ Identifier{ segment, overloads } } : Token{ segment };
+                break;
+            }
+            case DIGIT:
+            {
+                const std::optional<double> value = parse_number(segment);
+
+                if (!value)
+                    throw Error(_start, std::format("invalid number '{}'", segment));
+                _token = *value;
+                break;
+            }
+            default:
+            {
+                // add each char seperately unless it forms part of a function identifier, such that e.g. "+==="
+                // is parsed as { "+", "==", "=" } provided "==" appears in the list of function identifiers. no
+                // identifier is longer than `MAX_OPERATOR_LENGTH`, so longer prefixes need not be looked up
+                const ast::function::Overloads* overloads = ast::function::find(segment);
+
+                while (!overloads && segment.size() > 1)
+                {
+                    segment.remove_suffix(1);
+                    overloads = ast::function::find(segment);
+                }
+                _token = overloads ? Token{ Identifier{ segment, overloads } } : Token{ segment[0] };
+                break;
+            }
+            }
+            _cursor += segment.size();
+        }
     };
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "ast/ast.h"
 
+#include <cstddef>
 #include <stdexcept>
 #include <string_view>
 
@@ -17,6 +18,10 @@ namespace parser
         Error(std::size_t column, std::string msg) : std::runtime_error(msg.data()), column(column), msg(std::move(msg)) {}
     };
 
+    // default limit on the nesting depth of an input, counting brackets and operators left open at once.
+    // deeper inputs are rejected with an error, see `grammar::Parser`
+    constexpr std::size_t MAX_DEPTH = std::size_t(1) << 20;
+
     // parses input string as an expression
-    ast::Ast parse(std::string_view input);
+    ast::Ast parse(std::string_view input, std::size_t max_depth = MAX_DEPTH);
 }
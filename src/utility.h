@@ -1,6 +1,10 @@
 #pragma once
 #include <variant>
 #include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <string_view>
 
 // utility to combine several callable types
 template<class... Overloads>
@@ -73,3 +77,35 @@ constexpr bool double_equality(double a, double b)
     constexpr double EPSILON = 1e-10; // arbitrarily chosen
     return std::abs(a - b) <= EPSILON * std::max(std::abs(a), std::abs(b));
 }
+
+// finalizer from splitmix64, scatters the bits of a 64-bit value
+// https://xoshiro.di.unimi.it/splitmix64.c
+constexpr std::uint64_t hash_mix(std::uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+// combines a hash with another value in an order-dependent manner
+constexpr std::uint64_t hash_combine(std::uint64_t seed, std::uint64_t value)
+{
+    return hash_mix(seed ^ (value + 0x9E3779B97F4A7C15 + (seed << 6) + (seed >> 2)));
+}
+
+// string literal usable as a template argument, e.g. `eval::expr<"2x + 1">`
+template<std::size_t N>
+struct FixedString
+{
+    char data[N];
+
+    constexpr FixedString(const char (&str)[N])
+    {
+        std::copy_n(str, N, data);
+    }
+
+    constexpr std::string_view view() const
+    {
+        return { data, N - 1 };
+    }
+};